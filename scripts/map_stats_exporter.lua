@@ -172,6 +172,9 @@ table.sort(sortedHouses, function(a, b)
 end)
 stats.houseIds = sortedHouses
 
+-- Counters the editor keeps for Map Statistics
+stats.editorStatistics = map.statistics
+
 -- Save to JSON
 local storage = app.storage(filename)
 local ok = storage:save(stats)
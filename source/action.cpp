@@ -23,6 +23,55 @@
 #include "editor.h"
 #include "gui.h"
 
+#include <unordered_set>
+
+namespace {
+	bool sameItem(const Item* a, const Item* b) {
+		return a && b && a->isEquivalent(*b);
+	}
+
+	// FNV-1a over the id and subtype of the items a delta borrows from the map tile
+	uint32_t hashSharedItems(const Tile* tile, bool ground, size_t front, size_t back) {
+		uint32_t hash = 2166136261u;
+		const auto add = [&hash](const Item* item) {
+			const uint32_t value = (static_cast<uint32_t>(item->getID()) << 16) | item->getSubtype();
+			for (int shift = 0; shift < 32; shift += 8) {
+				hash = (hash ^ ((value >> shift) & 0xFF)) * 16777619u;
+			}
+		};
+
+		if (ground) {
+			add(tile->ground);
+		}
+		for (size_t i = 0; i < front; ++i) {
+			add(tile->items[i]);
+		}
+		for (size_t i = tile->items.size() - back; i < tile->items.size(); ++i) {
+			add(tile->items[i]);
+		}
+		return hash;
+	}
+
+	// Selection changes are their own inverse, commit and undo both swap the recorded state with the map
+	void swapSelection(Map &map, Selection &selection, SelectionData* data) {
+		Tile* tile = map.getTile(data->position);
+		if (!tile) {
+			return;
+		}
+
+		std::vector<bool> previous = tile->getSelectionState();
+		tile->setSelectionState(data->state);
+		data->state.swap(previous);
+
+		if (tile->isSelected()) {
+			selection.addInternal(tile);
+		} else {
+			selection.removeInternal(tile);
+		}
+		map.addDamagedPosition(data->position);
+	}
+}
+
 Change::Change() :
 	type(CHANGE_NONE), data(nullptr) {
 	////
@@ -48,6 +97,13 @@ Change* Change::Create(Waypoint* waypoint, const Position &position) {
 	return change;
 }
 
+Change* Change::Create(const Tile* tile, std::vector<bool> &&state) {
+	Change* change = new Change();
+	change->type = CHANGE_SELECTION;
+	change->data = new SelectionData { tile->getPosition(), std::move(state) };
+	return change;
+}
+
 Change::~Change() {
 	clear();
 }
@@ -58,6 +114,11 @@ void Change::clear() {
 			ASSERT(data);
 			delete reinterpret_cast<Tile*>(data);
 			break;
+		case CHANGE_TILE_DELTA:
+			ASSERT(data);
+			delete reinterpret_cast<TileDelta*>(data)->tile;
+			delete reinterpret_cast<TileDelta*>(data);
+			break;
 		case CHANGE_MOVE_HOUSE_EXIT:
 			ASSERT(data);
 			delete reinterpret_cast<HouseData*>(data);
@@ -66,6 +127,10 @@ void Change::clear() {
 			ASSERT(data);
 			delete reinterpret_cast<WaypointData*>(data);
 			break;
+		case CHANGE_SELECTION:
+			ASSERT(data);
+			delete reinterpret_cast<SelectionData*>(data);
+			break;
 		case CHANGE_NONE:
 			break;
 		default:
@@ -85,12 +150,122 @@ uint32_t Change::memsize() const {
 	uint32_t mem = sizeof(*this);
 	if (type == CHANGE_TILE) {
 		mem += reinterpret_cast<Tile*>(data)->memsize();
+	} else if (type == CHANGE_TILE_DELTA) {
+		mem += sizeof(TileDelta) + reinterpret_cast<TileDelta*>(data)->tile->memsize();
+	} else if (type == CHANGE_SELECTION) {
+		mem += sizeof(SelectionData) + (reinterpret_cast<SelectionData*>(data)->state.capacity() + 7) / 8;
 	}
 	return mem;
 }
 
+uint32_t Change::fullsize() const {
+	if (type == CHANGE_TILE_DELTA) {
+		return sizeof(*this) + reinterpret_cast<TileDelta*>(data)->full_size;
+	}
+	return memsize();
+}
+
+bool Change::compact(const Tile* current) {
+	if (type != CHANGE_TILE || !current) {
+		return false;
+	}
+
+	Tile* tile = reinterpret_cast<Tile*>(data);
+	const bool shared_ground = sameItem(tile->ground, current->ground);
+	const size_t common = std::min(tile->items.size(), current->items.size());
+
+	size_t front = 0;
+	while (front < common && sameItem(tile->items[front], current->items[front])) {
+		++front;
+	}
+
+	size_t back = 0;
+	while (front + back < common && sameItem(tile->items[tile->items.size() - 1 - back], current->items[current->items.size() - 1 - back])) {
+		++back;
+	}
+
+	if (!shared_ground && front == 0 && back == 0) {
+		return false;
+	}
+
+	// The counts are stored in 16 bits; taller stacks keep the rest as recorded items
+	front = std::min<size_t>(front, UINT16_MAX);
+	back = std::min<size_t>(back, UINT16_MAX);
+
+	TileDelta* delta = new TileDelta();
+	delta->tile = tile;
+	delta->full_size = tile->memsize();
+	delta->shared_hash = hashSharedItems(current, shared_ground, front, back);
+	delta->shared_front = static_cast<uint16_t>(front);
+	delta->shared_back = static_cast<uint16_t>(back);
+	delta->shared_ground = shared_ground;
+
+	if (shared_ground) {
+		delete tile->ground;
+		tile->ground = nullptr;
+	}
+
+	ItemVector &items = tile->items;
+	for (size_t i = 0; i < front; ++i) {
+		delete items[i];
+	}
+	for (size_t i = items.size() - back; i < items.size(); ++i) {
+		delete items[i];
+	}
+	items.erase(items.end() - back, items.end());
+	items.erase(items.begin(), items.begin() + front);
+	items.shrink_to_fit();
+
+	type = CHANGE_TILE_DELTA;
+	data = delta;
+	return true;
+}
+
+void Change::expand(BaseMap &map) {
+	if (type != CHANGE_TILE_DELTA) {
+		return;
+	}
+
+	TileDelta* delta = reinterpret_cast<TileDelta*>(data);
+	Tile* tile = delta->tile;
+	const Tile* current = map.getTile(tile->getPosition());
+
+	const size_t front = delta->shared_front;
+	const size_t back = delta->shared_back;
+	const bool valid = current
+		&& current->items.size() >= front + back
+		&& (!delta->shared_ground || current->ground)
+		&& hashSharedItems(current, delta->shared_ground, front, back) == delta->shared_hash;
+
+	if (valid) {
+		if (delta->shared_ground) {
+			tile->ground = current->ground->deepCopy();
+		}
+
+		ItemVector items;
+		items.reserve(front + tile->items.size() + back);
+		for (size_t i = 0; i < front; ++i) {
+			items.push_back(current->items[i]->deepCopy());
+		}
+		items.insert(items.end(), tile->items.begin(), tile->items.end());
+		for (size_t i = current->items.size() - back; i < current->items.size(); ++i) {
+			items.push_back(current->items[i]->deepCopy());
+		}
+		tile->items.swap(items);
+	} else {
+		const Position &position = tile->getPosition();
+		spdlog::error("[Change::expand] - Tile {}:{}:{} was changed outside the undo history, its shared items could not be restored", position.x, position.y, position.z);
+	}
+
+	delete delta;
+	type = CHANGE_TILE;
+	data = tile;
+}
+
 Action::Action(Editor &editor, ActionIdentifier ident) :
 	commited(false),
+	memory_size(0),
+	full_memory_size(0),
 	editor(editor),
 	type(ident) {
 }
@@ -109,29 +284,79 @@ size_t Action::approx_memsize() const {
 }
 
 size_t Action::memsize() const {
-	uint32_t mem = sizeof(*this);
+	// Measured whenever the changes are applied
+	if (memory_size > 0) {
+		return memory_size;
+	}
+
+	size_t mem = sizeof(*this);
 	mem += sizeof(Change*) * 3 * changes.size();
 
 	for (const Change* change : changes) {
-		if (change && change->getType() == CHANGE_TILE) {
-			mem += reinterpret_cast<Tile*>(change->getData())->memsize();
+		if (change) {
+			mem += change->memsize();
 		}
 	}
 
 	return mem;
 }
 
+size_t Action::fullsize() const {
+	if (full_memory_size > 0) {
+		return full_memory_size;
+	}
+	return memsize();
+}
+
+void Action::compactChanges(const std::vector<Tile*> &placed) {
+	const bool deltas = g_settings.getBoolean(Config::UNDO_DELTA_RECORDS) && !editor.IsLive();
+
+	// A tile changed twice by one action must keep its full copies, the
+	// second change is recorded against a tile the first one replaced
+	std::unordered_set<const Tile*> placed_tiles;
+	if (deltas && changes.size() > 1) {
+		placed_tiles.insert(placed.begin(), placed.end());
+	}
+
+	Map &map = editor.getMap();
+	for (size_t i = 0; deltas && i < changes.size(); ++i) {
+		Change* change = changes[i];
+		Tile* current = placed[i];
+		if (current && change->getType() == CHANGE_TILE) {
+			const Tile* recorded = reinterpret_cast<const Tile*>(change->getData());
+			if (map.getTile(current->getPosition()) == current && !placed_tiles.contains(recorded)) {
+				change->compact(current);
+			}
+		}
+	}
+	measureChanges();
+}
+
+void Action::measureChanges() {
+	memory_size = sizeof(*this) + sizeof(Change*) * 3 * changes.size();
+	full_memory_size = memory_size;
+	for (const Change* change : changes) {
+		memory_size += change->memsize();
+		full_memory_size += change->fullsize();
+	}
+}
+
 void Action::commit(DirtyList* dirty_list) {
 	Map &map = editor.getMap();
 	Selection &selection = editor.getSelection();
 	selection.start(Selection::INTERNAL);
 
-	for (Change* change : changes) {
+	std::vector<Tile*> placed(changes.size(), nullptr);
+	for (size_t index = 0; index < changes.size(); ++index) {
+		Change* change = changes[index];
+		change->expand(map);
+
 		switch (change->getType()) {
 			case CHANGE_TILE: {
 				void** data = &change->data;
 				Tile* new_tile = reinterpret_cast<Tile*>(*data);
 				ASSERT(new_tile);
+				placed[index] = new_tile;
 
 				const Position &pos = new_tile->getPosition();
 
@@ -145,6 +370,7 @@ void Action::commit(DirtyList* dirty_list) {
 
 				Tile* old_tile = map.swapTile(pos, new_tile);
 				TileLocation* location = new_tile->getLocation();
+				map.addDamagedPosition(pos);
 
 				// Update other nodes in the network
 				if (editor.IsLiveServer() && dirty_list) {
@@ -240,6 +466,8 @@ void Action::commit(DirtyList* dirty_list) {
 					const Position &old_pos = house->getExit();
 					house->setExit(data->position);
 					data->position = old_pos;
+					map.addDamagedPosition(data->position);
+					map.addDamagedPosition(house->getExit());
 				}
 				break;
 			}
@@ -262,15 +490,22 @@ void Action::commit(DirtyList* dirty_list) {
 					Position old_pos = waypoint->pos;
 					waypoint->pos = data->position;
 					data->position = old_pos;
+					map.addDamagedPosition(old_pos);
+					map.addDamagedPosition(waypoint->pos);
 				}
 				break;
 			}
 
+			case CHANGE_SELECTION:
+				swapSelection(map, selection, reinterpret_cast<SelectionData*>(change->data));
+				break;
+
 			default:
 				break;
 		}
 	}
 	selection.finish(Selection::INTERNAL);
+	compactChanges(placed);
 	commited = true;
 }
 
@@ -283,12 +518,17 @@ void Action::undo(DirtyList* dirty_list) {
 	Selection &selection = editor.getSelection();
 	selection.start(Selection::INTERNAL);
 
-	for (Change* change : changes) {
+	std::vector<Tile*> placed(changes.size(), nullptr);
+	for (size_t index = 0; index < changes.size(); ++index) {
+		Change* change = changes[index];
+		change->expand(map);
+
 		switch (change->getType()) {
 			case CHANGE_TILE: {
 				void** data = &change->data;
 				Tile* old_tile = reinterpret_cast<Tile*>(*data);
 				ASSERT(old_tile);
+				placed[index] = old_tile;
 				const Position &pos = old_tile->getPosition();
 
 				if (editor.IsLiveClient()) {
@@ -301,6 +541,7 @@ void Action::undo(DirtyList* dirty_list) {
 				}
 
 				Tile* new_tile = map.swapTile(pos, old_tile);
+				map.addDamagedPosition(pos);
 
 				// Update server side change list (for broadcast)
 				if (editor.IsLiveServer() && dirty_list) {
@@ -372,6 +613,8 @@ void Action::undo(DirtyList* dirty_list) {
 					const Position &oldpos = house->getExit();
 					house->setExit(data->position);
 					data->position = oldpos;
+					map.addDamagedPosition(data->position);
+					map.addDamagedPosition(house->getExit());
 				}
 				break;
 			}
@@ -394,16 +637,23 @@ void Action::undo(DirtyList* dirty_list) {
 					Position old_pos = waypoint->pos;
 					waypoint->pos = data->position;
 					data->position = old_pos;
+					map.addDamagedPosition(old_pos);
+					map.addDamagedPosition(waypoint->pos);
 				}
 				break;
 			}
 
+			case CHANGE_SELECTION:
+				swapSelection(map, selection, reinterpret_cast<SelectionData*>(change->data));
+				break;
+
 			default:
 				break;
 		}
 	}
 
 	selection.finish(Selection::INTERNAL);
+	compactChanges(placed);
 	commited = false;
 }
 
@@ -431,19 +681,23 @@ size_t BatchAction::memsize(bool recalc) const {
 	uint32_t mem = sizeof(*this);
 	mem += sizeof(Action*) * 3 * batch.size();
 
+	// Actions measure themselves when applied, so this is exact and cheap
 	for (const Action* action : batch) {
-#ifdef __USE_EXACT_MEMSIZE__
 		mem += action->memsize();
-#else
-		// Less exact but MUCH faster
-		mem += action->approx_memsize();
-#endif
 	}
 
 	const_cast<BatchAction*>(this)->memory_size = mem;
 	return mem;
 }
 
+size_t BatchAction::fullsize() const {
+	size_t mem = sizeof(*this) + sizeof(Action*) * 3 * batch.size();
+	for (const Action* action : batch) {
+		mem += action->fullsize();
+	}
+	return mem;
+}
+
 bool BatchAction::isNoSelection() const noexcept {
 	return type != ACTION_SELECT && type != ACTION_UNSELECT;
 }
@@ -505,7 +759,7 @@ void BatchAction::merge(BatchAction* other) {
 }
 
 ActionQueue::ActionQueue(Editor &editor) :
-	current(0), memory_size(0), editor(editor) {
+	current(0), memory_size(0), spilled_count(0), editor(editor) {
 	////
 }
 
@@ -556,32 +810,19 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		return;
 	}
 
-	while (current != actions.size()) {
-		memory_size -= actions.back()->memsize();
-		BatchAction* todelete = actions.back();
-		actions.pop_back();
-		delete todelete;
+	if (batch->isNoSelection()) {
+		editor.getJournal().record(editor.getMap(), *batch);
 	}
 
-	while (memory_size > size_t(1024 * 1024 * g_settings.getInteger(Config::UNDO_MEM_SIZE)) && !actions.empty()) {
-		memory_size -= actions.front()->memsize();
-		delete actions.front();
-		actions.pop_front();
-		current--;
-	}
-
-	if (actions.size() > size_t(g_settings.getInteger(Config::UNDO_SIZE)) && !actions.empty()) {
-		memory_size -= actions.front()->memsize();
-		BatchAction* todelete = actions.front();
-		actions.pop_front();
-		delete todelete;
-		current--;
+	while (current != actions.size()) {
+		discardBatch(actions.back());
+		actions.pop_back();
 	}
 
 	do {
 		if (!actions.empty()) {
 			BatchAction* lastAction = actions.back();
-			if (lastAction->type == batch->type && g_settings.getInteger(Config::GROUP_ACTIONS) && time(nullptr) - stacking_delay < lastAction->timestamp) {
+			if (!lastAction->isSpilled() && lastAction->type == batch->type && g_settings.getInteger(Config::GROUP_ACTIONS) && time(nullptr) - stacking_delay < lastAction->timestamp) {
 				lastAction->merge(batch);
 				lastAction->timestamp = time(nullptr);
 				memory_size -= lastAction->memsize();
@@ -595,6 +836,81 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		batch->timestamp = time(nullptr);
 		current++;
 	} while (false);
+
+	trimHistory();
+}
+
+void ActionQueue::trimHistory() {
+	const size_t memory_limit = size_t(1024 * 1024 * g_settings.getInteger(Config::UNDO_MEM_SIZE));
+	const size_t resident_limit = size_t(g_settings.getInteger(Config::UNDO_SIZE));
+	const auto overLimit = [&]() {
+		return memory_size > memory_limit || actions.size() - spilled_count > resident_limit;
+	};
+
+	if (!overLimit()) {
+		return;
+	}
+
+	// The next steps to undo and to redo always stay in memory; the oldest
+	// steps go first, then the redo steps furthest away
+	if (g_settings.getBoolean(Config::UNDO_SPILL_TO_DISK) && !editor.IsLive()) {
+		bool spilling = true;
+		for (size_t index = 0; spilling && index + 1 < current && overLimit(); ++index) {
+			spilling = spillBatch(actions[index]);
+		}
+		for (size_t index = actions.size(); spilling && index > current + 1 && overLimit(); --index) {
+			spilling = spillBatch(actions[index - 1]);
+		}
+	}
+
+	// A spilled step holds next to no memory, so dropping spilled history
+	// never helps; stop at the first one and keep the rest of the history
+	while (overLimit() && current > 1 && !actions.front()->isSpilled()) {
+		discardBatch(actions.front());
+		actions.pop_front();
+		current--;
+	}
+}
+
+bool ActionQueue::spillBatch(BatchAction* batch) {
+	if (batch->isSpilled()) {
+		return true;
+	}
+
+	const size_t resident = batch->memsize();
+	if (!spill_file.spill(*batch)) {
+		return false;
+	}
+
+	memory_size -= resident;
+	memory_size += batch->memsize(true);
+	++spilled_count;
+	return true;
+}
+
+bool ActionQueue::restoreBatch(BatchAction* batch) {
+	if (!batch->isSpilled()) {
+		return true;
+	}
+
+	const size_t spilled = batch->memsize();
+	if (!spill_file.restore(*batch, *this)) {
+		return false;
+	}
+
+	memory_size -= spilled;
+	memory_size += batch->memsize(true);
+	--spilled_count;
+	return true;
+}
+
+void ActionQueue::discardBatch(BatchAction* batch) {
+	if (batch->isSpilled()) {
+		spill_file.release(*batch->spill_record);
+		--spilled_count;
+	}
+	memory_size -= batch->memsize();
+	delete batch;
 }
 
 void ActionQueue::addAction(Action* action, int stacking_delay) {
@@ -625,15 +941,33 @@ void ActionQueue::generateLabels() {
 
 bool ActionQueue::undo() {
 	if (current > 0) {
+		BatchAction* batch = actions.at(current - 1);
+		const bool spilled = batch && batch->isSpilled();
+		if (spilled && !restoreBatch(batch)) {
+			// Nothing before this step can be undone anymore
+			while (current > 0) {
+				discardBatch(actions.front());
+				actions.pop_front();
+				current--;
+			}
+			return false;
+		}
+
 		current--;
-		BatchAction* batch = actions.at(current);
 		if (batch) {
 			batch->undo();
 		}
 
-		// Update title
-		if (batch && batch->isNoSelection() && editor.getMap().doChange()) {
-			g_gui.UpdateTitle();
+		if (batch && batch->isNoSelection()) {
+			editor.getJournal().record(editor.getMap(), *batch);
+			// Update title
+			if (editor.getMap().doChange()) {
+				g_gui.UpdateTitle();
+			}
+		}
+
+		if (spilled) {
+			trimHistory();
 		}
 		return true;
 	}
@@ -643,14 +977,31 @@ bool ActionQueue::undo() {
 bool ActionQueue::redo() {
 	if (current < actions.size()) {
 		BatchAction* batch = actions.at(current);
+		const bool spilled = batch && batch->isSpilled();
+		if (spilled && !restoreBatch(batch)) {
+			// Nothing from this step on can be redone anymore
+			while (current != actions.size()) {
+				discardBatch(actions.back());
+				actions.pop_back();
+			}
+			return false;
+		}
+
 		if (batch) {
 			batch->redo();
 		}
 		current++;
 
-		// Update title
-		if (batch && batch->isNoSelection() && editor.getMap().doChange()) {
-			g_gui.UpdateTitle();
+		if (batch && batch->isNoSelection()) {
+			editor.getJournal().record(editor.getMap(), *batch);
+			// Update title
+			if (editor.getMap().doChange()) {
+				g_gui.UpdateTitle();
+			}
+		}
+
+		if (spilled) {
+			trimHistory();
 		}
 		return true;
 	}
@@ -659,19 +1010,46 @@ bool ActionQueue::redo() {
 
 bool ActionQueue::hasChanges() const {
 	for (const BatchAction* batch : actions) {
-		if (batch && !batch->empty() && batch->isNoSelection()) {
+		if (batch && (!batch->empty() || batch->isSpilled()) && batch->isNoSelection()) {
 			return true;
 		}
 	}
 	return false;
 }
 
+std::map<ActionIdentifier, UndoMemoryStats> ActionQueue::getMemoryStats() const {
+	std::map<ActionIdentifier, UndoMemoryStats> stats;
+	for (const BatchAction* batch : actions) {
+		UndoMemoryStats &entry = stats[batch->getType()];
+		++entry.batches;
+		if (batch->spill_record) {
+			++entry.spilled;
+			entry.changes += batch->spill_record->changes;
+			entry.spilled_bytes += batch->spill_record->stored_size;
+			continue;
+		}
+
+		entry.bytes += batch->memsize();
+		entry.full_bytes += batch->fullsize();
+		for (const Action* action : batch->batch) {
+			entry.changes += action->size();
+			entry.deltas += static_cast<size_t>(std::ranges::count_if(action->changes, [](const Change* change) {
+				return change->getType() == CHANGE_TILE_DELTA;
+			}));
+		}
+	}
+	return stats;
+}
+
 void ActionQueue::clear() {
 	for (BatchAction* batch : actions) {
 		delete batch;
 	}
 	actions.clear();
+	spill_file.clear();
 	current = 0;
+	memory_size = 0;
+	spilled_count = 0;
 }
 
 wxString ActionQueue::createLabel(ActionIdentifier type) {
@@ -706,6 +1084,8 @@ wxString ActionQueue::createLabel(ActionIdentifier type) {
 			return "Change Properties";
 		case ACTION_LUA_SCRIPT:
 			return "Lua Script";
+		case ACTION_RECOVER_JOURNAL:
+			return "Recover Edits";
 		default:
 			return wxEmptyString;
 	}
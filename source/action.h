@@ -19,7 +19,11 @@
 #define RME_ACTION_H_
 
 #include "position.h"
+#include "undo_spill.h"
 
+#include <optional>
+
+class BaseMap;
 class Editor;
 class Tile;
 class House;
@@ -46,13 +50,16 @@ enum ActionIdentifier {
 	ACTION_REPLACE_ITEMS,
 	ACTION_CHANGE_PROPERTIES,
 	ACTION_LUA_SCRIPT,
+	ACTION_RECOVER_JOURNAL,
 };
 
 enum ChangeType {
 	CHANGE_NONE,
 	CHANGE_TILE,
+	CHANGE_TILE_DELTA,
 	CHANGE_MOVE_HOUSE_EXIT,
 	CHANGE_MOVE_WAYPOINT,
+	CHANGE_SELECTION,
 };
 
 struct HouseData {
@@ -65,6 +72,26 @@ struct WaypointData {
 	Position position;
 };
 
+// Selection state of the things on a tile, as read by Tile::getSelectionState.
+// Applied in place, swapping with the state on the map, so selecting never
+// copies the tile.
+struct SelectionData {
+	Position position;
+	std::vector<bool> state;
+};
+
+// A tile change stored relative to the tile on the map. Ground and items at
+// the bottom and top of the stack that both tiles share are dropped from the
+// recorded tile and copied back from the map tile before the change is applied.
+struct TileDelta {
+	Tile* tile; // The recorded tile without the shared items
+	uint32_t shared_hash; // Fingerprint of the shared items, checked before restoring them
+	uint32_t full_size; // memsize of the recorded tile with the shared items
+	uint16_t shared_front;
+	uint16_t shared_back;
+	bool shared_ground;
+};
+
 class Change {
 public:
 	Change(Tile* tile);
@@ -72,6 +99,7 @@ public:
 
 	static Change* Create(House* house, const Position &position);
 	static Change* Create(Waypoint* waypoint, const Position &position);
+	static Change* Create(const Tile* tile, std::vector<bool> &&state);
 
 	void clear();
 
@@ -83,6 +111,13 @@ public:
 	}
 
 	uint32_t memsize() const;
+	// memsize of the change if it were a full tile copy
+	uint32_t fullsize() const;
+
+	// Turns a tile change into a delta against the tile now on the map; returns false if nothing is shared
+	bool compact(const Tile* current);
+	// Restores the full recorded tile of a delta from the tile now on the map
+	void expand(BaseMap &map);
 
 private:
 	Change();
@@ -90,6 +125,7 @@ private:
 	void* data;
 
 	friend class Action;
+	friend class UndoSpillFile;
 };
 
 typedef std::vector<Change*> ChangeList;
@@ -138,6 +174,8 @@ public:
 	// Get memory footprint
 	size_t approx_memsize() const;
 	size_t memsize() const;
+	// Footprint if every tile change were a full tile copy
+	size_t fullsize() const;
 	size_t size() const noexcept {
 		return changes.size();
 	}
@@ -160,12 +198,20 @@ public:
 protected:
 	Action(Editor &editor, ActionIdentifier ident);
 
+	// Compacts the tile changes whose counterpart is still the tile on the map
+	void compactChanges(const std::vector<Tile*> &placed);
+	void measureChanges();
+
 	bool commited;
+	size_t memory_size;
+	size_t full_memory_size;
 	ChangeList changes;
 	Editor &editor;
 	ActionIdentifier type;
 
 	friend class ActionQueue;
+	friend class UndoSpillFile;
+	friend class EditJournal;
 };
 
 typedef std::vector<Action*> ActionVector;
@@ -180,6 +226,7 @@ public:
 
 	// Get memory footprint
 	size_t memsize(bool resize = false) const;
+	size_t fullsize() const;
 	size_t size() const noexcept {
 		return batch.size();
 	}
@@ -193,6 +240,10 @@ public:
 		return label;
 	}
 	bool isNoSelection() const noexcept;
+	// The actions of a spilled batch are on disk until the history reaches it again
+	bool isSpilled() const noexcept {
+		return spill_record.has_value();
+	}
 
 	virtual void addAction(Action* action);
 	virtual void addAndCommitAction(Action* action);
@@ -212,8 +263,21 @@ protected:
 	ActionIdentifier type;
 	ActionVector batch;
 	wxString label;
+	std::optional<UndoSpillRecord> spill_record;
 
 	friend class ActionQueue;
+	friend class UndoSpillFile;
+	friend class EditJournal;
+};
+
+struct UndoMemoryStats {
+	size_t batches = 0;
+	size_t changes = 0;
+	size_t deltas = 0;
+	size_t bytes = 0;
+	size_t full_bytes = 0; // as full tile copies
+	size_t spilled = 0; // batches on disk
+	size_t spilled_bytes = 0; // compressed size on disk
 };
 
 class ActionQueue {
@@ -257,16 +321,29 @@ public:
 	}
 
 	bool hasChanges() const;
+	// Memory held by the history per action type, next to what full tile copies would take
+	std::map<ActionIdentifier, UndoMemoryStats> getMemoryStats() const;
+	const UndoSpillStats &getSpillStats() const noexcept {
+		return spill_file.getStats();
+	}
 
 	void generateLabels();
+	static wxString createLabel(ActionIdentifier type);
 
 protected:
-	static wxString createLabel(ActionIdentifier type);
+	// Keeps the resident history within UNDO_MEM_SIZE and UNDO_SIZE by spilling
+	// batches to disk, or dropping the oldest ones when spilling is not possible
+	void trimHistory();
+	bool spillBatch(BatchAction* batch);
+	bool restoreBatch(BatchAction* batch);
+	void discardBatch(BatchAction* batch);
 
 	size_t current;
 	size_t memory_size;
+	size_t spilled_count;
 	Editor &editor;
 	ActionList actions;
+	UndoSpillFile spill_file;
 };
 
 #endif
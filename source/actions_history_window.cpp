@@ -105,6 +105,7 @@ const wxBitmap &HistoryListBox::getIconBitmap(ActionIdentifier identifier) const
 		case ACTION_REPLACE_ITEMS:
 			return replace_bitmap;
 		case ACTION_CHANGE_PROPERTIES:
+		case ACTION_RECOVER_JOURNAL:
 			return change_bitmap;
 		default:
 			return wxNullBitmap;
@@ -113,6 +113,9 @@ void BaseMap::setTile(TileLocation* location, Tile* new_tile, bool remove) {
 	if ((remove && old_tile) || new_tile) {
 		updateUniqueIds(remove ? old_tile : nullptr, new_tile);
 	}
+	if (old_tile != new_tile) {
+		updateTileIndexes(old_tile, new_tile);
+	}
 
 	if (new_tile && !old_tile) {
 		++tilecount;
@@ -137,6 +140,9 @@ void BaseMap::setTile(int x, int y, int z, Tile* new_tile, bool remove) {
 	if ((remove && old_tile) || new_tile) {
 		updateUniqueIds(remove ? old_tile : nullptr, new_tile);
 	}
+	if (old_tile != new_tile) {
+		updateTileIndexes(old_tile, new_tile);
+	}
 
 	if (remove) {
 		std::unique_ptr<Tile> { old_tile };
@@ -166,6 +172,9 @@ Tile* BaseMap::swapTile(int x, int y, int z, Tile* new_tile) {
 	if (old_tile || new_tile) {
 		updateUniqueIds(old_tile, new_tile);
 	}
+	if (old_tile != new_tile) {
+		updateTileIndexes(old_tile, new_tile);
+	}
 
 	return old_tile;
 }
@@ -174,6 +183,50 @@ Tile* BaseMap::swapTile(const Position &position, Tile* new_tile) {
 	return swapTile(position.x, position.y, position.z, new_tile);
 }
 
+uint32_t BaseMap::getLeafKey(int x, int y) noexcept {
+	uint32_t key = 0;
+	for (int shift = 14; shift >= 2; shift -= 2) {
+		key = (key << 4) | ((x >> shift) & 3) | (((y >> shift) & 3) << 2);
+	}
+	return key;
+}
+
+Position BaseMap::getLeafPosition(uint32_t key) noexcept {
+	Position position;
+	for (int shift = 2; shift <= 14; shift += 2, key >>= 4) {
+		position.x |= (key & 3) << shift;
+		position.y |= ((key >> 2) & 3) << shift;
+	}
+	return position;
+}
+
+void BaseMap::getLeaves(int start_x, int start_y, int end_x, int end_y, std::vector<QTreeNode*> &leaves) {
+	// The root spans the whole 16 bit coordinate space
+	getLeaves(root, 0, 0, 0x10000, start_x, start_y, end_x, end_y, leaves);
+}
+
+void BaseMap::getLeaves(QTreeNode &node, int node_x, int node_y, int node_size, int start_x, int start_y, int end_x, int end_y, std::vector<QTreeNode*> &leaves) {
+	if (node.isLeaf) {
+		leaves.push_back(&node);
+		return;
+	}
+
+	const int child_size = node_size / QTreeNode::ChildSplit;
+	for (int index = 0; index < QTreeNode::ChildCount; ++index) {
+		QTreeNode* child = node.child[index];
+		if (!child) {
+			continue;
+		}
+
+		const int child_x = node_x + (index % QTreeNode::ChildSplit) * child_size;
+		const int child_y = node_y + (index / QTreeNode::ChildSplit) * child_size;
+		if (child_x > end_x || child_y > end_y || child_x + child_size <= start_x || child_y + child_size <= start_y) {
+			continue;
+		}
+		getLeaves(*child, child_x, child_y, child_size, start_x, start_y, end_x, end_y, leaves);
+	}
+}
+
 // Iterators
 
 MapIterator::MapIterator(BaseMap* _map) :
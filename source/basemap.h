@@ -122,6 +122,12 @@ public:
 	QTreeNode* createLeaf(int x, int y) {
 		return root.getLeafForce(x, y);
 	}
+	// Orders leaves the way the tree stores them: two bits of x and two of y per level, root first
+	static uint32_t getLeafKey(int x, int y) noexcept;
+	// The corner of the leaf a key was made from
+	static Position getLeafPosition(uint32_t key) noexcept;
+	// Appends the existing leaves that overlap the area (inclusive), skipping empty branches
+	void getLeaves(int start_x, int start_y, int end_x, int end_y, std::vector<QTreeNode*> &leaves);
 
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
 	void setTile(TileLocation* location, Tile* new_tile, bool remove = false);
@@ -144,6 +150,10 @@ public:
 
 protected:
 	virtual void updateUniqueIds(Tile* old_tile, Tile* new_tile) { }
+	// Called with the tile that really left the location, whether or not it is deleted
+	virtual void updateTileIndexes(const Tile* old_tile, const Tile* new_tile) { }
+
+	void getLeaves(QTreeNode &node, int node_x, int node_y, int node_size, int start_x, int start_y, int end_x, int end_y, std::vector<QTreeNode*> &leaves);
 
 	template <typename Fn>
 	void forEachFloorTileLocation(Floor &floor, Fn &fn) {
@@ -28,12 +28,24 @@
 
 #include <appearances.pb.h>
 
+#include <future>
+
 namespace {
 	bool logErrorAndSetMessage(const std::string &message, wxString &error) {
 		spdlog::error(message);
 		error = message;
 		return false;
 	}
+
+	// Older protobuf releases only place messages on the arena through CreateMessage
+	template <typename Message>
+	Message* createOnArena(google::protobuf::Arena &arena) {
+#if GOOGLE_PROTOBUF_VERSION < 4022000
+		return google::protobuf::Arena::CreateMessage<Message>(&arena);
+#else
+		return google::protobuf::Arena::Create<Message>(&arena);
+#endif
+	}
 } // namespace (internal use only)
 
 using json = nlohmann::json;
@@ -61,6 +73,15 @@ void ClientAssets::load() {
 bool ClientAssets::loadAppearanceProtobuf(wxString &error, wxArrayString &warnings) {
 	using namespace canary::protobuf::appearances;
 	using json = nlohmann::json;
+	using Clock = std::chrono::steady_clock;
+
+	const auto loadStart = Clock::now();
+	auto stageStart = loadStart;
+	const auto logStage = [&stageStart](std::string_view stage) {
+		const auto now = Clock::now();
+		spdlog::info("[ClientAssets] - {} took {:.1f} ms", stage, std::chrono::duration<double, std::milli>(now - stageStart).count());
+		stageStart = now;
+	};
 
 	auto clientDirectory = ClientAssets::getPath().ToStdString() + "/";
 	if (!wxDirExists(wxString(clientDirectory))) {
@@ -78,8 +99,51 @@ bool ClientAssets::loadAppearanceProtobuf(wxString &error, wxArrayString &warnin
 		logErrorAndSetMessage(fmt::format("Failed to load catalog content from directory: {}", assetsDirectory), error);
 		return false;
 	}
+	logStage("Reading catalog-content.json");
+
+	// Verify that the version of the library that we linked against is
+	// compatible with the version of the headers we compiled against.
+	GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+	// The appearances are parsed into an arena on a worker while the sprite
+	// sheets and package.json are handled here; the whole message tree is
+	// released at once when this function returns.
+	const std::string appearanceFileName = g_spriteAppearances.getAppearanceFileName();
+	google::protobuf::ArenaOptions arenaOptions;
+	arenaOptions.start_block_size = 1024 * 1024;
+	arenaOptions.max_block_size = 16 * 1024 * 1024;
+	google::protobuf::Arena arena(arenaOptions);
+	auto parsing = std::async(std::launch::async, [&arena, path = assetsDirectory + appearanceFileName]() -> Appearances* {
+		const auto parseStart = Clock::now();
+		std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			return nullptr;
+		}
+
+		std::string buffer(static_cast<size_t>(file.tellg()), '\0');
+		file.seekg(0);
+		if (!file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+			return nullptr;
+		}
+		const auto readEnd = Clock::now();
+
+		Appearances* appearances = createOnArena<Appearances>(arena);
+		if (!appearances->ParseFromString(buffer)) {
+			return nullptr;
+		}
+
+		const auto milliseconds = [](Clock::duration duration) {
+			return std::chrono::duration<double, std::milli>(duration).count();
+		};
+		spdlog::info("[ClientAssets] - Read {} ({:.1f} MB) in {:.1f} ms, parsed in {:.1f} ms", path, buffer.size() / (1024.0 * 1024.0), milliseconds(readEnd - parseStart), milliseconds(Clock::now() - readEnd));
+		return appearances;
+	});
+
+	if (g_settings.getBoolean(Config::PRELOAD_SPRITE_SHEETS)) {
+		g_spriteAppearances.preloadSpriteSheets(static_cast<size_t>(g_settings.getInteger(Config::TEXTURE_MEMORY_BUDGET)) * 1024 * 1024);
+		logStage("Preloading sprite sheets");
+	}
 
-	using json = nlohmann::json;
 	std::filesystem::path packagesPath = std::filesystem::path(clientDirectory) / std::filesystem::path("package.json");
 	if (!std::filesystem::exists(packagesPath)) {
 		error = "The file package.json is not present in the client directory.";
@@ -100,48 +164,34 @@ bool ClientAssets::loadAppearanceProtobuf(wxString &error, wxArrayString &warnin
 	std::string version = document.at("version").get<std::string>();
 	version_name = version;
 
-	const std::string appearanceFileName = g_spriteAppearances.getAppearanceFileName();
-
-	std::fstream fileStream(assetsDirectory + appearanceFileName, std::ios::in | std::ios::binary);
-	if (!fileStream.is_open()) {
-		error = "Failed to load " + appearanceFileName + " from the client folder, file cannot be oppened";
-		spdlog::error("[{}] - Failed to load {}, file cannot be oppened", __func__, appearanceFileName);
-		fileStream.close();
-		return false;
-	}
-
-	// Verify that the version of the library that we linked against is
-	// compatible with the version of the headers we compiled against.
-	GOOGLE_PROTOBUF_VERIFY_VERSION;
-	g_gui.m_appearancesPtr = std::make_unique<Appearances>();
-	if (!g_gui.m_appearancesPtr->ParseFromIstream(&fileStream)) {
-		error = "Failed to parse binary file " + appearanceFileName + ", file is invalid";
-		spdlog::error("[{}] - Failed to parse binary file {}, file is invalid", __func__, appearanceFileName);
-		fileStream.close();
+	const Appearances* appearances = parsing.get();
+	logStage("Waiting for " + appearanceFileName);
+	if (!appearances) {
+		error = "Failed to parse binary file " + appearanceFileName + ", file is invalid or cannot be opened";
+		spdlog::error("[{}] - Failed to parse binary file {}, file is invalid or cannot be opened", __func__, appearanceFileName);
 		return false;
 	}
 
 	// Parsing all items into ItemType
-	bool rt = g_items.loadFromProtobuf(error, warnings, *g_gui.m_appearancesPtr);
+	bool rt = g_items.loadFromProtobuf(error, warnings, *appearances);
 	if (!rt) {
 		error = "Failed to parse item types from protobuf";
 		spdlog::error("[{}] - Failed to parse item types from protobuf", __func__);
-		fileStream.close();
 		return false;
 	}
+	logStage("Building item types");
 
 	// Load looktypes
-	for (int i = 0; i < g_gui.m_appearancesPtr->outfit().size(); i++) {
-		const auto &outfit = g_gui.m_appearancesPtr->outfit().Get(i);
+	for (const Appearance &outfit : appearances->outfit()) {
 		if (!g_gui.gfx.loadOutfitSpriteMetadata(outfit, error, warnings)) {
 			error = "Failed to parse outfit types from protobuf";
 			spdlog::error("[{}] - Failed to parse outfit types from protobuf", __func__);
-			fileStream.close();
 			return false;
 		}
 	}
+	logStage("Building outfit types");
 
-	fileStream.close();
+	spdlog::info("[ClientAssets] - Client assets loaded in {:.1f} ms", std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count());
 
 	// Client loaded
 	setLoaded(true);
@@ -44,6 +44,17 @@ Item* Container::deepCopy() const {
 	return copy;
 }
 
+bool Container::isEquivalent(const Item &other) const {
+	if (!Item::isEquivalent(other)) {
+		return false;
+	}
+
+	const ItemVector &otherContents = static_cast<const Container &>(other).contents;
+	return std::ranges::equal(contents, otherContents, [](const Item* a, const Item* b) {
+		return a->isEquivalent(*b);
+	});
+}
+
 Item* Container::getItem(size_t index) const {
 	if (index >= 0 && index < contents.size()) {
 		return contents.at(index);
@@ -66,6 +77,10 @@ Item* Teleport::deepCopy() const {
 	return copy;
 }
 
+bool Teleport::isEquivalent(const Item &other) const {
+	return Item::isEquivalent(other) && destination == static_cast<const Teleport &>(other).destination;
+}
+
 // Door
 Door::Door(const uint16_t type) :
 	Item(type, 0),
@@ -81,6 +96,10 @@ Item* Door::deepCopy() const {
 	return copy;
 }
 
+bool Door::isEquivalent(const Item &other) const {
+	return Item::isEquivalent(other) && doorId == static_cast<const Door &>(other).doorId;
+}
+
 // Depot
 Depot::Depot(const uint16_t type) :
 	Item(type, 0),
@@ -95,3 +114,7 @@ Item* Depot::deepCopy() const {
 	}
 	return copy;
 }
+
+bool Depot::isEquivalent(const Item &other) const {
+	return Item::isEquivalent(other) && depotId == static_cast<const Depot &>(other).depotId;
+}
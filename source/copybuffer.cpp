@@ -23,6 +23,52 @@
 #include "monster.h"
 #include "npc.h"
 
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace {
+	// Tiles handled between two progress updates of a paste
+	constexpr size_t PasteChunkSize = 4096;
+	// Smaller pastes are done before a progress dialog would be of any use
+	constexpr size_t PasteProgressThreshold = 32768;
+
+	// Tile lookups that remember the last leaf, as a paste walks its tiles leaf by leaf
+	class LeafCache {
+	public:
+		explicit LeafCache(Map &map) :
+			map(map) { }
+
+		const Tile* get(int x, int y, int z) {
+			if (!find(x, y, false)) {
+				return nullptr;
+			}
+			const TileLocation* location = leaf->getTile(x, y, z);
+			return location ? location->get() : nullptr;
+		}
+
+		TileLocation* create(const Position &pos) {
+			find(pos.x, pos.y, true);
+			return leaf->createTile(pos.x, pos.y, pos.z);
+		}
+
+	private:
+		bool find(int x, int y, bool force) {
+			if (!leaf || (x & ~3) != leaf_x || (y & ~3) != leaf_y) {
+				leaf = force ? map.createLeaf(x, y) : map.getLeaf(x, y);
+				leaf_x = x & ~3;
+				leaf_y = y & ~3;
+			}
+			return leaf != nullptr;
+		}
+
+		Map &map;
+		QTreeNode* leaf = nullptr;
+		int leaf_x = -1;
+		int leaf_y = -1;
+	};
+}
+
 CopyBuffer::CopyBuffer() :
 	tiles(newd BaseMap()) {
 	;
@@ -49,6 +95,7 @@ Position CopyBuffer::getPosition() const {
 void CopyBuffer::clear() {
 	delete tiles;
 	tiles = nullptr;
+	++generation;
 }
 
 void CopyBuffer::copy(Editor &editor, int floor) {
@@ -258,23 +305,61 @@ void CopyBuffer::paste(Editor &editor, const Position &toPosition) {
 
 	Map &map = editor.getMap();
 
+	// Destinations sorted by leaf, so each leaf is looked up once and its tiles are placed together
+	std::vector<std::pair<Position, const Tile*>> pasted;
+	pasted.reserve(tiles->size());
+	for (MapIterator it = tiles->begin(); it != tiles->end(); ++it) {
+		const Tile* buffer_tile = (*it)->get();
+		const Position pos = buffer_tile->getPosition() - copyPos + toPosition;
+		if (pos.isValid()) {
+			pasted.emplace_back(pos, buffer_tile);
+		}
+	}
+	std::ranges::sort(pasted, {}, [](const auto &entry) {
+		const Position &pos = entry.first;
+		return std::tuple(pos.x & ~3, pos.y & ~3, pos.z, pos.x, pos.y);
+	});
+
+	const bool show_progress = pasted.size() >= PasteProgressThreshold;
+	if (show_progress) {
+		g_gui.CreateLoadBar("Pasting...", true);
+	}
+	// Placing takes most of the time, the border pass over the outline the rest
+	const auto progress = [show_progress](size_t done, size_t total, int32_t from, int32_t to) {
+		if (!show_progress || done % PasteChunkSize != 0) {
+			return true;
+		}
+		return g_gui.SetLoadDone(from + static_cast<int32_t>((to - from) * done / std::max<size_t>(total, 1)));
+	};
+	const auto cancel = [show_progress]() {
+		if (show_progress) {
+			g_gui.DestroyLoadBar();
+		}
+		g_gui.SetStatusText("Paste cancelled");
+	};
+
 	BatchAction* batchAction = editor.createBatch(ACTION_PASTE_TILES);
 	Action* action = editor.createAction(batchAction);
-	for (MapIterator it = tiles->begin(); it != tiles->end(); ++it) {
-		Tile* buffer_tile = (*it)->get();
-		Position pos = buffer_tile->getPosition() - copyPos + toPosition;
 
-		if (!pos.isValid()) {
-			continue;
+	const bool merge = g_settings.getInteger(Config::MERGE_PASTE);
+	LeafCache leaves(map);
+	for (size_t index = 0; index < pasted.size(); ++index) {
+		// Nothing is on the map until the whole paste is built, so cancelling only drops it
+		if (!progress(index, pasted.size(), 0, 60)) {
+			delete action;
+			delete batchAction;
+			cancel();
+			return;
 		}
 
-		TileLocation* location = map.createTileL(pos);
+		const auto &[pos, buffer_tile] = pasted[index];
+		TileLocation* location = leaves.create(pos);
 		Tile* copy_tile = buffer_tile->deepCopy(map);
 		Tile* old_dest_tile = location->get();
 		Tile* new_dest_tile = nullptr;
 		copy_tile->setLocation(location);
 
-		if (g_settings.getInteger(Config::MERGE_PASTE) || !copy_tile->ground) {
+		if (merge || !copy_tile->ground) {
 			if (old_dest_tile) {
 				new_dest_tile = old_dest_tile->deepCopy(map);
 			} else {
@@ -287,99 +372,75 @@ void CopyBuffer::paste(Editor &editor, const Position &toPosition) {
 			new_dest_tile = copy_tile;
 		}
 
-		// Add all surrounding tiles to the map, so they get borders
-		map.createTile(pos.x - 1, pos.y - 1, pos.z);
-		map.createTile(pos.x, pos.y - 1, pos.z);
-		map.createTile(pos.x + 1, pos.y - 1, pos.z);
-		map.createTile(pos.x - 1, pos.y, pos.z);
-		map.createTile(pos.x + 1, pos.y, pos.z);
-		map.createTile(pos.x - 1, pos.y + 1, pos.z);
-		map.createTile(pos.x, pos.y + 1, pos.z);
-		map.createTile(pos.x + 1, pos.y + 1, pos.z);
-
 		action->addChange(newd Change(new_dest_tile));
 	}
+	Action* placed = action;
 	batchAction->addAndCommitAction(action);
 
 	if (g_settings.getInteger(Config::USE_AUTOMAGIC) && g_settings.getInteger(Config::BORDERIZE_PASTE)) {
-		action = editor.createAction(batchAction);
-		TileList borderize_tiles;
-
-		// Go through all modified (selected) tiles (might be slow)
-		for (MapIterator it = tiles->begin(); it != tiles->end(); ++it) {
-			bool add_me = false; // If this tile is touched
-			Position pos = (*it)->getPosition() - copyPos + toPosition;
-			if (pos.z < rme::MapMinLayer || pos.z > rme::MapMaxLayer) {
-				continue;
-			}
-			// Go through all neighbours
-			Tile* t;
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
+		// The outline: every unselected neighbour of a pasted tile, and the
+		// pasted tiles next to one. Positions without a tile count as
+		// unselected neighbours, they may receive a border.
+		std::vector<Position> outline;
+		for (const auto &[pos, buffer_tile] : pasted) {
+			bool add_me = false;
+			for (int y = pos.y - 1; y <= pos.y + 1; ++y) {
+				for (int x = pos.x - 1; x <= pos.x + 1; ++x) {
+					if ((x == pos.x && y == pos.y) || x < 0 || y < 0) {
+						continue;
+					}
+					const Tile* neighbour = leaves.get(x, y, pos.z);
+					if (!neighbour || !neighbour->isSelected()) {
+						outline.emplace_back(x, y, pos.z);
+						add_me = true;
+					}
+				}
 			}
 			if (add_me) {
-				borderize_tiles.push_back(map.getTile(pos));
+				outline.push_back(pos);
 			}
 		}
-		// Remove duplicates
-		borderize_tiles.sort();
-		borderize_tiles.unique();
-
-		for (Tile* tile : borderize_tiles) {
-			if (tile) {
-				Tile* newTile = tile->deepCopy(map);
-				newTile->borderize(&map);
+		std::sort(outline.begin(), outline.end());
+		outline.erase(std::unique(outline.begin(), outline.end()), outline.end());
 
-				if (tile->ground && tile->ground->isSelected()) {
-					newTile->selectGround();
+		action = editor.createAction(batchAction);
+		for (size_t index = 0; index < outline.size(); ++index) {
+			if (!progress(index, outline.size(), 60, 100)) {
+				// The placed tiles are on the map by now and are taken back off
+				delete action;
+				if (!batchAction->empty()) {
+					placed->undo(nullptr);
 				}
+				delete batchAction;
+				cancel();
+				return;
+			}
+
+			const Position &pos = outline[index];
+			const Tile* tile = leaves.get(pos.x, pos.y, pos.z);
+			Tile* newTile = tile ? tile->deepCopy(map) : map.allocator(leaves.create(pos));
+			newTile->borderize(&map);
 
-				newTile->wallize(&map);
-				action->addChange(newd Change(newTile));
+			if (tile && tile->ground && tile->ground->isSelected()) {
+				newTile->selectGround();
 			}
+
+			newTile->wallize(&map);
+			if (!tile && newTile->empty()) {
+				// Nothing to border here, so no empty tile is left behind
+				delete newTile;
+				continue;
+			}
+			action->addChange(newd Change(newTile));
 		}
 
 		// Commit changes to map
 		batchAction->addAndCommitAction(action);
 	}
 
+	if (show_progress) {
+		g_gui.DestroyLoadBar();
+	}
 	editor.addBatch(batchAction);
 	editor.updateActions();
 }
@@ -40,12 +40,17 @@ public:
 	void clear();
 
 	size_t GetTileCount();
+	// Changes whenever the contents are replaced or cleared, so caches of the buffer can tell
+	uint64_t getGeneration() const noexcept {
+		return generation;
+	}
 
 	BaseMap &getBufferMap();
 
 private:
 	Position copyPos;
 	BaseMap* tiles;
+	uint64_t generation = 0;
 };
 
 #endif
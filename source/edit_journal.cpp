@@ -0,0 +1,544 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "edit_journal.h"
+
+#include "action.h"
+#include "map.h"
+#include "tile_record.h"
+
+#include <array>
+#include <format>
+#include <zlib.h>
+
+namespace {
+	constexpr std::array<char, 4> JournalMagic { 'R', 'M', 'E', 'J' };
+	constexpr uint32_t JournalVersion = 1;
+	constexpr std::string_view JournalExtension = ".journal";
+
+	enum JournalRecordKind : uint8_t {
+		JOURNAL_RECORD_CHANGES = 1,
+		JOURNAL_RECORD_CHECKPOINT = 2,
+	};
+
+	struct JournalHeader {
+		std::array<char, 4> magic {};
+		uint32_t version = 0;
+		uint64_t baseSize = 0;
+		int64_t baseTime = 0;
+	};
+
+	struct RecordHeader {
+		uint8_t kind = 0;
+		uint32_t rawSize = 0;
+		uint32_t storedSize = 0;
+		uint32_t checksum = 0; // crc32 of the stored bytes
+	};
+
+	bool stampMap(const std::filesystem::path &map_path, JournalHeader &header) {
+		std::error_code ec;
+		header.magic = JournalMagic;
+		header.version = JournalVersion;
+		header.baseSize = std::filesystem::file_size(map_path, ec);
+		if (!ec) {
+			header.baseTime = std::filesystem::last_write_time(map_path, ec).time_since_epoch().count();
+		}
+		return !ec;
+	}
+
+	bool writeRecord(std::ofstream &file, uint8_t kind, const std::vector<uint8_t> &raw) {
+		uLongf storedSize = compressBound(static_cast<uLong>(raw.size()));
+		std::vector<uint8_t> stored(storedSize);
+		if (compress2(stored.data(), &storedSize, raw.data(), static_cast<uLong>(raw.size()), Z_BEST_SPEED) != Z_OK) {
+			return false;
+		}
+
+		RecordHeader header;
+		header.kind = kind;
+		header.rawSize = static_cast<uint32_t>(raw.size());
+		header.storedSize = static_cast<uint32_t>(storedSize);
+		header.checksum = static_cast<uint32_t>(crc32(0, stored.data(), static_cast<uInt>(storedSize)));
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(stored.data()), static_cast<std::streamsize>(storedSize));
+		// Handed to the system right away, so the record survives the editor crashing
+		file.flush();
+		return file.good();
+	}
+}
+
+EditJournalContents::~EditJournalContents() {
+	for (const auto &[position, tile] : tiles) {
+		delete tile;
+	}
+}
+
+EditJournal::~EditJournal() {
+	close();
+}
+
+std::filesystem::path EditJournal::getPath(const std::filesystem::path &map_path) {
+	std::filesystem::path path = map_path;
+	path += JournalExtension;
+	return path;
+}
+
+bool EditJournal::open(const std::filesystem::path &map_path) {
+	close();
+
+	JournalHeader header;
+	if (!stampMap(map_path, header)) {
+		return false;
+	}
+
+	path = getPath(map_path);
+	file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		spdlog::warn("[EditJournal] - Unable to create {}, edits of this map will not be recoverable", path.string());
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.flush();
+	this->map_path = map_path;
+	base_size = header.baseSize;
+	base_time = header.baseTime;
+	return true;
+}
+
+void EditJournal::close(bool keep) {
+	if (!file.is_open()) {
+		return;
+	}
+
+	file.close();
+	if (!keep) {
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+	}
+
+	since_checkpoint = 0;
+	dirty_tiles.clear();
+	dirty_houses.clear();
+	dirty_waypoints.clear();
+}
+
+void EditJournal::record(Map &map, const BatchAction &batch) {
+	if (!file.is_open()) {
+		return;
+	}
+
+	std::vector<Position> tiles;
+	std::vector<uint32_t> houses;
+	std::vector<std::string> waypoints;
+	for (const Action* action : batch.batch) {
+		for (const Change* change : action->changes) {
+			switch (change->getType()) {
+				case CHANGE_TILE:
+					tiles.push_back(reinterpret_cast<const Tile*>(change->getData())->getPosition());
+					break;
+				case CHANGE_TILE_DELTA:
+					tiles.push_back(reinterpret_cast<const TileDelta*>(change->getData())->tile->getPosition());
+					break;
+				case CHANGE_MOVE_HOUSE_EXIT:
+					houses.push_back(reinterpret_cast<const HouseData*>(change->getData())->id);
+					break;
+				case CHANGE_MOVE_WAYPOINT:
+					waypoints.push_back(reinterpret_cast<const WaypointData*>(change->getData())->id);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	if (tiles.empty() && houses.empty() && waypoints.empty()) {
+		return;
+	}
+
+	std::sort(tiles.begin(), tiles.end());
+	tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+	dirty_tiles.insert(tiles.begin(), tiles.end());
+	dirty_houses.insert(houses.begin(), houses.end());
+	dirty_waypoints.insert(waypoints.begin(), waypoints.end());
+
+	if (++since_checkpoint >= CheckpointInterval && checkpoint(map)) {
+		return;
+	}
+
+	if (!append(file, map, JOURNAL_RECORD_CHANGES, tiles, houses, waypoints)) {
+		spdlog::warn("[EditJournal] - Unable to write to {}, edits of this map will not be recoverable", path.string());
+		close(true);
+	}
+}
+
+bool EditJournal::append(std::ofstream &stream, Map &map, uint8_t kind, const std::vector<Position> &tiles, const std::vector<uint32_t> &houses, const std::vector<std::string> &waypoints) {
+	TileRecordWriter writer;
+	writer.put<uint32_t>(static_cast<uint32_t>(tiles.size()));
+	for (const Position &position : tiles) {
+		const Tile* tile = map.getTile(position);
+		writer.put<uint8_t>(tile != nullptr);
+		if (tile) {
+			writer.putTile(tile);
+		} else {
+			writer.putPosition(position);
+		}
+	}
+
+	std::vector<const House*> exits;
+	for (const uint32_t id : houses) {
+		if (const House* house = map.houses.getHouse(id)) {
+			exits.push_back(house);
+		}
+	}
+	writer.put<uint32_t>(static_cast<uint32_t>(exits.size()));
+	for (const House* house : exits) {
+		writer.put<uint32_t>(house->id);
+		writer.putPosition(house->getExit());
+	}
+
+	std::vector<const Waypoint*> moved;
+	for (const std::string &name : waypoints) {
+		if (const Waypoint* waypoint = map.waypoints.getWaypoint(name)) {
+			moved.push_back(waypoint);
+		}
+	}
+	writer.put<uint32_t>(static_cast<uint32_t>(moved.size()));
+	for (const Waypoint* waypoint : moved) {
+		writer.putString(waypoint->name);
+		writer.putPosition(waypoint->pos);
+	}
+
+	return writeRecord(stream, kind, writer.data());
+}
+
+bool EditJournal::checkpoint(Map &map) {
+	JournalHeader header;
+	header.magic = JournalMagic;
+	header.version = JournalVersion;
+	header.baseSize = base_size;
+	header.baseTime = base_time;
+
+	// Written aside and renamed, so a crash leaves either journal intact
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::out | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		const std::vector<Position> tiles(dirty_tiles.begin(), dirty_tiles.end());
+		const std::vector<uint32_t> houses(dirty_houses.begin(), dirty_houses.end());
+		const std::vector<std::string> waypoints(dirty_waypoints.begin(), dirty_waypoints.end());
+		if (!stream.is_open() || !append(stream, map, JOURNAL_RECORD_CHECKPOINT, tiles, houses, waypoints)) {
+			stream.close();
+			std::error_code ec;
+			std::filesystem::remove(temporary, ec);
+			spdlog::warn("[EditJournal] - Unable to write a checkpoint of {}", path.string());
+			return false;
+		}
+	}
+
+	file.close();
+	std::error_code ec;
+	std::filesystem::rename(temporary, path, ec);
+	if (ec) {
+		std::filesystem::remove(temporary, ec);
+	}
+
+	file.open(path, std::ios::binary | std::ios::out | std::ios::app);
+	since_checkpoint = 0;
+	return !ec;
+}
+
+bool EditJournal::read(const std::filesystem::path &path, const std::filesystem::path &map_path, BaseMap &map, EditJournalContents &contents) {
+	std::ifstream stream(path, std::ios::binary | std::ios::in);
+	if (!stream.is_open()) {
+		return false;
+	}
+
+	JournalHeader header;
+	JournalHeader expected;
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) || !stampMap(map_path, expected)) {
+		return false;
+	}
+	if (header.magic != JournalMagic || header.version != JournalVersion) {
+		spdlog::warn("[EditJournal::read] - {} is not a journal of this editor version", path.string());
+		return false;
+	}
+	if (header.baseSize != expected.baseSize || header.baseTime != expected.baseTime) {
+		spdlog::info("[EditJournal::read] - {} was written against another save of the map", path.string());
+		return false;
+	}
+
+	RecordHeader record;
+	while (true) {
+		if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+			contents.truncated = stream.gcount() > 0;
+			break;
+		}
+
+		std::vector<uint8_t> stored(record.storedSize);
+		if (!stream.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size()))
+			|| crc32(0, stored.data(), static_cast<uInt>(stored.size())) != record.checksum) {
+			contents.truncated = true;
+			break;
+		}
+
+		std::vector<uint8_t> raw(record.rawSize);
+		uLongf rawSize = record.rawSize;
+		if (uncompress(raw.data(), &rawSize, stored.data(), static_cast<uLong>(stored.size())) != Z_OK || rawSize != record.rawSize) {
+			contents.truncated = true;
+			break;
+		}
+
+		// Parsed aside, so a bad record leaves the contents of the ones before it
+		EditJournalContents parsed;
+		TileRecordReader reader(map, raw);
+		const uint32_t tiles = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < tiles && reader.ok(); ++i) {
+			if (reader.get<uint8_t>()) {
+				Tile* tile = reader.getTile();
+				if (tile) {
+					delete std::exchange(parsed.tiles[tile->getPosition()], tile);
+				}
+			} else {
+				delete std::exchange(parsed.tiles[reader.getPosition()], nullptr);
+			}
+		}
+
+		const uint32_t houses = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < houses && reader.ok(); ++i) {
+			const uint32_t id = reader.get<uint32_t>();
+			parsed.house_exits[id] = reader.getPosition();
+		}
+
+		const uint32_t waypoints = reader.get<uint32_t>();
+		for (uint32_t i = 0; i < waypoints && reader.ok(); ++i) {
+			std::string name = reader.getString();
+			parsed.waypoints[std::move(name)] = reader.getPosition();
+		}
+
+		if (!reader.ok() || !reader.finished()) {
+			contents.truncated = true;
+			break;
+		}
+
+		for (auto &[position, tile] : parsed.tiles) {
+			delete std::exchange(contents.tiles[position], std::exchange(tile, nullptr));
+		}
+		for (const auto &[id, exit] : parsed.house_exits) {
+			contents.house_exits[id] = exit;
+		}
+		for (const auto &[name, position] : parsed.waypoints) {
+			contents.waypoints[name] = position;
+		}
+		++contents.records;
+	}
+	return true;
+}
+
+#ifdef RME_DEVELOPER_TOOLS
+namespace {
+	std::vector<uint8_t> encodeTile(const Tile* tile) {
+		TileRecordWriter writer;
+		if (tile) {
+			writer.putTile(tile);
+		}
+		return std::move(writer.data());
+	}
+
+	// Compares a replayed journal with what the map holds at the sampled positions
+	size_t countDifferences(Map &map, const std::vector<Position> &samples, const Position &erased, const EditJournalContents &contents, std::string &report) {
+		size_t differences = 0;
+		for (const Position &position : samples) {
+			const auto it = contents.tiles.find(position);
+			if (it == contents.tiles.end() || encodeTile(it->second) != encodeTile(map.getTile(position))) {
+				if (++differences <= 10) {
+					report += std::format("  Tile {}, {}, {} does not match the map\n", position.x, position.y, position.z);
+				}
+			}
+		}
+		if (erased.isValid()) {
+			const auto it = contents.tiles.find(erased);
+			if (it == contents.tiles.end() || it->second) {
+				++differences;
+				report += std::format("  Removed tile {}, {}, {} was not replayed as removed\n", erased.x, erased.y, erased.z);
+			}
+		}
+		for (const auto &[id, exit] : contents.house_exits) {
+			const House* house = map.houses.getHouse(id);
+			if (!house || house->getExit() != exit) {
+				++differences;
+				report += std::format("  Exit of house {} does not match the map\n", id);
+			}
+		}
+		for (const auto &[name, position] : contents.waypoints) {
+			const Waypoint* waypoint = map.waypoints.getWaypoint(name);
+			if (!waypoint || waypoint->pos != position) {
+				++differences;
+				report += std::format("  Waypoint {} does not match the map\n", name);
+			}
+		}
+		return differences;
+	}
+}
+
+bool EditJournal::check(Map &map, std::string &report) {
+	constexpr size_t SampleCount = 4096;
+	constexpr size_t TilesPerRecord = 64;
+
+	std::vector<Position> samples;
+	const size_t step = std::max<size_t>(1, map.getTileCount() / SampleCount);
+	size_t index = 0;
+	for (MapIterator it = map.begin(); it != map.end(); ++it, ++index) {
+		if (index % step == 0) {
+			samples.push_back((*it)->getPosition());
+		}
+	}
+	if (samples.empty()) {
+		report = "The map has no tiles to journal.\n";
+		return false;
+	}
+
+	// A position next to a sampled tile that has none, journaled as a removal
+	Position erased;
+	for (const Position &position : samples) {
+		const Position next(position.x + 1, position.y, position.z);
+		if (!map.getTile(next)) {
+			erased = next;
+			break;
+		}
+	}
+
+	std::vector<uint32_t> houses;
+	for (const auto &[id, house] : map.houses) {
+		houses.push_back(id);
+		if (houses.size() == 16) {
+			break;
+		}
+	}
+	std::vector<std::string> waypoints;
+	for (const auto &[name, waypoint] : map.waypoints) {
+		waypoints.push_back(name);
+		if (waypoints.size() == 16) {
+			break;
+		}
+	}
+
+	std::error_code ec;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "rme-journal-check";
+	std::filesystem::create_directories(directory, ec);
+	const std::filesystem::path map_path = directory / "check.otbm";
+	std::ofstream(map_path, std::ios::binary | std::ios::trunc) << "journal check";
+
+	EditJournal journal;
+	if (ec || !journal.open(map_path)) {
+		report = std::format("Unable to create a journal in {}.\n", directory.string());
+		return false;
+	}
+
+	// The first half goes in a checkpoint, the second half is appended after it
+	const size_t half = samples.size() / 2;
+	bool written = true;
+	const auto journalTiles = [&](size_t first, size_t last) {
+		for (size_t i = first; i < last && written; i += TilesPerRecord) {
+			const std::vector<Position> tiles(samples.begin() + i, samples.begin() + std::min(last, i + TilesPerRecord));
+			journal.dirty_tiles.insert(tiles.begin(), tiles.end());
+			written = append(journal.file, map, JOURNAL_RECORD_CHANGES, tiles, {}, {});
+		}
+	};
+
+	journalTiles(0, half);
+	if (erased.isValid()) {
+		journal.dirty_tiles.insert(erased);
+		written = written && append(journal.file, map, JOURNAL_RECORD_CHANGES, { erased }, {}, {});
+	}
+	journal.dirty_houses.insert(houses.begin(), houses.end());
+	journal.dirty_waypoints.insert(waypoints.begin(), waypoints.end());
+	written = written && journal.checkpoint(map);
+	journalTiles(half, samples.size());
+	written = written && append(journal.file, map, JOURNAL_RECORD_CHANGES, {}, houses, waypoints);
+	// The checkpoint, the records of the second half and the houses and waypoints
+	const size_t appended = 1 + (samples.size() - half + TilesPerRecord - 1) / TilesPerRecord + 1;
+	const std::filesystem::path path = journal.path;
+	journal.close(true);
+
+	bool passed = written;
+	if (!written) {
+		report += "Writing the journal failed.\n";
+	}
+
+	EditJournalContents contents;
+	BaseMap scratch;
+	if (passed && !read(path, map_path, scratch, contents)) {
+		report += "The journal was refused by its own map file.\n";
+		passed = false;
+	} else if (passed) {
+		report += std::format("Replayed {} records holding {} tiles after a checkpoint.\n", contents.records, contents.tiles.size());
+		if (contents.records != appended || contents.truncated) {
+			report += std::format("  Expected {} whole records, read {}{}\n", appended, contents.records, contents.truncated ? " and a torn one" : "");
+			passed = false;
+		}
+		if (const size_t differences = countDifferences(map, samples, erased, contents, report)) {
+			report += std::format("  {} differences with the map\n", differences);
+			passed = false;
+		}
+	}
+
+	// A record cut short or damaged by the crash must be dropped, and only that one
+	const uintmax_t size = std::filesystem::file_size(path, ec);
+	const std::filesystem::path torn = directory / "torn.journal";
+	for (const bool cut : { true, false }) {
+		std::filesystem::copy_file(path, torn, std::filesystem::copy_options::overwrite_existing, ec);
+		if (cut) {
+			std::filesystem::resize_file(torn, size - 1, ec);
+		} else {
+			std::fstream damage(torn, std::ios::binary | std::ios::in | std::ios::out);
+			damage.seekg(static_cast<std::streamoff>(size - 1));
+			const char last = static_cast<char>(damage.get());
+			damage.seekp(static_cast<std::streamoff>(size - 1));
+			damage.put(static_cast<char>(~last));
+		}
+
+		EditJournalContents partial;
+		BaseMap partialMap;
+		const bool read_torn = !ec && read(torn, map_path, partialMap, partial);
+		const char* what = cut ? "cut" : "damaged";
+		if (!read_torn || !partial.truncated || partial.records != appended - 1) {
+			report += std::format("A {} last record was not dropped alone ({} of {} records read).\n", what, partial.records, appended);
+			passed = false;
+		} else {
+			report += std::format("A {} last record was dropped, {} records kept.\n", what, partial.records);
+		}
+	}
+
+	// Saving the map again changes its stamp, so the journal no longer applies
+	std::ofstream(map_path, std::ios::binary | std::ios::app) << '\n';
+	EditJournalContents stale;
+	BaseMap staleMap;
+	if (read(path, map_path, staleMap, stale)) {
+		report += "The journal was replayed against a changed map file.\n";
+		passed = false;
+	} else {
+		report += "The journal was refused once the map file changed.\n";
+	}
+
+	std::filesystem::remove_all(directory, ec);
+	return passed;
+}
+#endif
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_EDIT_JOURNAL_H_
+#define RME_EDIT_JOURNAL_H_
+
+#include "position.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class BaseMap;
+class Map;
+class Tile;
+class BatchAction;
+
+// What a journal leaves behind once all of its records are applied, in the
+// order they were written. Owns the tiles until they are taken.
+struct EditJournalContents {
+	EditJournalContents() = default;
+	~EditJournalContents();
+
+	EditJournalContents(const EditJournalContents &) = delete;
+	EditJournalContents &operator=(const EditJournalContents &) = delete;
+
+	bool empty() const noexcept {
+		return tiles.empty() && house_exits.empty() && waypoints.empty();
+	}
+
+	std::map<Position, Tile*> tiles; // nullptr when the position ends up without a tile
+	std::map<uint32_t, Position> house_exits;
+	std::map<std::string, Position> waypoints;
+	size_t records = 0;
+	bool truncated = false; // a torn record at the end, from the crash itself, was skipped
+};
+
+// Write-ahead journal of the edits made since a map was last saved, kept
+// next to the map file. Every batch committed, undone or redone appends the
+// state it left at the positions it touched; every CheckpointInterval
+// records the journal is rewritten as a single record holding the current
+// state of everything touched since the save, so its size follows the
+// edited area rather than the length of the session. The header stores the
+// size and time of the saved map, so a journal is only offered for the
+// file it was written against.
+//
+// Reading needs only a BaseMap and the item database, so recorded journals
+// can be replayed without the editor windows.
+class EditJournal {
+public:
+	static constexpr size_t CheckpointInterval = 256;
+
+	EditJournal() = default;
+	~EditJournal();
+
+	EditJournal(const EditJournal &) = delete;
+	EditJournal &operator=(const EditJournal &) = delete;
+
+	static std::filesystem::path getPath(const std::filesystem::path &map_path);
+
+	// Starts an empty journal for the map saved at map_path, replacing any journal there
+	bool open(const std::filesystem::path &map_path);
+	// Stops journaling; the file is removed unless kept for a later recovery
+	void close(bool keep = false);
+	bool isOpen() const noexcept {
+		return file.is_open();
+	}
+
+	// Appends what the batch left on the map at the positions it changed
+	void record(Map &map, const BatchAction &batch);
+
+	// Reads the journal at path if it was written against the map file as it is now
+	static bool read(const std::filesystem::path &path, const std::filesystem::path &map_path, BaseMap &map, EditJournalContents &contents);
+
+#ifdef RME_DEVELOPER_TOOLS
+	// Journals tiles sampled from map in a scratch directory, with a checkpoint
+	// halfway, and reads it back: the replayed tiles must encode like the map's,
+	// a cut or damaged last record must be dropped alone and a journal must be
+	// refused once its map file changed. Findings go to report.
+	static bool check(Map &map, std::string &report);
+#endif
+
+private:
+	static bool append(std::ofstream &stream, Map &map, uint8_t kind, const std::vector<Position> &tiles, const std::vector<uint32_t> &houses, const std::vector<std::string> &waypoints);
+	// Rewrites the journal as one record of everything touched since the save
+	bool checkpoint(Map &map);
+
+	std::filesystem::path path;
+	std::filesystem::path map_path;
+	uint64_t base_size = 0;
+	int64_t base_time = 0;
+	std::ofstream file;
+	size_t since_checkpoint = 0;
+
+	std::set<Position> dirty_tiles;
+	std::set<uint32_t> dirty_houses;
+	std::set<std::string> dirty_waypoints;
+};
+
+#endif
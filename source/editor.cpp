@@ -45,6 +45,7 @@
 
 #include <filesystem>
 #include <chrono>
+#include <format>
 #include <iostream>
 
 namespace fs = std::filesystem;
@@ -130,6 +131,11 @@ Editor::Editor(CopyBuffer &copybuffer, const FileName &fn) :
 	if (success) {
 		ScopedLoadingBar LoadingBar("Loading OTBM map...");
 		success = map.open(nstr(fn.GetFullPath()));
+		// Only maps opened for editing get an item index and tile counters, not those opened to be imported
+		if (success) {
+			map.getItemIndex();
+			map.getTileCounters();
+		}
 	}
 }
 
@@ -455,6 +461,70 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 	deleteOldBackups(map_path + "backups/");
 
 	clearChanges();
+
+	// The saved map is the new base of the edit journal
+	if (g_settings.getBoolean(Config::EDIT_JOURNAL) && !IsLive()) {
+		journal.open(map.filename);
+	} else {
+		journal.close();
+	}
+}
+
+void Editor::startJournal() {
+	if (!g_settings.getBoolean(Config::EDIT_JOURNAL) || IsLive() || !map.hasFile()) {
+		return;
+	}
+
+	const fs::path map_path = map.filename;
+	const fs::path journal_path = EditJournal::getPath(map_path);
+
+	std::error_code ec;
+	EditJournalContents contents;
+	bool recover = false;
+	if (fs::exists(journal_path, ec) && EditJournal::read(journal_path, map_path, map, contents) && !contents.empty()) {
+		const std::string message = std::format(
+			"{} was not closed properly last time. {} changed tiles from that session can be replayed onto the saved map{}.\n\nRecover these edits?",
+			map.name, contents.tiles.size(), contents.truncated ? " (the last change before the crash is incomplete and will be skipped)" : ""
+		);
+		recover = g_gui.PopupDialog("Recover Edits", wxstr(message), wxYES | wxNO) == wxID_YES;
+	}
+
+	// Replaces the old journal; the replayed edits go to the new one
+	journal.open(map_path);
+	if (recover) {
+		replayJournal(contents);
+	}
+}
+
+void Editor::replayJournal(EditJournalContents &contents) {
+	const auto start = std::chrono::steady_clock::now();
+
+	BatchAction* batch = actionQueue->createBatch(ACTION_RECOVER_JOURNAL);
+	Action* action = actionQueue->createAction(batch);
+	for (auto &[position, tile] : contents.tiles) {
+		Tile* recovered = tile ? std::exchange(tile, nullptr) : map.allocator(map.createTileL(position));
+		recovered->deselect();
+		action->addChange(newd Change(recovered));
+	}
+	for (const auto &[id, exit] : contents.house_exits) {
+		if (House* house = map.houses.getHouse(id)) {
+			action->addChange(Change::Create(house, exit));
+		}
+	}
+	for (const auto &[name, position] : contents.waypoints) {
+		if (Waypoint* waypoint = map.waypoints.getWaypoint(name)) {
+			action->addChange(Change::Create(waypoint, position));
+		}
+	}
+
+	const size_t changes = action->size();
+	batch->addAndCommitAction(action);
+	addBatch(batch);
+	updateActions();
+	g_gui.RefreshView();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	spdlog::info("Recovered {} changes from {} journal records of {} in {:.2f}s", changes, contents.records, map.filename, seconds);
 }
 
 bool Editor::importMiniMap(FileName filename, int import, int import_x_offset, int import_y_offset, int import_z_offset) {
@@ -815,6 +885,9 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 		map.addSpawnNpc(tile);
 	}
 
+	// Spawns are attached to tiles that are already placed
+	map.invalidateTileIndexes();
+
 	g_gui.DestroyLoadBar();
 
 	map.setWidth(newsize_x);
@@ -862,6 +935,10 @@ void Editor::borderizeMap(bool showdialog) {
 		++tiles_done;
 	}
 
+	// Borders were changed on the tiles in place; done after the loop, as the
+	// views may repaint while the load bar is shown
+	map.invalidateTileIndexes();
+
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
 	}
@@ -933,6 +1010,9 @@ void Editor::randomizeMap(bool showdialog) {
 		++tiles_done;
 	}
 
+	// Grounds were redrawn on the tiles in place
+	map.invalidateTileIndexes();
+
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
 	}
@@ -998,253 +1078,17 @@ void Editor::clearModifiedTileState(bool showdialog) {
 	}
 }
 
-void Editor::moveSelection(const Position &offset) {
+SelectionMoveStats Editor::moveSelection(const Position &offset) {
 	if (!CanEdit() || !hasSelection()) {
-		return;
-	}
-
-	bool borderize = false;
-	int drag_threshold = g_settings.getInteger(Config::BORDERIZE_DRAG_THRESHOLD);
-	bool create_borders = g_settings.getInteger(Config::USE_AUTOMAGIC)
-		&& g_settings.getInteger(Config::BORDERIZE_DRAG);
-
-	TileSet storage;
-	BatchAction* batch_action = actionQueue->createBatch(ACTION_MOVE);
-	Action* action = actionQueue->createAction(batch_action);
-
-	// Update the tiles with the new positions
-	for (Tile* tile : selection) {
-		Tile* new_tile = tile->deepCopy(map);
-		Tile* storage_tile = map.allocator(tile->getLocation());
-
-		ItemVector selected_items = new_tile->popSelectedItems();
-		for (Item* item : selected_items) {
-			storage_tile->addItem(item);
-		}
-
-		// Move monster spawns
-		if (new_tile->spawnMonster && new_tile->spawnMonster->isSelected()) {
-			storage_tile->spawnMonster = new_tile->spawnMonster;
-			new_tile->spawnMonster = nullptr;
-		}
-		// Move monster
-		const auto monstersSelection = new_tile->popSelectedMonsters();
-		std::ranges::for_each(monstersSelection, [&](const auto monster) {
-			storage_tile->addMonster(monster);
-		});
-		// Move npc
-		if (new_tile->npc && new_tile->npc->isSelected()) {
-			storage_tile->npc = new_tile->npc;
-			new_tile->npc = nullptr;
-		}
-		// Move npc spawns
-		if (new_tile->spawnNpc && new_tile->spawnNpc->isSelected()) {
-			storage_tile->spawnNpc = new_tile->spawnNpc;
-			new_tile->spawnNpc = nullptr;
-		}
-
-		if (storage_tile->ground) {
-			storage_tile->house_id = new_tile->house_id;
-			new_tile->house_id = 0;
-			storage_tile->setMapFlags(new_tile->getMapFlags());
-			new_tile->setMapFlags(TILESTATE_NONE);
-			borderize = true;
-		}
-
-		storage.insert(storage_tile);
-		action->addChange(new Change(new_tile));
-	}
-	batch_action->addAndCommitAction(action);
-
-	// Remove old borders (and create some new?)
-	if (create_borders && selection.size() < static_cast<size_t>(drag_threshold)) {
-		action = actionQueue->createAction(batch_action);
-		TileList borderize_tiles;
-		// Go through all modified (selected) tiles (might be slow)
-		for (const Tile* tile : storage) {
-			const Position &pos = tile->getPosition();
-			// Go through all neighbours
-			Tile* t;
-			t = map.getTile(pos.x, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-		}
-
-		// Remove duplicates
-		borderize_tiles.sort();
-		borderize_tiles.unique();
-
-		// Create borders
-		for (const Tile* tile : borderize_tiles) {
-			Tile* new_tile = tile->deepCopy(map);
-			if (borderize) {
-				new_tile->borderize(&map);
-			}
-			new_tile->wallize(&map);
-			new_tile->tableize(&map);
-			new_tile->carpetize(&map);
-			if (tile->ground && tile->ground->isSelected()) {
-				new_tile->selectGround();
-			}
-			action->addChange(new Change(new_tile));
-		}
-		batch_action->addAndCommitAction(action);
-	}
-
-	// New action for adding the destination tiles
-	action = actionQueue->createAction(batch_action);
-	for (Tile* tile : storage) {
-		const Position &old_pos = tile->getPosition();
-		Position new_pos = old_pos - offset;
-		if (new_pos.z < rme::MapMinLayer && new_pos.z > rme::MapMaxLayer) {
-			delete tile;
-			continue;
-		}
-
-		TileLocation* location = map.createTileL(new_pos);
-		Tile* old_dest_tile = location->get();
-		Tile* new_dest_tile = nullptr;
-
-		if (!tile->ground || g_settings.getInteger(Config::MERGE_MOVE)) {
-			// Move items
-			if (old_dest_tile) {
-				new_dest_tile = old_dest_tile->deepCopy(map);
-			} else {
-				new_dest_tile = map.allocator(location);
-			}
-			new_dest_tile->merge(tile);
-			delete tile;
-		} else {
-			// Replace tile instead of just merge
-			tile->setLocation(location);
-			new_dest_tile = tile;
-		}
-		action->addChange(new Change(new_dest_tile));
-	}
-	batch_action->addAndCommitAction(action);
-
-	if (create_borders && selection.size() < static_cast<size_t>(drag_threshold)) {
-		action = actionQueue->createAction(batch_action);
-		TileList borderize_tiles;
-		// Go through all modified (selected) tiles (might be slow)
-		for (Tile* tile : selection) {
-			bool add_me = false; // If this tile is touched
-			const Position &pos = tile->getPosition();
-			// Go through all neighbours
-			Tile* t;
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			if (add_me) {
-				borderize_tiles.push_back(tile);
-			}
-		}
-
-		// Remove duplicates
-		borderize_tiles.sort();
-		borderize_tiles.unique();
-
-		// Create borders
-		for (const Tile* tile : borderize_tiles) {
-			if (!tile || !tile->ground) {
-				continue;
-			}
-			if (tile->ground->getGroundBrush()) {
-				Tile* new_tile = tile->deepCopy(map);
-				if (borderize) {
-					new_tile->borderize(&map);
-				}
-				new_tile->wallize(&map);
-				new_tile->tableize(&map);
-				new_tile->carpetize(&map);
-				if (tile->ground->isSelected()) {
-					new_tile->selectGround();
-				}
-				action->addChange(new Change(new_tile));
-			}
-		}
-		batch_action->addAndCommitAction(action);
+		return {};
 	}
 
+	SelectionMover mover(*this, offset);
 	// Store the action for undo
-	addBatch(batch_action);
+	addBatch(mover.run());
 	updateActions();
 	selection.updateSelectionCount();
+	return mover.getStats();
 }
 
 void Editor::destroySelection() {
@@ -1259,7 +1103,7 @@ void Editor::destroySelection() {
 		BatchAction* batch = actionQueue->createBatch(ACTION_DELETE_TILES);
 		Action* action = actionQueue->createAction(batch);
 
-		for (TileSet::iterator it = selection.begin(); it != selection.end(); ++it) {
+		for (auto it = selection.begin(); it != selection.end(); ++it) {
 			tile_count++;
 
 			Tile* tile = *it;
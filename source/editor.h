@@ -25,6 +25,8 @@
 
 #include "action.h"
 #include "selection.h"
+#include "selection_move.h"
+#include "edit_journal.h"
 
 class BaseMap;
 class CopyBuffer;
@@ -77,6 +79,13 @@ public: // Functions
 	// Map handling
 	void saveMap(FileName filename, bool showdialog); // "" means default filename
 
+	// Offers to replay the journal left by a session that did not end
+	// cleanly, then starts journaling the edits of this map
+	void startJournal();
+	EditJournal &getJournal() noexcept {
+		return journal;
+	}
+
 	Map &getMap() noexcept {
 		return map;
 	}
@@ -127,7 +136,7 @@ public: // Functions
 	}
 	// Some simple actions that work on the map (these will work through the undo queue)
 	// Moves the selected area by the offset
-	void moveSelection(const Position &offset);
+	SelectionMoveStats moveSelection(const Position &offset);
 	// Deletes all selected items
 	void destroySelection();
 	// Borderizes the selected region
@@ -159,6 +168,7 @@ protected:
 	void drawInternal(const Position offset, bool alt, bool dodraw);
 	void drawInternal(const PositionVector &posvec, bool alt, bool dodraw);
 	void drawInternal(const PositionVector &todraw, PositionVector &toborder, bool alt, bool dodraw);
+	void replayJournal(EditJournalContents &contents);
 
 	Editor(const Editor &);
 	Editor &operator=(const Editor &);
@@ -168,6 +178,7 @@ private:
 	Map map;
 	Selection selection;
 	ActionQueue* actionQueue;
+	EditJournal journal;
 };
 
 inline void Editor::draw(const Position &offset, bool alt) {
@@ -53,6 +53,7 @@ static void* rmeGetGLProc(const char* name) {
 #endif
 
 std::vector<GLRenderer*> GLRenderer::s_instances;
+uint64_t GLRenderer::s_textureGeneration = 0;
 
 static const char* const vertSrc = R"(
 #version 330
@@ -769,28 +770,52 @@ void GLRenderer::setColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
 	font.textColor = { r, g, b, a };
 }
 
-void GLRenderer::mergeCommands() {
-	if (commandList.size() <= 1) {
+void GLRenderer::mergeCommands(std::vector<DrawCommand> &commands) {
+	if (commands.size() <= 1) {
 		return;
 	}
 	size_t write = 0;
-	for (size_t read = 1; read < commandList.size(); ++read) {
-		if (commandList[write].state == commandList[read].state && commandList[write].isQuadBatch == commandList[read].isQuadBatch) {
-			auto &src = commandList[read].vertices;
-			auto &dst = commandList[write].vertices;
+	for (size_t read = 1; read < commands.size(); ++read) {
+		if (commands[write].state == commands[read].state && commands[write].isQuadBatch == commands[read].isQuadBatch) {
+			auto &src = commands[read].vertices;
+			auto &dst = commands[write].vertices;
 			dst.insert(dst.end(), src.begin(), src.end());
 		} else {
 			++write;
 			if (write != read) {
-				commandList[write] = std::move(commandList[read]);
+				commands[write] = std::move(commands[read]);
 			}
 		}
 	}
-	commandList.resize(write + 1);
+	commands.resize(write + 1);
+}
+
+void GLRenderer::beginRecording() {
+	recordingStart = commandList.size();
+}
+
+GLRenderer::Recording GLRenderer::endRecording() {
+	const size_t start = std::min(recordingStart, commandList.size());
+	Recording recording(std::make_move_iterator(commandList.begin() + start), std::make_move_iterator(commandList.end()));
+	commandList.resize(start);
+	recordingStart = 0;
+
+	mergeCommands(recording);
+	return recording;
+}
+
+void GLRenderer::replay(const Recording &recording, float dx, float dy) {
+	for (const DrawCommand &recorded : recording) {
+		DrawCommand &cmd = commandList.emplace_back(recorded);
+		for (Vertex &vertex : cmd.vertices) {
+			vertex.x += dx;
+			vertex.y += dy;
+		}
+	}
 }
 
 void GLRenderer::flushCommands() {
-	mergeCommands();
+	mergeCommands(commandList);
 
 	unsigned int currentBlendSrc = 0;
 	unsigned int currentBlendDst = 0;
@@ -880,6 +905,7 @@ void GLRenderer::flush() {
 }
 
 void GLRenderer::invalidateTexture(GLuint id) {
+	++s_textureGeneration;
 	for (auto* inst : s_instances) {
 		if (inst->current_texture == id) {
 			inst->current_texture = 0;
@@ -952,3 +978,15 @@ void GLRenderer::blitFBO(float w, float h) {
 	drawTexturedQuad(0, 0, w, h, fboData.texture, { 255, 255, 255, 255 }, 0.f, 1.f, 1.f, 0.f);
 	flush();
 }
+
+void GLRenderer::setScissor(int x, int y, int w, int h) {
+	// Batched geometry must hit the framebuffer before the clip rect changes
+	flush();
+	glScissor(x, y, w, h);
+	glEnable(GL_SCISSOR_TEST);
+}
+
+void GLRenderer::clearScissor() {
+	flush();
+	glDisable(GL_SCISSOR_TEST);
+}
@@ -20,6 +20,34 @@ struct GLColor {
 
 class GLRenderer {
 public:
+	struct Vertex {
+		float x;
+		float y;
+		float u;
+		float v;
+		uint8_t r;
+		uint8_t g;
+		uint8_t b;
+		uint8_t a;
+	};
+
+	struct DrawState {
+		GLuint textureId = 0;
+		unsigned int blendSrc = 0;
+		unsigned int blendDst = 0;
+		bool operator==(const DrawState &o) const = default;
+	};
+
+	struct DrawCommand {
+		DrawState state;
+		std::vector<Vertex> vertices;
+		bool isQuadBatch = true;
+	};
+
+	// Commands queued between beginRecording and endRecording are taken out of
+	// the frame and can be replayed later at an offset.
+	using Recording = std::vector<DrawCommand>;
+
 	void init();
 	void shutdown();
 
@@ -55,15 +83,31 @@ public:
 	void beginFBO();
 	void endFBO();
 	void blitFBO(float w, float h);
+	void setScissor(int x, int y, int w, int h);
+	void clearScissor();
 	bool hasFBO() const {
 		return fboData.fbo != 0;
 	}
 
+	void beginRecording();
+	Recording endRecording();
+	void replay(const Recording &recording, float dx, float dy);
+
 	void flush();
 	static void invalidateTexture(GLuint id);
+	// Bumped whenever a texture is deleted or sprite sheets arrive late;
+	// recordings older than this may refer to texture names that were freed
+	// or reused, or have drawn blanks for sprites that were still pending.
+	static uint64_t getTextureGeneration() noexcept {
+		return s_textureGeneration;
+	}
+	static void invalidateRecordings() noexcept {
+		++s_textureGeneration;
+	}
 
 private:
 	static std::vector<GLRenderer*> s_instances;
+	static uint64_t s_textureGeneration;
 	bool initialized = false;
 	static constexpr size_t STREAM_VBO_CAPACITY = 64 * 1024;
 	static constexpr size_t STREAM_EBO_CAPACITY = 96 * 1024;
@@ -79,34 +123,11 @@ private:
 	GLint loc_texture = -1;
 	GLint loc_stipple = -1;
 
-	struct Vertex {
-		float x;
-		float y;
-		float u;
-		float v;
-		uint8_t r;
-		uint8_t g;
-		uint8_t b;
-		uint8_t a;
-	};
-
-	struct DrawState {
-		GLuint textureId = 0;
-		unsigned int blendSrc = 0;
-		unsigned int blendDst = 0;
-		bool operator==(const DrawState &o) const = default;
-	};
-
-	struct DrawCommand {
-		DrawState state;
-		std::vector<Vertex> vertices;
-		bool isQuadBatch = true;
-	};
-
 	std::vector<Vertex> batch;
 	std::vector<GLuint> indexBatch;
 	GLuint current_texture = 0;
 	std::vector<DrawCommand> commandList;
+	size_t recordingStart = 0;
 	unsigned int activeBlendSrc = 0;
 	unsigned int activeBlendDst = 0;
 
@@ -119,7 +140,7 @@ private:
 	FBOData fboData;
 
 	void flushBatch();
-	void mergeCommands();
+	static void mergeCommands(std::vector<DrawCommand> &commands);
 	void flushCommands();
 	void drawThickLineSegment(float x1, float y1, float x2, float y2, float width, const GLColor &color);
 
@@ -26,7 +26,9 @@
 #include "gui.h"
 #include "otml.h"
 #include "sprite_appearances.h"
+#include "sprite_decode_pool.h"
 #include "sprites.h"
+#include "outfit_colorizer.h"
 #include "pngfiles.h"
 
 #include "gl_compat.h"
@@ -186,24 +188,29 @@ GraphicManager::GraphicManager() :
 	is_extended(false),
 	has_frame_durations(false),
 	has_frame_groups(false),
-	loaded_textures(0),
-	lastclean {} {
+	loaded_textures(0) {
 	animation_timer = newd wxStopWatch();
 	animation_timer->Start();
 }
 
 GraphicManager::~GraphicManager() {
-	for (SpriteMap::iterator iter = sprite_space.begin(); iter != sprite_space.end(); ++iter) {
-		delete iter->second;
-		iter->second = nullptr;
-	}
+	sprite_space.forEach([](size_t, Sprite*&sprite) {
+		delete sprite;
+		sprite = nullptr;
+	});
 
-	for (ImageMap::iterator iter = image_space.begin(); iter != image_space.end(); ++iter) {
-		delete iter->second;
-		iter->second = nullptr;
+	for (auto &[id, sprite] : editor_sprite_space) {
+		delete sprite;
+		sprite = nullptr;
 	}
 
+	image_space.forEach([](size_t, GameSprite::Image*&image) {
+		delete image;
+		image = nullptr;
+	});
+
 	sprite_space.clear();
+	editor_sprite_space.clear();
 	image_space.clear();
 
 	delete animation_timer;
@@ -217,57 +224,48 @@ GLuint GraphicManager::getFreeTextureID() {
 }
 
 void GraphicManager::clear() {
-	SpriteMap new_sprite_space;
-	for (SpriteMap::iterator iter = sprite_space.begin(); iter != sprite_space.end(); ++iter) {
-		if (iter->first >= 0) { // Don't clean internal sprites
-			delete iter->second;
-			iter->second = nullptr;
-		} else {
-			new_sprite_space.insert(std::make_pair(iter->first, iter->second));
-		}
-	}
+	// Editor sprites are internal and stay loaded
+	sprite_space.forEach([](size_t, Sprite*&sprite) {
+		delete sprite;
+		sprite = nullptr;
+	});
 
-	for (ImageMap::iterator iter = image_space.begin(); iter != image_space.end(); ++iter) {
-		delete iter->second;
-		iter->second = nullptr;
-	}
+	image_space.forEach([](size_t, GameSprite::Image*&image) {
+		delete image;
+		image = nullptr;
+	});
 
-	sprite_space.swap(new_sprite_space);
+	sprite_space.clear();
 	image_space.clear();
 	cleanup_list.clear();
 
 	item_count = 0;
 	creature_count = 0;
 	loaded_textures = 0;
-	lastclean = std::chrono::steady_clock::now();
 }
 
 void GraphicManager::cleanSoftwareSprites() {
-	for (SpriteMap::iterator iter = sprite_space.begin(); iter != sprite_space.end(); ++iter) {
-		if (iter->first >= 0) { // Don't clean internal sprites
-			iter->second->unloadDC();
+	// Editor sprites are internal and keep their DCs
+	sprite_space.forEach([](size_t, Sprite* sprite) {
+		if (sprite) {
+			sprite->unloadDC();
 		}
-	}
+	});
 }
 
 Sprite* GraphicManager::getSprite(int id) {
-	SpriteMap::iterator it = sprite_space.find(id);
-	if (it != sprite_space.end()) {
-		return it->second;
+	if (id < 0) {
+		auto it = editor_sprite_space.find(id);
+		return it != editor_sprite_space.end() ? it->second : nullptr;
 	}
-	return nullptr;
+	return sprite_space.get(id);
 }
 
 GameSprite* GraphicManager::getCreatureSprite(int id) {
 	if (id < 0) {
 		return nullptr;
 	}
-
-	SpriteMap::iterator it = sprite_space.find(id + getItemSpriteMaxID());
-	if (it != sprite_space.end()) {
-		return static_cast<GameSprite*>(it->second);
-	}
-	return nullptr;
+	return static_cast<GameSprite*>(sprite_space.get(id + getItemSpriteMaxID()));
 }
 
 uint16_t GraphicManager::getItemSpriteMaxID() const {
@@ -283,8 +281,8 @@ GameSprite* GraphicManager::getEditorSprite(int id) {
 		return nullptr;
 	}
 
-	SpriteMap::iterator it = sprite_space.find(id);
-	if (it != sprite_space.end()) {
+	auto it = editor_sprite_space.find(id);
+	if (it != editor_sprite_space.end()) {
 		return dynamic_cast<GameSprite*>(it->second);
 	}
 	return nullptr;
@@ -302,133 +300,133 @@ inline wxBitmap* _wxGetBitmapFromMemory(const unsigned char* data, int length) {
 
 bool GraphicManager::loadEditorSprites() {
 	// Unused graphics MIGHT be loaded here, but it's a neglectable loss
-	sprite_space[EDITOR_SPRITE_SELECTION_MARKER] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_SELECTION_MARKER] = newd EditorSprite(
 		newd wxBitmap(selection_marker_xpm16x16),
 		newd wxBitmap(selection_marker_xpm32x32)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_CD_1x1] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_CD_1x1] = newd EditorSprite(
 		loadPNGFile(circular_1_small_png),
 		loadPNGFile(circular_1_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_CD_3x3] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_CD_3x3] = newd EditorSprite(
 		loadPNGFile(circular_2_small_png),
 		loadPNGFile(circular_2_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_CD_5x5] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_CD_5x5] = newd EditorSprite(
 		loadPNGFile(circular_3_small_png),
 		loadPNGFile(circular_3_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_CD_7x7] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_CD_7x7] = newd EditorSprite(
 		loadPNGFile(circular_4_small_png),
 		loadPNGFile(circular_4_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_CD_9x9] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_CD_9x9] = newd EditorSprite(
 		loadPNGFile(circular_5_small_png),
 		loadPNGFile(circular_5_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_CD_15x15] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_CD_15x15] = newd EditorSprite(
 		loadPNGFile(circular_6_small_png),
 		loadPNGFile(circular_6_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_CD_19x19] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_CD_19x19] = newd EditorSprite(
 		loadPNGFile(circular_7_small_png),
 		loadPNGFile(circular_7_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_SD_1x1] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_SD_1x1] = newd EditorSprite(
 		loadPNGFile(rectangular_1_small_png),
 		loadPNGFile(rectangular_1_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_SD_3x3] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_SD_3x3] = newd EditorSprite(
 		loadPNGFile(rectangular_2_small_png),
 		loadPNGFile(rectangular_2_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_SD_5x5] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_SD_5x5] = newd EditorSprite(
 		loadPNGFile(rectangular_3_small_png),
 		loadPNGFile(rectangular_3_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_SD_7x7] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_SD_7x7] = newd EditorSprite(
 		loadPNGFile(rectangular_4_small_png),
 		loadPNGFile(rectangular_4_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_SD_9x9] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_SD_9x9] = newd EditorSprite(
 		loadPNGFile(rectangular_5_small_png),
 		loadPNGFile(rectangular_5_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_SD_15x15] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_SD_15x15] = newd EditorSprite(
 		loadPNGFile(rectangular_6_small_png),
 		loadPNGFile(rectangular_6_png)
 	);
-	sprite_space[EDITOR_SPRITE_BRUSH_SD_19x19] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_BRUSH_SD_19x19] = newd EditorSprite(
 		loadPNGFile(rectangular_7_small_png),
 		loadPNGFile(rectangular_7_png)
 	);
 
-	sprite_space[EDITOR_SPRITE_OPTIONAL_BORDER_TOOL] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_OPTIONAL_BORDER_TOOL] = newd EditorSprite(
 		loadPNGFile(optional_border_small_png),
 		loadPNGFile(optional_border_png)
 	);
-	sprite_space[EDITOR_SPRITE_ERASER] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_ERASER] = newd EditorSprite(
 		loadPNGFile(eraser_small_png),
 		loadPNGFile(eraser_png)
 	);
-	sprite_space[EDITOR_SPRITE_PZ_TOOL] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_PZ_TOOL] = newd EditorSprite(
 		loadPNGFile(protection_zone_small_png),
 		loadPNGFile(protection_zone_png)
 	);
-	sprite_space[EDITOR_SPRITE_PVPZ_TOOL] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_PVPZ_TOOL] = newd EditorSprite(
 		loadPNGFile(pvp_zone_small_png),
 		loadPNGFile(pvp_zone_png)
 	);
-	sprite_space[EDITOR_SPRITE_NOLOG_TOOL] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_NOLOG_TOOL] = newd EditorSprite(
 		loadPNGFile(no_logout_small_png),
 		loadPNGFile(no_logout_png)
 	);
-	sprite_space[EDITOR_SPRITE_NOPVP_TOOL] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_NOPVP_TOOL] = newd EditorSprite(
 		loadPNGFile(no_pvp_small_png),
 		loadPNGFile(no_pvp_png)
 	);
 
-	sprite_space[EDITOR_SPRITE_DOOR_NORMAL] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_DOOR_NORMAL] = newd EditorSprite(
 		loadPNGFile(door_normal_small_png),
 		loadPNGFile(door_normal_png)
 	);
-	sprite_space[EDITOR_SPRITE_DOOR_LOCKED] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_DOOR_LOCKED] = newd EditorSprite(
 		loadPNGFile(door_locked_small_png),
 		loadPNGFile(door_locked_png)
 	);
-	sprite_space[EDITOR_SPRITE_DOOR_MAGIC] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_DOOR_MAGIC] = newd EditorSprite(
 		loadPNGFile(door_magic_small_png),
 		loadPNGFile(door_magic_png)
 	);
-	sprite_space[EDITOR_SPRITE_DOOR_QUEST] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_DOOR_QUEST] = newd EditorSprite(
 		loadPNGFile(door_quest_small_png),
 		loadPNGFile(door_quest_png)
 	);
-	sprite_space[EDITOR_SPRITE_WINDOW_NORMAL] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_WINDOW_NORMAL] = newd EditorSprite(
 		loadPNGFile(window_normal_small_png),
 		loadPNGFile(window_normal_png)
 	);
-	sprite_space[EDITOR_SPRITE_WINDOW_HATCH] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_WINDOW_HATCH] = newd EditorSprite(
 		loadPNGFile(window_hatch_small_png),
 		loadPNGFile(window_hatch_png)
 	);
 
-	sprite_space[EDITOR_SPRITE_SELECTION_GEM] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_SELECTION_GEM] = newd EditorSprite(
 		loadPNGFile(gem_edit_png),
 		nullptr
 	);
-	sprite_space[EDITOR_SPRITE_DRAWING_GEM] = newd EditorSprite(
+	editor_sprite_space[EDITOR_SPRITE_DRAWING_GEM] = newd EditorSprite(
 		loadPNGFile(gem_move_png),
 		nullptr
 	);
 
-	sprite_space[EDITOR_SPRITE_MONSTERS] = GameSprite::createFromBitmap(ART_MONSTERS);
-	sprite_space[EDITOR_SPRITE_NPCS] = GameSprite::createFromBitmap(ART_NPCS);
-	sprite_space[EDITOR_SPRITE_HOUSE_EXIT] = GameSprite::createFromBitmap(ART_HOUSE_EXIT);
-	sprite_space[EDITOR_SPRITE_PICKUPABLE_ITEM] = GameSprite::createFromBitmap(ART_PICKUPABLE);
-	sprite_space[EDITOR_SPRITE_MOVEABLE_ITEM] = GameSprite::createFromBitmap(ART_MOVEABLE);
-	sprite_space[EDITOR_SPRITE_PICKUPABLE_MOVEABLE_ITEM] = GameSprite::createFromBitmap(ART_PICKUPABLE_MOVEABLE);
-	sprite_space[EDITOR_SPRITE_AVOIDABLE_ITEM] = GameSprite::createFromBitmap(ART_AVOIDABLE);
+	editor_sprite_space[EDITOR_SPRITE_MONSTERS] = GameSprite::createFromBitmap(ART_MONSTERS);
+	editor_sprite_space[EDITOR_SPRITE_NPCS] = GameSprite::createFromBitmap(ART_NPCS);
+	editor_sprite_space[EDITOR_SPRITE_HOUSE_EXIT] = GameSprite::createFromBitmap(ART_HOUSE_EXIT);
+	editor_sprite_space[EDITOR_SPRITE_PICKUPABLE_ITEM] = GameSprite::createFromBitmap(ART_PICKUPABLE);
+	editor_sprite_space[EDITOR_SPRITE_MOVEABLE_ITEM] = GameSprite::createFromBitmap(ART_MOVEABLE);
+	editor_sprite_space[EDITOR_SPRITE_PICKUPABLE_MOVEABLE_ITEM] = GameSprite::createFromBitmap(ART_PICKUPABLE_MOVEABLE);
+	editor_sprite_space[EDITOR_SPRITE_AVOIDABLE_ITEM] = GameSprite::createFromBitmap(ART_AVOIDABLE);
 
 	return true;
 }
@@ -586,12 +584,13 @@ bool GraphicManager::loadSpriteMetadata(const FileName &datafile, wxString &erro
 					sprite_id = u16;
 				}
 
-				if (image_space[sprite_id] == nullptr) {
+				GameSprite::Image*&image = image_space[sprite_id];
+				if (image == nullptr) {
 					GameSprite::NormalImage* img = newd GameSprite::NormalImage();
 					img->id = sprite_id;
-					image_space[sprite_id] = img;
+					image = img;
 				}
-				sType->spriteList.push_back(static_cast<GameSprite::NormalImage*>(image_space[sprite_id]));
+				sType->spriteList.push_back(static_cast<GameSprite::NormalImage*>(image));
 			}
 		}
 		++id;
@@ -778,9 +777,8 @@ bool GraphicManager::loadSpriteData(const FileName &datafile, wxString &error, w
 		uint16_t size;
 		safe_get(U16, size);
 
-		ImageMap::iterator it = image_space.find(id);
-		if (it != image_space.end()) {
-			GameSprite::NormalImage* spr = dynamic_cast<GameSprite::NormalImage*>(it->second);
+		if (GameSprite::Image* const* image = image_space.find(id); image && *image) {
+			GameSprite::NormalImage* spr = dynamic_cast<GameSprite::NormalImage*>(*image);
 			if (spr && size > 0) {
 				if (spr->size > 0) {
 					wxString ss;
@@ -881,17 +879,18 @@ bool GraphicManager::loadItemSpriteMetadata(const std::shared_ptr<ItemType> &t,
 	for (uint32_t i = 0; i < sType->numsprites; ++i) {
 		uint32_t sprite_id = t->m_sprites[i];
 
-		if (image_space[sprite_id] == nullptr) {
+		GameSprite::Image*&image = image_space[sprite_id];
+		if (image == nullptr) {
 			GameSprite::NormalImage* img = newd GameSprite::NormalImage();
 			img->id = sprite_id;
-			image_space[sprite_id] = img;
+			image = img;
 		}
-		sType->spriteList.push_back(static_cast<GameSprite::NormalImage*>(image_space[sprite_id]));
+		sType->spriteList.push_back(static_cast<GameSprite::NormalImage*>(image));
 	}
 	return true;
 }
 
-bool GraphicManager::loadOutfitSpriteMetadata(canary::protobuf::appearances::Appearance outfit, wxString &error, wxArrayString &warnings) {
+bool GraphicManager::loadOutfitSpriteMetadata(const canary::protobuf::appearances::Appearance &outfit, wxString &error, wxArrayString &warnings) {
 	GameSprite* sType = newd GameSprite();
 	sType->id = outfit.id() + getItemSpriteMaxID();
 	sprite_space[outfit.id() + getItemSpriteMaxID()] = sType;
@@ -943,12 +942,13 @@ bool GraphicManager::loadOutfitSpriteMetadata(canary::protobuf::appearances::App
 	for (uint32_t i = 0; i < sType->numsprites; ++i) {
 		uint32_t sprite_id = spriteInfo.sprite_id().Get(i);
 
-		if (image_space[sprite_id] == nullptr) {
+		GameSprite::Image*&image = image_space[sprite_id];
+		if (image == nullptr) {
 			GameSprite::NormalImage* img = newd GameSprite::NormalImage();
 			img->id = sprite_id;
-			image_space[sprite_id] = img;
+			image = img;
 		}
-		sType->spriteList.push_back(static_cast<GameSprite::NormalImage*>(image_space[sprite_id]));
+		sType->spriteList.push_back(static_cast<GameSprite::NormalImage*>(image));
 	}
 	return true;
 }
@@ -987,27 +987,9 @@ void GraphicManager::garbageCollection() {
 		return;
 	}
 
-	auto now = std::chrono::steady_clock::now();
-	if (now - lastclean <= std::chrono::seconds(g_settings.getInteger(Config::TEXTURE_CLEAN_PULSE))) {
-		return;
-	}
-
-	// Sheet GC runs independently of per-sprite texture threshold
-	auto longevity = std::chrono::seconds(g_settings.getInteger(Config::TEXTURE_LONGEVITY));
-	for (const auto &sheet : g_spriteAppearances.getSheets()) {
-		if (sheet->glTextureId != 0 && now - sheet->lastaccess > longevity) {
-			sheet->releaseGLTexture();
-		}
-	}
-
-	// Per-sprite image GC only runs when threshold is exceeded
-	if (loaded_textures > g_settings.getInteger(Config::TEXTURE_CLEAN_THRESHOLD)) {
-		for (auto iit = image_space.begin(); iit != image_space.end(); ++iit) {
-			iit->second->clean(now);
-		}
-	}
-
-	lastclean = now;
+	// Sheet buffers and textures are evicted least recently used first
+	g_residency.setBudget(static_cast<size_t>(g_settings.getInteger(Config::TEXTURE_MEMORY_BUDGET)) * 1024 * 1024);
+	g_residency.enforceBudget();
 }
 
 EditorSprite::EditorSprite(wxBitmap* b16x16, wxBitmap* b32x32) {
@@ -1062,13 +1044,13 @@ uint16_t GameSprite::getDrawHeight() const {
 
 wxPoint GameSprite::getDrawOffset() {
 	if (!isDrawOffsetLoaded && !spriteList.empty()) {
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id);
-		if (!sheet) {
+		const SpriteLocation* location = g_spriteAppearances.getSpriteLocation(spriteList[0]->id);
+		if (!location) {
 			return wxPoint(0, 0);
 		}
 
-		draw_offset.x += sheet->getSpriteSize().width - 32;
-		draw_offset.y += sheet->getSpriteSize().height - 32;
+		draw_offset.x += location->width - 32;
+		draw_offset.y += location->height - 32;
 		isDrawOffsetLoaded = true;
 	}
 
@@ -1077,10 +1059,10 @@ wxPoint GameSprite::getDrawOffset() {
 
 uint8_t GameSprite::getWidth() {
 	if (width <= 0) {
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id, false);
-		if (sheet) {
-			width = sheet->getSpriteSize().width;
-			height = sheet->getSpriteSize().height;
+		const SpriteLocation* location = g_spriteAppearances.getSpriteLocation(spriteList[0]->id);
+		if (location) {
+			width = location->width;
+			height = location->height;
 		}
 	}
 
@@ -1089,10 +1071,10 @@ uint8_t GameSprite::getWidth() {
 
 uint8_t GameSprite::getHeight() {
 	if (height <= 0) {
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id, false);
-		if (sheet) {
-			width = sheet->getSpriteSize().width;
-			height = sheet->getSpriteSize().height;
+		const SpriteLocation* location = g_spriteAppearances.getSpriteLocation(spriteList[0]->id);
+		if (location) {
+			width = location->width;
+			height = location->height;
 		}
 	}
 
@@ -1106,6 +1088,12 @@ void GameSprite::unloadDC() {
 	m_wxMemoryDc[SPRITE_SIZE_32x32] = nullptr;
 }
 
+void GameSprite::prefetchSheets() const {
+	for (const NormalImage* image : spriteList) {
+		g_spriteAppearances.prefetchSprite(image->id);
+	}
+}
+
 uint8_t GameSprite::getMiniMapColor() const {
 	return minimap_color;
 }
@@ -1165,16 +1153,11 @@ std::shared_ptr<GameSprite::OutfitImage> GameSprite::getOutfitImage(int spriteId
 		}
 	}
 
-	for (auto &img : instanced_templates) {
-		if (img->m_spriteId == spriteId && img->m_spriteIndex == spriteIndex) {
-			if (img->m_outfit.getColorHash() == outfit.getColorHash()) {
-				return img;
-			}
-		}
+	const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(spriteIndex)) << 32 | outfit.getColorHash();
+	auto &img = instanced_templates[key];
+	if (!img || img->m_spriteId != static_cast<GLuint>(spriteId)) {
+		img = std::make_shared<GameSprite::OutfitImage>(this, spriteIndex, spriteId, outfit);
 	}
-
-	auto img = std::make_shared<GameSprite::OutfitImage>(this, spriteIndex, spriteId, outfit);
-	instanced_templates.push_back(img);
 	return img;
 }
 
@@ -1183,10 +1166,10 @@ wxMemoryDC* GameSprite::getDC(SpriteSize spriteSize) {
 
 	if (!width && !height) {
 		// Initialize default draw offset
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id, false);
-		if (sheet) {
-			width = sheet->getSpriteSize().width;
-			height = sheet->getSpriteSize().height;
+		const SpriteLocation* location = g_spriteAppearances.getSpriteLocation(spriteList[0]->id);
+		if (location) {
+			width = location->width;
+			height = location->height;
 		}
 	}
 
@@ -1221,13 +1204,13 @@ void GameSprite::DrawTo(wxDC* dcWindow, SpriteSize spriteSize, int start_x, int
 			return;
 		}
 
-		const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteList[0]->id);
-		if (!sheet) {
+		const SpriteLocation* location = g_spriteAppearances.getSpriteLocation(spriteList[0]->id);
+		if (!location) {
 			return;
 		}
 
-		sizeWidth = sheet->getSpriteSize().width;
-		sizeHeight = sheet->getSpriteSize().height;
+		sizeWidth = location->width;
+		sizeHeight = location->height;
 	}
 	wxMemoryDC* sdc = getDC(spriteSize);
 	if (sdc) {
@@ -1241,6 +1224,7 @@ void GameSprite::DrawTo(wxDC* dcWindow, SpriteSize spriteSize, int start_x, int
 }
 
 GameSprite::Image::~Image() {
+	g_residency.release(residency);
 	unloadGLTexture(0);
 }
 
@@ -1256,23 +1240,7 @@ void GameSprite::Image::unloadGLTexture(GLuint textureId) {
 }
 
 void GameSprite::Image::visit() {
-	lastaccess = std::chrono::steady_clock::now();
-}
-
-void GameSprite::Image::clean(std::chrono::steady_clock::time_point now) {
-	if (isGLLoaded && now - lastaccess > std::chrono::seconds(g_settings.getInteger(Config::TEXTURE_LONGEVITY))) {
-		unloadGLTexture(0);
-	}
-}
-
-void GameSprite::NormalImage::clean(std::chrono::steady_clock::time_point now) {
-	// Check if the GL texture sheet is still valid
-	if (atlasTextureId != 0) {
-		auto sheet = g_spriteAppearances.getSheetBySpriteId(id, false);
-		if (!sheet || sheet->glTextureId == 0) {
-			atlasTextureId = 0;
-		}
-	}
+	g_residency.touch(residency);
 }
 
 GameSprite::NormalImage::~NormalImage() {
@@ -1291,12 +1259,22 @@ uint8_t* GameSprite::NormalImage::getRGBAData() {
 }
 
 GLuint GameSprite::NormalImage::getHardwareID() {
-	auto sheet = g_spriteAppearances.getSheetBySpriteId(id);
+	const SpriteSheetPtr &sheet = g_spriteAppearances.getSheetBySpriteId(id, false);
 	if (!sheet) {
 		visit();
 		return 0;
 	}
 
+	// Nothing is drawn until the decode pool hands the sheet over, unless it decoded it in place
+	if (sheet->glTextureId == 0 && !sheet->data) {
+		g_spriteDecodePool.request(sheet);
+		if (!sheet->data) {
+			atlasTextureId = 0;
+			visit();
+			return 0;
+		}
+	}
+
 	GLuint currentAtlasTextureId = sheet->getOrUploadGLTexture();
 	if (currentAtlasTextureId == 0) {
 		atlasTextureId = 0;
@@ -1313,8 +1291,7 @@ GLuint GameSprite::NormalImage::getHardwareID() {
 		atlasTextureId = currentAtlasTextureId;
 	}
 
-	sheet->lastaccess = std::chrono::steady_clock::now();
-	visit();
+	g_residency.touch(sheet->textureResidency);
 	return atlasTextureId;
 }
 
@@ -1423,6 +1400,7 @@ GameSprite::OutfitImage::~OutfitImage() {
 }
 
 void GameSprite::OutfitImage::unloadGLTexture(GLuint) {
+	g_residency.release(residency);
 	if (m_textureId != 0) {
 		isGLLoaded = false;
 		m_isGLLoaded = false;
@@ -1433,16 +1411,6 @@ void GameSprite::OutfitImage::unloadGLTexture(GLuint) {
 	}
 }
 
-void GameSprite::OutfitImage::colorizePixel(uint8_t color, uint8_t &red, uint8_t &green, uint8_t &blue) {
-	uint8_t ro = (TemplateOutfitLookupTable[color] & 0xFF0000) >> 16; // rgb outfit
-	uint8_t go = (TemplateOutfitLookupTable[color] & 0xFF00) >> 8;
-	uint8_t bo = (TemplateOutfitLookupTable[color] & 0xFF);
-
-	red = (uint8_t)(red * ((float)ro / 255.f));
-	green = (uint8_t)(green * ((float)go / 255.f));
-	blue = (uint8_t)(blue * ((float)bo / 255.f));
-}
-
 uint8_t* GameSprite::OutfitImage::getRGBAData() {
 	if (m_cachedOutfitData) {
 		return m_cachedOutfitData;
@@ -1467,41 +1435,16 @@ uint8_t* GameSprite::OutfitImage::getRGBAData() {
 	std::memcpy(rgbadata.get(), sprite->pixels.data(), totalSize);
 	uint8_t* template_rgbadata = spriteTemplate->pixels.data();
 
-	if (m_outfit.lookHead > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		m_outfit.lookHead = 0;
-	}
-	if (m_outfit.lookBody > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		m_outfit.lookBody = 0;
-	}
-	if (m_outfit.lookLegs > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		m_outfit.lookLegs = 0;
-	}
-	if (m_outfit.lookFeet > (sizeof(TemplateOutfitLookupTable) / sizeof(TemplateOutfitLookupTable[0]))) {
-		m_outfit.lookFeet = 0;
-	}
-
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			const int index = (y * width + x) * 4;
-			uint8_t &red = rgbadata[index + 2];
-			uint8_t &green = rgbadata[index + 1];
-			uint8_t &blue = rgbadata[index];
-
-			const uint8_t &tred = template_rgbadata[index + 2];
-			const uint8_t &tgreen = template_rgbadata[index + 1];
-			const uint8_t &tblue = template_rgbadata[index];
-
-			if (tred && tgreen && !tblue) { // yellow => head
-				colorizePixel(m_outfit.lookHead, red, green, blue);
-			} else if (tred && !tgreen && !tblue) { // red => body
-				colorizePixel(m_outfit.lookBody, red, green, blue);
-			} else if (!tred && tgreen && !tblue) { // green => legs
-				colorizePixel(m_outfit.lookLegs, red, green, blue);
-			} else if (!tred && !tgreen && tblue) { // blue => feet
-				colorizePixel(m_outfit.lookFeet, red, green, blue);
-			}
-		}
-	}
+	const auto lookupColor = [](int color) {
+		return color >= 0 && static_cast<size_t>(color) < std::size(TemplateOutfitLookupTable) ? TemplateOutfitLookupTable[color] : TemplateOutfitLookupTable[0];
+	};
+	const OutfitColors colors {
+		lookupColor(m_outfit.lookHead),
+		lookupColor(m_outfit.lookBody),
+		lookupColor(m_outfit.lookLegs),
+		lookupColor(m_outfit.lookFeet),
+	};
+	colorizeOutfit(rgbadata.get(), template_rgbadata, static_cast<size_t>(width) * height, colors);
 
 	spdlog::debug("outfit name: {}, pattern_x: {}, pattern_y: {}, pattern_z: {}, sprite_phase_size: {}, layers: {}, draw height: {}, drawx: {}, drawy: {}", m_outfit.name, m_parent->pattern_x, m_parent->pattern_y, m_parent->pattern_z, m_parent->sprite_phase_size, m_parent->layers, m_parent->draw_height, m_parent->getDrawOffset().x, m_parent->getDrawOffset().y);
 
@@ -1520,6 +1463,7 @@ GLuint GameSprite::OutfitImage::getHardwareID() {
 		}
 	}
 
+	visit();
 	return m_textureId;
 }
 
@@ -1531,15 +1475,17 @@ void GameSprite::OutfitImage::createGLTexture(GLuint spriteId, GLuint textureId)
 		return;
 	}
 
-	const auto &sheet = g_spriteAppearances.getSheetBySpriteId(spriteId);
-	if (!sheet) {
+	const SpriteLocation* location = g_spriteAppearances.getSpriteLocation(spriteId);
+	if (!location) {
 		return;
 	}
 
-	auto spriteWidth = sheet->getSpriteSize().width;
-	auto spriteHeight = sheet->getSpriteSize().height;
+	auto spriteWidth = location->width;
+	auto spriteHeight = location->height;
 	m_isGLLoaded = true;
 	g_gui.gfx.loaded_textures += 1;
+	g_residency.miss();
+	g_residency.track(residency, ResidencyKind::SpriteTexture, static_cast<size_t>(spriteWidth) * spriteHeight * 4, this, evictTexture);
 
 	glBindTexture(GL_TEXTURE_2D, textureId > 0 ? textureId : spriteId);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -1547,6 +1493,14 @@ void GameSprite::OutfitImage::createGLTexture(GLuint spriteId, GLuint textureId)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spriteWidth, spriteHeight, 0, GL_BGRA, GL_UNSIGNED_BYTE, rgba);
+
+	// The texture is the cached result; it is colorized again if the residency manager evicts it
+	delete[] m_cachedOutfitData;
+	m_cachedOutfitData = nullptr;
+}
+
+void GameSprite::OutfitImage::evictTexture(void* owner) {
+	static_cast<OutfitImage*>(owner)->unloadGLTexture(0);
 }
 
 GameSprite* GameSprite::createFromBitmap(const wxArtID &bitmapId) {
@@ -21,9 +21,12 @@
 #include "outfit.h"
 #include "common.h"
 #include "enums.h"
+#include "residency_manager.h"
+#include "paged_table.h"
 
 #include <wx/artprov.h>
 #include <chrono>
+#include <unordered_map>
 
 // Forward declarations
 namespace canary {
@@ -111,6 +114,8 @@ public:
 	uint8_t getWidth();
 	uint8_t getHeight();
 	uint8_t getMiniMapColor() const;
+	// Queues the sheets of every sprite of this object for background decoding
+	void prefetchSheets() const;
 
 	bool hasLight() const noexcept {
 		return has_light;
@@ -134,10 +139,9 @@ protected:
 		virtual ~Image();
 
 		bool isGLLoaded = false;
-		std::chrono::steady_clock::time_point lastaccess {};
+		ResidencyNode residency; // per-sprite texture, if the image owns one
 
 		void visit();
-		virtual void clean(std::chrono::steady_clock::time_point now);
 
 		virtual GLuint getHardwareID() = 0;
 #if CLIENT_VERSION < 1100
@@ -167,8 +171,6 @@ protected:
 		uint16_t size = 0;
 		uint8_t* m_cachedData = nullptr;
 
-		void clean(std::chrono::steady_clock::time_point now) override;
-
 		virtual GLuint getHardwareID();
 		SpriteUV getAtlasUVs() const {
 			return { atlasU0, atlasV0, atlasU1, atlasV1 };
@@ -214,11 +216,12 @@ protected:
 
 		Outfit m_outfit;
 
-		void colorizePixel(uint8_t color, uint8_t &r, uint8_t &b, uint8_t &g);
 		uint8_t* getOutfitData(int spriteId);
 
 		virtual void createGLTexture(GLuint, GLuint);
 		virtual void unloadGLTexture(GLuint);
+
+		static void evictTexture(void* owner);
 	};
 
 	uint32_t id;
@@ -255,7 +258,8 @@ public:
 	SpriteLight light;
 
 	std::vector<NormalImage*> spriteList;
-	std::list<std::shared_ptr<GameSprite::OutfitImage>> instanced_templates; // Templates that use this sprite
+	// Colorized images by sprite index (high word) and outfit colour hash (low word)
+	std::unordered_map<uint64_t, std::shared_ptr<GameSprite::OutfitImage>> instanced_templates;
 
 	friend class GraphicManager;
 };
@@ -354,7 +358,7 @@ public:
 	bool loadSpriteData(const FileName &datafile, wxString &error, wxArrayString &warnings);
 
 	bool loadItemSpriteMetadata(const std::shared_ptr<ItemType> &t, wxString &error, wxArrayString &warnings);
-	bool loadOutfitSpriteMetadata(canary::protobuf::appearances::Appearance outfit, wxString &error, wxArrayString &warnings);
+	bool loadOutfitSpriteMetadata(const canary::protobuf::appearances::Appearance &outfit, wxString &error, wxArrayString &warnings);
 
 	// Cleans old & unused textures according to config settings
 	void garbageCollection();
@@ -373,10 +377,10 @@ private:
 	std::string spritefile;
 	bool loadSpriteDump(uint8_t*&target, uint16_t &size, int sprite_id);
 
-	typedef std::map<int, Sprite*> SpriteMap;
-	SpriteMap sprite_space;
-	typedef std::map<int, GameSprite::Image*> ImageMap;
-	ImageMap image_space;
+	// Client sprites and images by id; editor sprites use negative ids
+	PagedTable<Sprite*> sprite_space;
+	std::map<int, Sprite*> editor_sprite_space;
+	PagedTable<GameSprite::Image*> image_space;
 	std::deque<GameSprite*> cleanup_list;
 
 	uint16_t item_count;
@@ -389,7 +393,6 @@ private:
 	wxFileName sprites_file;
 
 	int loaded_textures;
-	std::chrono::steady_clock::time_point lastclean;
 
 	wxStopWatch* animation_timer;
 
@@ -53,8 +53,6 @@
 	#include <AGL/agl.h>
 #endif
 
-#include <appearances.pb.h>
-
 namespace InternalGUI {
 	void logErrorAndSetMessage(const std::string &message, wxString &error) {
 		spdlog::error(message);
@@ -317,10 +315,12 @@ bool GUI::LoadDataFiles(wxString &error, wxArrayString &warnings) {
 	itemsPath.AppendDir("items");
 	itemsPath.SetFullName("items.xml");
 
+	const auto itemsStart = std::chrono::steady_clock::now();
 	if (!g_items.loadFromGameXml(itemsPath, error, warnings)) {
 		warnings.push_back("Couldn't load items.xml: " + error);
 		spdlog::warn("[GUI::LoadDataFiles] {}: {}", itemsPath.GetFullPath().ToStdString(), error.ToStdString());
 	}
+	spdlog::info("Loaded items.xml in {:.1f} ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - itemsStart).count());
 
 	{
 		std::string monstersLuaDir = g_settings.getString(Config::MONSTERS_LUA_DIRECTORY);
@@ -610,6 +610,7 @@ bool GUI::LoadMap(const FileName &fileName) {
 		palette->OnUpdate(mapTab->GetMap());
 	}
 
+	editor->startJournal();
 	return true;
 }
 
@@ -1107,7 +1108,7 @@ bool GUI::IsMinimapVisible() const {
 
 //=============================================================================
 
-void GUI::RefreshView() {
+void GUI::RefreshView(bool mark_scene_dirty /* = true */) {
 	EditorTab* editorTab = GetCurrentTab();
 	if (!editorTab) {
 		return;
@@ -1128,7 +1129,7 @@ void GUI::RefreshView() {
 
 	for (EditorTab* editorTab : editorTabs) {
 		auto* mapTab = static_cast<MapTab*>(editorTab);
-		mapTab->GetCanvas()->Refresh(); // MapCanvas::Refresh() → markDirty() + wxGLCanvas::Refresh()
+		mapTab->GetCanvas()->QueueRefresh(mark_scene_dirty);
 		editorTab->GetWindow()->Update();
 	}
 }
@@ -1354,7 +1355,7 @@ bool GUI::DoUndo() {
 		SetStatusText("Undo action");
 		UpdateMinimap();
 		root->UpdateMenubar();
-		RefreshView();
+		RefreshView(false);
 		return true;
 	}
 	return false;
@@ -1370,7 +1371,7 @@ bool GUI::DoRedo() {
 		SetStatusText("Redo action");
 		UpdateMinimap();
 		root->UpdateMenubar();
-		RefreshView();
+		RefreshView(false);
 		return true;
 	}
 	return false;
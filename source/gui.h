@@ -33,14 +33,6 @@
 #include "palette_window.h"
 #include "zone_brush.h"
 
-namespace canary {
-	namespace protobuf {
-		namespace appearances {
-			class Appearances;
-		}
-	}
-}
-
 class BaseMap;
 class Map;
 
@@ -339,7 +331,9 @@ public:
 	// Centers current view on position
 	void SetScreenCenterPosition(const Position &position, bool showIndicator = true);
 	// Refresh the view canvas
-	void RefreshView();
+	// Pass false when the change went through the action queue; the views then
+	// repaint only the areas the map recorded as damaged.
+	void RefreshView(bool mark_scene_dirty = true);
 	// Fit all/specified current map view to map dimensions
 	void FitViewToMap();
 	void FitViewToMap(MapTab* mt);
@@ -469,8 +463,6 @@ public:
 	FlagBrush* pvp_brush;
 	ZoneBrush* zone_brush;
 
-	std::unique_ptr<canary::protobuf::appearances::Appearances> m_appearancesPtr; // Protobuf appearances file parsed
-
 protected:
 	//=========================================================================
 	// Global GUI state
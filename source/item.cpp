@@ -31,6 +31,8 @@
 #include "table_brush.h"
 #include "wall_brush.h"
 
+#include <typeinfo>
+
 namespace {
 	bool itemTypeHasSubtype(const ItemType &type) {
 		return type.isFluidContainer() || type.stackable || type.charges != 0 || type.isSplash() || type.isClientCharged() || type.isExtraCharged();
@@ -129,6 +131,14 @@ Item* Item::deepCopy() const {
 	return copy;
 }
 
+bool Item::isEquivalent(const Item &other) const {
+	return typeid(*this) == typeid(other)
+		&& id == other.id
+		&& subtype == other.subtype
+		&& selected == other.selected
+		&& hasSameAttributes(other);
+}
+
 Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent) {
 	if (old_item == nullptr) {
 		return nullptr;
@@ -448,6 +458,11 @@ void Item::animate() {
 	frame = sprite->animator->getFrame();
 }
 
+bool Item::hasAnimation() const {
+	const GameSprite* sprite = g_items.getItemType(id).sprite;
+	return sprite && sprite->animator;
+}
+
 // ============================================================================
 // Static conversions
 
@@ -101,6 +101,8 @@ public:
 
 	// Deep copy thingy
 	virtual Item* deepCopy() const;
+	// True if other holds exactly what a deepCopy of this item would
+	virtual bool isEquivalent(const Item &other) const;
 
 	// Get memory footprint size
 	uint32_t memsize() const;
@@ -377,6 +379,7 @@ public:
 	std::string getDescription() const;
 
 	void animate();
+	bool hasAnimation() const;
 	int getFrame() const {
 		return frame;
 	}
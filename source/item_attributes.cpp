@@ -55,6 +55,15 @@ ItemAttributeMap ItemAttributes::getAttributes() const {
 	return ItemAttributeMap();
 }
 
+bool ItemAttributes::hasSameAttributes(const ItemAttributes &other) const {
+	const bool empty = !attributes || attributes->empty();
+	const bool otherEmpty = !other.attributes || other.attributes->empty();
+	if (empty || otherEmpty) {
+		return empty == otherEmpty;
+	}
+	return *attributes == *other.attributes;
+}
+
 void ItemAttributes::setAttribute(const std::string &key, const ItemAttribute &value) {
 	createAttributes();
 	(*attributes)[key] = value;
@@ -213,6 +222,27 @@ ItemAttribute &ItemAttribute::operator=(const ItemAttribute &o) {
 	return *this;
 }
 
+bool ItemAttribute::operator==(const ItemAttribute &o) const {
+	if (type != o.type) {
+		return false;
+	}
+
+	switch (type) {
+		case STRING:
+			return *reinterpret_cast<const std::string*>(&data) == *reinterpret_cast<const std::string*>(&o.data);
+		case INTEGER:
+			return *reinterpret_cast<const int32_t*>(&data) == *reinterpret_cast<const int32_t*>(&o.data);
+		case FLOAT:
+			return *reinterpret_cast<const float*>(&data) == *reinterpret_cast<const float*>(&o.data);
+		case DOUBLE:
+			return *reinterpret_cast<const double*>(&data) == *reinterpret_cast<const double*>(&o.data);
+		case BOOLEAN:
+			return *reinterpret_cast<const bool*>(&data) == *reinterpret_cast<const bool*>(&o.data);
+		default:
+			return true;
+	}
+}
+
 ItemAttribute::~ItemAttribute() {
 	clear();
 }
@@ -40,6 +40,8 @@ public:
 	ItemAttribute &operator=(const ItemAttribute &o);
 	~ItemAttribute();
 
+	bool operator==(const ItemAttribute &o) const;
+
 	enum Type {
 		STRING = 1,
 		INTEGER = 2,
@@ -103,6 +105,7 @@ public:
 
 	void clearAllAttributes();
 	ItemAttributeMap getAttributes() const;
+	bool hasSameAttributes(const ItemAttributes &other) const;
 
 protected:
 	ItemAttributeMap* attributes;
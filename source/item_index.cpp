@@ -0,0 +1,266 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "item_index.h"
+
+#include "basemap.h"
+#include "complexitem.h"
+#include "parallel_for.h"
+#include "settings.h"
+#include "tile.h"
+
+#include <algorithm>
+#include <format>
+
+namespace {
+	// Leaves counted by one worker before it takes the next chunk
+	constexpr size_t LeavesPerChunk = 256;
+	// Differences listed by the verifier before it only counts them
+	constexpr size_t MaxReportedDifferences = 50;
+
+	template <typename Function>
+	void forEachItemId(const Item* item, Function &fn) {
+		if (!item) {
+			return;
+		}
+		fn(item->getID());
+		if (const Container* container = dynamic_cast<const Container*>(item)) {
+			for (size_t index = 0; index < container->getItemCount(); ++index) {
+				forEachItemId(container->getItem(index), fn);
+			}
+		}
+	}
+
+	// The ground and every item of the tile, with the contents of its containers
+	template <typename Function>
+	void forEachItemId(const Tile* tile, Function &&fn) {
+		forEachItemId(tile->ground, fn);
+		for (const Item* item : tile->items) {
+			forEachItemId(item, fn);
+		}
+	}
+
+	struct LeafEntry {
+		uint16_t id;
+		uint32_t key;
+		uint32_t amount;
+	};
+
+	// The entry of the leaf in the sorted list of an id, or where it would go
+	ItemIndex::LeafCounts::iterator findLeaf(ItemIndex::LeafCounts &leaves, uint32_t key) {
+		return std::ranges::lower_bound(leaves, key, {}, &ItemIndex::LeafCounts::value_type::first);
+	}
+}
+
+void ItemIndex::build(BaseMap &map) {
+	std::vector<QTreeNode*> leaves;
+	map.getLeaves(0, 0, 0xFFFF, 0xFFFF, leaves);
+
+	// Each chunk of leaves is counted by one worker into its own list; the
+	// lists are joined in tree order, so every id's leaves are appended in key order
+	const size_t chunks = (leaves.size() + LeavesPerChunk - 1) / LeavesPerChunk;
+	std::vector<std::vector<LeafEntry>> results(chunks);
+	const unsigned int threads = std::max(g_settings.getInteger(Config::WORKER_THREADS), 1);
+	rme::parallelFor(chunks, threads, [&](size_t chunk) {
+		std::vector<LeafEntry> &entries = results[chunk];
+		std::vector<uint16_t> ids;
+		const size_t last = std::min(leaves.size(), (chunk + 1) * LeavesPerChunk);
+		for (size_t index = chunk * LeavesPerChunk; index < last; ++index) {
+			ids.clear();
+			uint32_t key = 0;
+			bool has_tiles = false;
+			for (int z = rme::MapMinLayer; z <= rme::MapMaxLayer; ++z) {
+				const Floor* floor = leaves[index]->getFloor(z);
+				if (!floor) {
+					continue;
+				}
+				for (const TileLocation &location : floor->locs) {
+					if (const Tile* tile = location.get()) {
+						if (!has_tiles) {
+							key = BaseMap::getLeafKey(tile->getX(), tile->getY());
+							has_tiles = true;
+						}
+						forEachItemId(tile, [&ids](uint16_t id) { ids.push_back(id); });
+					}
+				}
+			}
+
+			std::ranges::sort(ids);
+			for (size_t first = 0; first < ids.size();) {
+				size_t next = first + 1;
+				while (next < ids.size() && ids[next] == ids[first]) {
+					++next;
+				}
+				entries.push_back({ ids[first], key, static_cast<uint32_t>(next - first) });
+				first = next;
+			}
+		}
+	});
+
+	// Sized exactly before the lists are filled, they are kept for the whole session
+	std::vector<uint32_t> sizes;
+	for (const std::vector<LeafEntry> &entries : results) {
+		for (const LeafEntry &entry : entries) {
+			if (entry.id >= sizes.size()) {
+				sizes.resize(entry.id + 1, 0);
+			}
+			++sizes[entry.id];
+		}
+	}
+
+	counts.clear();
+	counts.resize(sizes.size());
+	for (size_t id = 0; id < sizes.size(); ++id) {
+		counts[id].reserve(sizes[id]);
+	}
+	for (const std::vector<LeafEntry> &entries : results) {
+		for (const LeafEntry &entry : entries) {
+			counts[entry.id].emplace_back(entry.key, entry.amount);
+		}
+	}
+	valid = true;
+}
+
+void ItemIndex::invalidate() {
+	counts.clear();
+	counts.shrink_to_fit();
+	valid = false;
+}
+
+void ItemIndex::countTile(std::vector<LeafCounts> &counts, const Tile* tile) {
+	const uint32_t key = BaseMap::getLeafKey(tile->getX(), tile->getY());
+	forEachItemId(tile, [&counts, key](uint16_t id) {
+		if (id >= counts.size()) {
+			counts.resize(id + 1);
+		}
+		LeafCounts &leaves = counts[id];
+		const auto it = findLeaf(leaves, key);
+		if (it != leaves.end() && it->first == key) {
+			++it->second;
+		} else {
+			leaves.emplace(it, key, 1);
+		}
+	});
+}
+
+void ItemIndex::update(const Tile* old_tile, const Tile* new_tile) {
+	if (!valid || old_tile == new_tile) {
+		return;
+	}
+
+	if (old_tile) {
+		const uint32_t key = BaseMap::getLeafKey(old_tile->getX(), old_tile->getY());
+		bool missing = false;
+		forEachItemId(old_tile, [this, key, &missing](uint16_t id) {
+			if (id >= counts.size()) {
+				missing = true;
+				return;
+			}
+			LeafCounts &leaves = counts[id];
+			const auto it = findLeaf(leaves, key);
+			if (it == leaves.end() || it->first != key) {
+				missing = true;
+			} else if (--it->second == 0) {
+				leaves.erase(it);
+			}
+		});
+
+		// The tile was changed behind the index's back, so the counts can not be trusted anymore
+		if (missing) {
+			invalidate();
+			return;
+		}
+	}
+
+	if (new_tile) {
+		countTile(counts, new_tile);
+	}
+}
+
+const ItemIndex::LeafCounts* ItemIndex::find(uint16_t id) const {
+	if (!valid || id >= counts.size() || counts[id].empty()) {
+		return nullptr;
+	}
+	return &counts[id];
+}
+
+size_t ItemIndex::count(uint16_t id) const {
+	size_t total = 0;
+	if (const LeafCounts* leaves = find(id)) {
+		for (const auto &[key, amount] : *leaves) {
+			total += amount;
+		}
+	}
+	return total;
+}
+
+size_t ItemIndex::memoryUsage() const noexcept {
+	size_t bytes = counts.capacity() * sizeof(LeafCounts);
+	for (const LeafCounts &leaves : counts) {
+		bytes += leaves.capacity() * sizeof(LeafCounts::value_type);
+	}
+	return bytes;
+}
+
+bool ItemIndex::verify(BaseMap &map, std::string &report) const {
+	std::vector<LeafCounts> scanned;
+	for (TileLocation* location : map) {
+		countTile(scanned, location->get());
+	}
+
+	static const LeafCounts none;
+	size_t differences = 0;
+	const auto difference = [&](size_t id, uint32_t key, uint32_t indexed, uint32_t actual) {
+		if (++differences <= MaxReportedDifferences) {
+			const Position corner = BaseMap::getLeafPosition(key);
+			report += std::format("Item {} in the leaf at {},{}: {} indexed, {} on the map\n", id, corner.x, corner.y, indexed, actual);
+		}
+	};
+
+	for (size_t id = 0; id < std::max(counts.size(), scanned.size()); ++id) {
+		const LeafCounts &indexed = id < counts.size() ? counts[id] : none;
+		const LeafCounts &actual = id < scanned.size() ? scanned[id] : none;
+		if (indexed == actual) {
+			continue;
+		}
+
+		// Both lists are in key order, so they are walked side by side
+		auto index_it = indexed.begin();
+		auto actual_it = actual.begin();
+		while (index_it != indexed.end() || actual_it != actual.end()) {
+			if (actual_it == actual.end() || (index_it != indexed.end() && index_it->first < actual_it->first)) {
+				difference(id, index_it->first, index_it->second, 0);
+				++index_it;
+			} else if (index_it == indexed.end() || actual_it->first < index_it->first) {
+				difference(id, actual_it->first, 0, actual_it->second);
+				++actual_it;
+			} else {
+				if (index_it->second != actual_it->second) {
+					difference(id, index_it->first, index_it->second, actual_it->second);
+				}
+				++index_it;
+				++actual_it;
+			}
+		}
+	}
+
+	if (differences > MaxReportedDifferences) {
+		report += std::format("... and {} more\n", differences - MaxReportedDifferences);
+	}
+	return differences == 0;
+}
@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_ITEM_INDEX_H_
+#define RME_ITEM_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class BaseMap;
+class Tile;
+
+// Where the items of a map are, per item id: how many instances each map
+// leaf (4x4 tiles on every floor) holds, container contents included. The
+// leaves of an id are kept in a flat list sorted in the order the map tree
+// stores them, so walking them visits the tiles in the same order as a scan
+// of the whole map.
+//
+// The index follows the tiles that are placed on the map and taken off it.
+// Changes made to a tile while it is on the map go around it; the code doing
+// that invalidates the index, and it is built again on the next lookup.
+class ItemIndex {
+public:
+	using LeafCounts = std::vector<std::pair<uint32_t, uint32_t>>; // leaf key, instances in the leaf; sorted by key
+
+	ItemIndex() = default;
+
+	ItemIndex(const ItemIndex &) = delete;
+	ItemIndex &operator=(const ItemIndex &) = delete;
+
+	// Counts the items of every leaf, spread over the worker threads
+	void build(BaseMap &map);
+	void invalidate();
+	bool isValid() const noexcept {
+		return valid;
+	}
+
+	// Takes the items of old_tile out of the counts and adds those of new_tile
+	void update(const Tile* old_tile, const Tile* new_tile);
+
+	// The leaves holding the id, nullptr when there are none
+	const LeafCounts* find(uint16_t id) const;
+	size_t count(uint16_t id) const;
+	// Bytes held by the index
+	size_t memoryUsage() const noexcept;
+
+	// Compares the index with a plain scan of the map, listing the differences in report
+	bool verify(BaseMap &map, std::string &report) const;
+
+private:
+	static void countTile(std::vector<LeafCounts> &counts, const Tile* tile);
+
+	std::vector<LeafCounts> counts; // by item id
+	bool valid = false;
+};
+
+#endif
@@ -0,0 +1,164 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "item_replacer.h"
+
+#include "editor.h"
+#include "map_search.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+	double millisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+ItemReplacer::ItemReplacer(Editor &editor, bool selection_only) :
+	editor(editor),
+	selection_only(selection_only) {
+	////
+}
+
+void ItemReplacer::addRule(uint16_t from, uint16_t to) {
+	rules.emplace_back(from, to);
+}
+
+void ItemReplacer::compile() {
+	targets.assign(UINT16_MAX + 1, 0);
+	paths.clear();
+	replaced.assign(rules.size(), 0);
+
+	for (const auto &rule : rules) {
+		const uint16_t source = rule.first;
+		if (paths.contains(source)) {
+			continue;
+		}
+
+		uint16_t id = source;
+		std::vector<size_t> path;
+		for (size_t index = 0; index < rules.size(); ++index) {
+			if (rules[index].first == id) {
+				id = rules[index].second;
+				path.push_back(index);
+			}
+		}
+
+		// Rules that lead back to the id they started from leave it as it is
+		if (id != source) {
+			targets[source] = id;
+			paths.emplace(source, std::move(path));
+		}
+	}
+}
+
+BatchAction* ItemReplacer::run() {
+	const auto start = std::chrono::steady_clock::now();
+	stats = ItemReplaceStats();
+	compile();
+	if (paths.empty()) {
+		return nullptr;
+	}
+
+	Map &map = editor.getMap();
+	MapSearch search(editor, selection_only);
+	std::vector<Tile*> tiles;
+	const bool completed = search.run(
+		"Searching items to replace...",
+		[&](Tile* tile, MapSearch::Results &results) {
+			bool hit = false;
+			search.forEachItem(tile, [&](const Item* item) {
+				hit = hit || targets[item->getID()] != 0;
+			});
+			if (hit) {
+				results.emplace_back(tile, nullptr);
+			}
+		},
+		[&](const MapSearch::Results &results) {
+			for (const auto &[tile, item] : results) {
+				tiles.push_back(tile);
+			}
+			return true;
+		}
+	);
+	stats.scan_ms = millisecondsSince(start);
+
+	if (!completed) {
+		stats.cancelled = true;
+		stats.total_ms = stats.scan_ms;
+		return nullptr;
+	}
+
+	const auto apply_start = std::chrono::steady_clock::now();
+	BatchAction* batch = editor.createBatch(ACTION_REPLACE_ITEMS);
+	Action* action = editor.createAction(batch);
+
+	std::vector<std::pair<Item*, uint16_t>> pending;
+	for (Tile* tile : tiles) {
+		Tile* copy = tile->deepCopy(map);
+
+		// Decided in map order so the cap takes the first items of the map
+		pending.clear();
+		auto decide = [&](Map &, Tile*, Item* item, long long) {
+			const auto it = paths.find(item->getID());
+			if (it == paths.end()) {
+				return;
+			}
+			// Rules applied one at a time would leave the item at the first rule that ran out
+			uint16_t id = item->getID();
+			for (const size_t rule : it->second) {
+				if (limit > 0 && replaced[rule] >= limit) {
+					break;
+				}
+				++replaced[rule];
+				id = rules[rule].second;
+			}
+			if (id != item->getID()) {
+				pending.emplace_back(item, id);
+			}
+		};
+		foreach_ItemOnTile(map, copy, decide, 0);
+
+		if (pending.empty()) {
+			delete copy;
+			continue;
+		}
+
+		// Contents go before their container, which takes copies of them when it is transformed
+		for (auto it = pending.rbegin(); it != pending.rend(); ++it) {
+			transformItem(it->first, it->second, copy);
+		}
+		action->addChange(new Change(copy));
+		stats.items += pending.size();
+		++stats.tiles;
+	}
+
+	if (action->empty()) {
+		delete action;
+		delete batch;
+		stats.apply_ms = millisecondsSince(apply_start);
+		stats.total_ms = millisecondsSince(start);
+		return nullptr;
+	}
+
+	batch->addAndCommitAction(action);
+	stats.apply_ms = millisecondsSince(apply_start);
+	stats.total_ms = millisecondsSince(start);
+	return batch;
+}
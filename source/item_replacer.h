@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_ITEM_REPLACER_H_
+#define RME_ITEM_REPLACER_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Editor;
+class BatchAction;
+
+struct ItemReplaceStats {
+	size_t tiles = 0;
+	size_t items = 0;
+	bool cancelled = false;
+	double scan_ms = 0.0;
+	double apply_ms = 0.0;
+	double total_ms = 0.0;
+};
+
+// Replaces item ids on the whole map, or on its selection, in a single pass
+// for any number of rules. The rules are compiled into a table from each id
+// to the id it ends up as when the rules are applied one after another, so
+// chained rules give the same result as replacing rule by rule; an item
+// stops at the first rule on its way that reached the limit. The tiles
+// holding a replaced id are found on the worker threads; every changed tile
+// goes into one action, which the undo history keeps as item deltas against
+// the tiles left on the map.
+class ItemReplacer {
+public:
+	ItemReplacer(Editor &editor, bool selection_only);
+
+	// Rules apply in the order they are added
+	void addRule(uint16_t from, uint16_t to);
+	// Caps the items replaced by each rule, taken in map order; 0 for no cap
+	void setLimit(size_t limit) noexcept {
+		this->limit = limit;
+	}
+
+	// Commits the replacement; returns nullptr if nothing changed or the search was cancelled
+	BatchAction* run();
+
+	// Items the rule replaced, including those that reached its id through earlier rules
+	size_t getReplaced(size_t rule) const {
+		return rule < replaced.size() ? replaced[rule] : 0;
+	}
+	const ItemReplaceStats &getStats() const noexcept {
+		return stats;
+	}
+
+private:
+	void compile();
+
+	Editor &editor;
+	bool selection_only;
+	size_t limit = 0;
+
+	std::vector<std::pair<uint16_t, uint16_t>> rules;
+	std::vector<uint16_t> targets; // by id, 0 for ids that stay
+	std::unordered_map<uint16_t, std::vector<size_t>> paths; // rules an id goes through, by id
+	std::vector<size_t> replaced; // by rule
+	ItemReplaceStats stats;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include "items.h"
 #include "item.h"
 #include "sprite_appearances.h"
+#include "parallel_for.h"
 
 #include <appearances.pb.h>
 
@@ -453,11 +454,25 @@ bool ItemDatabase::loadFromOtb(const FileName &datafile, wxString &error, wxArra
 }
 #endif
 
-bool ItemDatabase::loadFromProtobuf(wxString &error, wxArrayString &warnings, canary::protobuf::appearances::Appearances &appearances) {
+bool ItemDatabase::loadFromProtobuf(wxString &error, wxArrayString &warnings, const canary::protobuf::appearances::Appearances &appearances) {
 	using namespace canary::protobuf::appearances;
+	using Clock = std::chrono::steady_clock;
 
-	for (uint16_t it = 0; it < static_cast<uint16_t>(appearances.object_size()); ++it) {
-		Appearance object = appearances.object(it);
+	// The item types only depend on their own appearance and are built on all
+	// cores; sprite metadata is shared between items and is attached in order.
+	const auto convertStart = Clock::now();
+	const size_t count = static_cast<size_t>(appearances.object_size());
+	std::vector<std::shared_ptr<ItemType>> converted(count);
+	rme::parallelFor(count, [&](size_t index) {
+		const Appearance &object = appearances.object(static_cast<int>(index));
+		if (object.has_flags() && object.has_id()) {
+			converted[index] = convertAppearance(object);
+		}
+	});
+	const auto metadataStart = Clock::now();
+
+	for (size_t index = 0; index < count; ++index) {
+		const Appearance &object = appearances.object(static_cast<int>(index));
 
 		// This scenario should never happen but on custom assets this can break the loader.
 		if (!object.has_flags()) {
@@ -470,98 +485,16 @@ bool ItemDatabase::loadFromProtobuf(wxString &error, wxArrayString &warnings, ca
 			items.resize(object.id() + 1);
 		}
 
-		if (!object.has_id()) {
+		std::shared_ptr<ItemType> &t = converted[index];
+		if (!t) {
 			continue;
 		}
 
-		auto t = std::make_shared<ItemType>();
-		t->id = static_cast<uint16_t>(object.id());
 		// Save max item id from the object size iteraction
 		if (maxItemId < t->id) {
 			maxItemId = t->id;
 			spdlog::debug("[ItemDatabase::loadFromProtobuf] - Loading item with id {}.", t->id);
 		}
-		t->clientID = static_cast<uint16_t>(object.id());
-		t->name = object.name();
-		t->description = object.description();
-
-		if (object.flags().container()) {
-			t->type = ITEM_TYPE_CONTAINER;
-			t->group = ITEM_GROUP_CONTAINER;
-		} else if (object.flags().has_bank()) {
-			t->group = ITEM_GROUP_GROUND;
-		} else if (object.flags().liquidcontainer()) {
-			t->group = ITEM_GROUP_FLUID;
-		} else if (object.flags().liquidpool()) {
-			t->group = ITEM_GROUP_SPLASH;
-		}
-
-		if (object.flags().has_clip() || object.flags().has_top() || object.flags().has_bottom()) {
-			t->alwaysOnBottom = true;
-		}
-
-		if (object.flags().clip()) {
-			t->alwaysOnTopOrder = 1;
-		} else if (object.flags().top()) {
-			t->alwaysOnTopOrder = 3;
-		} else if (object.flags().bottom()) {
-			t->alwaysOnTopOrder = 2;
-		}
-
-		// now lets parse sprite data
-		t->m_animationPhases.clear();
-
-		for (const auto &framegroup : object.frame_group()) {
-			const auto &frameGroupType = framegroup.fixed_frame_group();
-			const auto &spriteInfo = framegroup.sprite_info();
-			const auto &animation = spriteInfo.animation();
-			const auto &sprites = spriteInfo.sprite_id();
-
-			t->pattern_width = spriteInfo.pattern_width();
-			t->pattern_height = spriteInfo.pattern_height();
-			t->pattern_depth = spriteInfo.pattern_depth();
-			t->layers = spriteInfo.layers();
-
-			if (animation.sprite_phase().size() > 0) {
-				const auto &spritesPhases = animation.sprite_phase();
-				t->start_frame = static_cast<int8_t>(animation.default_start_phase());
-				t->loop_count = animation.loop_count();
-				t->async_animation = !animation.synchronized();
-				for (int k = 0; k < spritesPhases.size(); k++) {
-					t->m_animationPhases.push_back(std::pair<int, int>(static_cast<int>(spritesPhases[k].duration_min()), static_cast<int>(spritesPhases[k].duration_max())));
-				}
-			}
-
-			t->sprite_id = spriteInfo.sprite_id(0);
-
-			t->m_sprites.clear();
-			t->m_sprites.resize(sprites.size());
-			for (int i = 0; i < sprites.size(); i++) {
-				t->m_sprites[i] = sprites[i];
-			}
-		}
-
-		t->noMoveAnimation = object.flags().no_movement_animation();
-		t->isCorpse = object.flags().corpse() || object.flags().player_corpse();
-		t->forceUse = object.flags().forceuse();
-		t->hasHeight = object.flags().has_height();
-		t->unpassable = object.flags().unpass();
-		t->blockMissiles = object.flags().unsight();
-		t->blockPathfinder = object.flags().avoid();
-		t->pickupable = object.flags().take();
-		t->moveable = object.flags().unmove() == false;
-		t->canReadText = (object.flags().has_lenshelp() && object.flags().lenshelp().id() == 1112) || (object.flags().has_write() && object.flags().write().max_text_length() != 0) || (object.flags().has_write_once() && object.flags().write_once().max_text_length_once() != 0);
-		t->canReadText = object.flags().has_write() || object.flags().has_write_once();
-		t->isHangable = object.flags().hang();
-		t->stackable = object.flags().cumulative();
-		t->isPodium = object.flags().show_off_socket();
-		t->rotable = object.flags().rotate();
-		t->ignoreLook = object.flags().ignore_look();
-		t->hasElevation = object.flags().has_height();
-
-		if (object.flags().has_hook()) {
-			t->hook = object.flags().hook().direction() == HOOK_TYPE_SOUTH ? ITEM_HOOK_SOUTH : ITEM_HOOK_EAST;
-		}
 
 		g_gui.gfx.loadItemSpriteMetadata(t, error, warnings);
 		t->sprite = static_cast<GameSprite*>(g_gui.gfx.getSprite(t->id));
@@ -579,19 +512,104 @@ bool ItemDatabase::loadFromProtobuf(wxString &error, wxArrayString &warnings, ca
 			}
 		}
 
-		if (t) {
-			if (items[t->id]) {
-				wxLogWarning("appearances.dat: Duplicate items");
-				items[t->id].reset();
-			}
-			items.set(t->id, t);
+		if (items[t->id]) {
+			wxLogWarning("appearances.dat: Duplicate items");
+			items[t->id].reset();
 		}
+		items.set(t->id, std::move(t));
 	}
 
+	const auto milliseconds = [](Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	};
+	spdlog::info("Converted {} item appearances in {:.1f} ms, sprite metadata in {:.1f} ms", count, milliseconds(metadataStart - convertStart), milliseconds(Clock::now() - metadataStart));
 	spdlog::debug("[ItemDatabase::loadFromProtobuf] - Last loaded item: {}", maxItemId);
 	return true;
 }
 
+std::shared_ptr<ItemType> ItemDatabase::convertAppearance(const canary::protobuf::appearances::Appearance &object) {
+	using namespace canary::protobuf::appearances;
+
+	auto t = std::make_shared<ItemType>();
+	t->id = static_cast<uint16_t>(object.id());
+	t->clientID = static_cast<uint16_t>(object.id());
+	t->name = object.name();
+	t->description = object.description();
+
+	if (object.flags().container()) {
+		t->type = ITEM_TYPE_CONTAINER;
+		t->group = ITEM_GROUP_CONTAINER;
+	} else if (object.flags().has_bank()) {
+		t->group = ITEM_GROUP_GROUND;
+	} else if (object.flags().liquidcontainer()) {
+		t->group = ITEM_GROUP_FLUID;
+	} else if (object.flags().liquidpool()) {
+		t->group = ITEM_GROUP_SPLASH;
+	}
+
+	if (object.flags().has_clip() || object.flags().has_top() || object.flags().has_bottom()) {
+		t->alwaysOnBottom = true;
+	}
+
+	if (object.flags().clip()) {
+		t->alwaysOnTopOrder = 1;
+	} else if (object.flags().top()) {
+		t->alwaysOnTopOrder = 3;
+	} else if (object.flags().bottom()) {
+		t->alwaysOnTopOrder = 2;
+	}
+
+	// now lets parse sprite data
+	t->m_animationPhases.clear();
+
+	for (const auto &framegroup : object.frame_group()) {
+		const auto &spriteInfo = framegroup.sprite_info();
+		const auto &animation = spriteInfo.animation();
+		const auto &sprites = spriteInfo.sprite_id();
+
+		t->pattern_width = spriteInfo.pattern_width();
+		t->pattern_height = spriteInfo.pattern_height();
+		t->pattern_depth = spriteInfo.pattern_depth();
+		t->layers = spriteInfo.layers();
+
+		if (animation.sprite_phase().size() > 0) {
+			const auto &spritesPhases = animation.sprite_phase();
+			t->start_frame = static_cast<int8_t>(animation.default_start_phase());
+			t->loop_count = animation.loop_count();
+			t->async_animation = !animation.synchronized();
+			for (int k = 0; k < spritesPhases.size(); k++) {
+				t->m_animationPhases.push_back(std::pair<int, int>(static_cast<int>(spritesPhases[k].duration_min()), static_cast<int>(spritesPhases[k].duration_max())));
+			}
+		}
+
+		t->sprite_id = spriteInfo.sprite_id(0);
+		t->m_sprites.assign(sprites.begin(), sprites.end());
+	}
+
+	t->noMoveAnimation = object.flags().no_movement_animation();
+	t->isCorpse = object.flags().corpse() || object.flags().player_corpse();
+	t->forceUse = object.flags().forceuse();
+	t->hasHeight = object.flags().has_height();
+	t->unpassable = object.flags().unpass();
+	t->blockMissiles = object.flags().unsight();
+	t->blockPathfinder = object.flags().avoid();
+	t->pickupable = object.flags().take();
+	t->moveable = object.flags().unmove() == false;
+	t->canReadText = (object.flags().has_lenshelp() && object.flags().lenshelp().id() == 1112) || (object.flags().has_write() && object.flags().write().max_text_length() != 0) || (object.flags().has_write_once() && object.flags().write_once().max_text_length_once() != 0);
+	t->canReadText = object.flags().has_write() || object.flags().has_write_once();
+	t->isHangable = object.flags().hang();
+	t->stackable = object.flags().cumulative();
+	t->isPodium = object.flags().show_off_socket();
+	t->rotable = object.flags().rotate();
+	t->ignoreLook = object.flags().ignore_look();
+	t->hasElevation = object.flags().has_height();
+
+	if (object.flags().has_hook()) {
+		t->hook = object.flags().hook().direction() == HOOK_TYPE_SOUTH ? ITEM_HOOK_SOUTH : ITEM_HOOK_EAST;
+	}
+	return t;
+}
+
 bool ItemDatabase::loadItemFromGameXml(pugi::xml_node itemNode, uint16_t id) {
 	if (!(id >= LIQUID_FIRST && id <= LIQUID_LAST) && !isValidID(id)) {
 		return false;
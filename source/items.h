@@ -24,6 +24,7 @@
 namespace canary {
 	namespace protobuf {
 		namespace appearances {
+			class Appearance;
 			class Appearances;
 		}
 	}
@@ -440,7 +441,7 @@ public:
 	bool isValidID(uint16_t id) const;
 
 	bool loadFromOtb(const FileName &datafile, wxString &error, wxArrayString &warnings);
-	bool loadFromProtobuf(wxString &error, wxArrayString &warnings, canary::protobuf::appearances::Appearances &appearances);
+	bool loadFromProtobuf(wxString &error, wxArrayString &warnings, const canary::protobuf::appearances::Appearances &appearances);
 	bool loadFromGameXml(const FileName &datafile, wxString &error, wxArrayString &warnings);
 	bool loadItemFromGameXml(pugi::xml_node itemNode, uint16_t id);
 	bool loadMetaItem(pugi::xml_node node);
@@ -463,6 +464,8 @@ protected:
 	bool loadAttributesByOtbVersion(const std::shared_ptr<ItemType> &item, BinaryNode* itemNode, wxString &error, wxArrayString &warnings);
 
 	bool loadFromOtb(BinaryNode* itemNode, wxString &error, wxArrayString &warnings);
+	// Builds the item type of one appearance; safe to call from any thread
+	static std::shared_ptr<ItemType> convertAppearance(const canary::protobuf::appearances::Appearance &object);
 
 protected:
 	ItemMap items;
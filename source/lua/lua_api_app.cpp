@@ -206,6 +206,10 @@ namespace LuaAPI {
 
 	// Global accessor for tile modification tracking (used by lua_api_tile.cpp)
 	void markTileForUndo(Tile* tile) {
+		// Scripts change tiles while they are on the map, which the item index and the tile statistics can not follow
+		if (Editor* editor = g_gui.GetCurrentEditor()) {
+			editor->getMap().invalidateTileIndexes();
+		}
 		if (LuaTransaction::getInstance().isActive()) {
 			LuaTransaction::getInstance().markTileModified(tile);
 		}
@@ -125,6 +125,44 @@ namespace LuaAPI {
 				return map ? map->getTileCount() : 0;
 			}),
 
+			// Tile, item, creature, house and town counts, as shown by Map Statistics
+			"statistics", sol::property([](Map* map, sol::this_state ts) -> sol::object {
+				sol::state_view lua(ts);
+				if (!map) {
+					return sol::make_object(lua, sol::nil);
+				}
+
+				const MapStatistics statistics = MapStatistics::collect(*map);
+				const TileCounters &counters = statistics.counters;
+				sol::table table = lua.create_table();
+				table["tiles"] = counters.tiles;
+				table["detailedTiles"] = counters.detailed_tiles;
+				table["blockingTiles"] = counters.blocking_tiles;
+				table["walkableTiles"] = counters.walkable_tiles;
+				table["items"] = counters.items;
+				table["moveableItems"] = counters.moveable_items;
+				table["depots"] = counters.depots;
+				table["containers"] = counters.containers;
+				table["actionItems"] = counters.action_items;
+				table["uniqueItems"] = counters.unique_items;
+				table["monsters"] = counters.monsters;
+				table["monsterSpawns"] = counters.monster_spawns;
+				table["npcs"] = counters.npcs;
+				table["npcSpawns"] = counters.npc_spawns;
+				table["towns"] = statistics.towns;
+				table["houses"] = statistics.houses;
+				table["houseTiles"] = statistics.house_tiles;
+				if (statistics.largest_town) {
+					table["largestTown"] = statistics.largest_town->getName();
+					table["largestTownSize"] = statistics.largest_town_size;
+				}
+				if (statistics.largest_house) {
+					table["largestHouse"] = statistics.largest_house->name;
+					table["largestHouseSize"] = statistics.largest_house_size;
+				}
+				return table;
+			}),
+
 			// Get tile methods
 			"getTile", sol::overload([](Map* map, int x, int y, int z) -> Tile* { return map ? map->getTile(x, y, z) : nullptr; }, [](Map* map, const Position &pos) -> Tile* { return map ? map->getTile(pos) : nullptr; }),
 
@@ -25,10 +25,16 @@
 #include "bitmap_to_map_window.h"
 #include "dat_debug_view.h"
 #include "result_window.h"
+#include "map_search.h"
+#include "item_replacer.h"
+#include "unreachable_tiles.h"
+#include "edit_journal.h"
 #include "find_item_window.h"
 #include "settings.h"
 #include "iomap_otbm.h"
 #include "sqlite_materials_inspector.h"
+#include "render_profiler.h"
+#include "sprite_appearances.h"
 #include "lua/lua_script_manager.h"
 #include "lua/lua_scripts_window.h"
 #include "gui.h"
@@ -41,6 +47,7 @@
 #include <wx/tokenzr.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <filesystem>
@@ -48,6 +55,7 @@
 #include <iomanip>
 #include <sstream>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -597,6 +605,9 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 
 	MAKE_ACTION(UNDO, wxITEM_NORMAL, OnUndo);
 	MAKE_ACTION(REDO, wxITEM_NORMAL, OnRedo);
+#ifdef RME_DEVELOPER_TOOLS
+	MAKE_ACTION(UNDO_MEMORY_REPORT, wxITEM_NORMAL, OnUndoMemoryReport);
+#endif
 
 	MAKE_ACTION(FIND_ITEM, wxITEM_NORMAL, OnSearchForItem);
 	MAKE_ACTION(REPLACE_ITEMS, wxITEM_NORMAL, OnReplaceItems);
@@ -695,6 +706,16 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(WIN_SQLITE_MATERIALS_INSPECTOR, wxITEM_NORMAL, OnSQLiteMaterialsInspector);
 	MAKE_ACTION(NEW_PALETTE, wxITEM_NORMAL, OnNewPalette);
 	MAKE_ACTION(TAKE_SCREENSHOT, wxITEM_NORMAL, OnTakeScreenshot);
+	MAKE_ACTION(EXPORT_RENDER_TRACE, wxITEM_NORMAL, OnExportRenderTrace);
+#ifdef RME_DEVELOPER_TOOLS
+	MAKE_ACTION(BENCHMARK_SPRITE_SHEETS, wxITEM_NORMAL, OnBenchmarkSpriteSheets);
+	MAKE_ACTION(BENCHMARK_SPRITE_LOOKUPS, wxITEM_NORMAL, OnBenchmarkSpriteLookups);
+	MAKE_ACTION(BENCHMARK_SELECTION_MOVE, wxITEM_NORMAL, OnBenchmarkSelectionMove);
+	MAKE_ACTION(BENCHMARK_REPLACE_ITEMS, wxITEM_NORMAL, OnBenchmarkReplaceItems);
+	MAKE_ACTION(BENCHMARK_UNREACHABLE_TILES, wxITEM_NORMAL, OnBenchmarkUnreachableTiles);
+	MAKE_ACTION(CHECK_EDIT_JOURNAL, wxITEM_NORMAL, OnCheckEditJournal);
+#endif
+	MAKE_ACTION(VERIFY_ITEM_INDEX, wxITEM_NORMAL, OnVerifyItemIndex);
 
 	MAKE_ACTION(LIVE_START, wxITEM_NORMAL, OnStartLive);
 	MAKE_ACTION(LIVE_JOIN, wxITEM_NORMAL, OnJoinLive);
@@ -878,6 +899,14 @@ void MainMenuBar::Update() {
 	EnableItem(EXPORT_TILESETS, loaded);
 
 	EnableItem(FIND_ITEM, is_host);
+#ifdef RME_DEVELOPER_TOOLS
+	EnableItem(UNDO_MEMORY_REPORT, has_map);
+	EnableItem(BENCHMARK_SELECTION_MOVE, is_local);
+	EnableItem(BENCHMARK_REPLACE_ITEMS, is_local);
+	EnableItem(BENCHMARK_UNREACHABLE_TILES, has_map);
+	EnableItem(CHECK_EDIT_JOURNAL, has_map);
+#endif
+	EnableItem(VERIFY_ITEM_INDEX, has_map);
 	EnableItem(REPLACE_ITEMS, is_local);
 	EnableItem(SEARCH_ON_MAP_EVERYTHING, is_host);
 	EnableItem(SEARCH_ON_MAP_UNIQUE, is_host);
@@ -1190,6 +1219,13 @@ bool MainMenuBar::Load(const FileName &path, wxArrayString &warnings, wxString &
 wxObject* MainMenuBar::LoadItem(pugi::xml_node node, wxMenu* parent, wxArrayString &warnings, wxString &error) {
 	pugi::xml_attribute attribute;
 
+#ifndef RME_DEVELOPER_TOOLS
+	// Benchmarks and diagnostics are only built with the DEVELOPER_TOOLS option
+	if (node.attribute("developer").as_bool()) {
+		return nullptr;
+	}
+#endif
+
 	const std::string &nodeName = as_lower_str(node.name());
 	if (nodeName == "menu") {
 		if (!(attribute = node.attribute("name"))) {
@@ -1629,69 +1665,133 @@ void MainMenuBar::OnRedo(wxCommandEvent &WXUNUSED(event)) {
 	g_gui.DoRedo();
 }
 
-namespace OnSearchForItem {
-	struct Finder {
-		Finder(uint16_t itemId, uint32_t maxCount, bool findTile = false) :
-			itemId(itemId), maxCount(maxCount), findTile(findTile) { }
-
-		bool findTile = false;
-		uint16_t itemId;
-		uint32_t maxCount;
-		std::vector<std::pair<Tile*, Item*>> result;
+#ifdef RME_DEVELOPER_TOOLS
+void MainMenuBar::OnUndoMemoryReport(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
 
-		bool limitReached() const {
-			return result.size() >= (size_t)maxCount;
-		}
+	const auto kilobytes = [](size_t bytes) {
+		return bytes / 1024.0;
+	};
 
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
-			if (result.size() >= (size_t)maxCount) {
-				return;
-			}
+	const ActionQueue* history = editor->getHistoryActions();
+	std::string report = "Action            steps   tiles  deltas   stored KB  full copies KB  on disk  disk KB\n";
+	UndoMemoryStats total;
+	for (const auto &[type, stats] : history->getMemoryStats()) {
+		report += std::format("{:<16} {:>7} {:>7} {:>7} {:>11.1f} {:>15.1f} {:>8} {:>8.1f}\n", nstr(ActionQueue::createLabel(type)), stats.batches, stats.changes, stats.deltas, kilobytes(stats.bytes), kilobytes(stats.full_bytes), stats.spilled, kilobytes(stats.spilled_bytes));
+		total.batches += stats.batches;
+		total.changes += stats.changes;
+		total.deltas += stats.deltas;
+		total.bytes += stats.bytes;
+		total.full_bytes += stats.full_bytes;
+		total.spilled += stats.spilled;
+		total.spilled_bytes += stats.spilled_bytes;
+	}
+	report += std::format("{:<16} {:>7} {:>7} {:>7} {:>11.1f} {:>15.1f} {:>8} {:>8.1f}\n\n", "Total", total.batches, total.changes, total.deltas, kilobytes(total.bytes), kilobytes(total.full_bytes), total.spilled, kilobytes(total.spilled_bytes));
+
+	const auto throughput = [](uint64_t bytes, double seconds) {
+		return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+	};
+	const UndoSpillStats &spill = history->getSpillStats();
+	if (spill.spilled > 0) {
+		report += std::format("Spilled to disk: {} steps, {:.1f} KB compressed to {:.1f} KB at {:.1f} MB/s\n", spill.spilled, kilobytes(spill.spilled_bytes), kilobytes(spill.stored_bytes), throughput(spill.spilled_bytes, spill.spill_seconds));
+		report += std::format("Restored from disk: {} steps, {:.1f} KB at {:.1f} MB/s\n", spill.restored, kilobytes(spill.restored_bytes), throughput(spill.restored_bytes, spill.restore_seconds));
+		report += std::format("Spill file: {:.1f} KB\n\n", kilobytes(spill.file_size));
+	}
+	report += std::format("Undo memory limit: {} MB, item deltas {}", g_settings.getInteger(Config::UNDO_MEM_SIZE), g_settings.getBoolean(Config::UNDO_DELTA_RECORDS) && !editor->IsLive() ? "on" : "off");
+	if (total.bytes > 0) {
+		report += std::format(", {:.1f}x smaller than full tile copies", static_cast<double>(total.full_bytes) / static_cast<double>(total.bytes));
+	}
 
-			if (done % 0x8000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
-			}
+	spdlog::info("Undo history memory:\n{}", report);
+	g_gui.PopupDialog("Undo History Memory", wxstr(report), wxOK);
+}
+#endif
 
-			if (item->getID() == itemId) {
-				result.push_back(std::make_pair(tile, item));
-			}
+namespace OnSearchForItem {
+	// Runs on the search workers; lists each tile at most once for its tile type
+	struct Finder {
+		Finder(uint16_t itemId, bool findTile = false) :
+			findTile(findTile), itemId(itemId),
+			tileSearchType(static_cast<FindItemDialog::SearchTileType>(g_settings.getInteger(Config::FIND_TILE_TYPE))) { }
 
-			if (!findTile) {
-				return;
-			}
+		bool findTile = false;
+		uint16_t itemId;
+		FindItemDialog::SearchTileType tileSearchType;
 
+		bool matchesTileType(const Tile* tile) const {
 			if (tile->isHouseTile()) {
-				return;
+				return false;
 			}
 
-			const auto &tileSearchType = static_cast<FindItemDialog::SearchTileType>(g_settings.getInteger(Config::FIND_TILE_TYPE));
-			if (tileSearchType == FindItemDialog::SearchTileType::NoLogout && !tile->isNoLogout()) {
-				return;
+			switch (tileSearchType) {
+				case FindItemDialog::SearchTileType::NoLogout:
+					return tile->isNoLogout();
+				case FindItemDialog::SearchTileType::PlayerVsPlayer:
+					return tile->isPVP();
+				case FindItemDialog::SearchTileType::NoPlayerVsPlayer:
+					return tile->isNoPVP();
+				case FindItemDialog::SearchTileType::ProtectionZone:
+					return tile->isPZ();
+				default:
+					return true;
 			}
+		}
 
-			if (tileSearchType == FindItemDialog::SearchTileType::PlayerVsPlayer && !tile->isPVP()) {
-				return;
-			}
+		void operator()(MapSearch &scan, Tile* tile, MapSearch::Results &results) const {
+			const bool tileMatches = findTile && matchesTileType(tile);
+			bool listed = false;
+			scan.forEachItem(tile, [&](Item* item) {
+				if (item->getID() == itemId) {
+					results.emplace_back(tile, item);
+					listed = true;
+				}
 
-			if (tileSearchType == FindItemDialog::SearchTileType::NoPlayerVsPlayer && !tile->isNoPVP()) {
-				return;
-			}
+				if (tileMatches && !listed) {
+					results.emplace_back(tile, nullptr);
+					listed = true;
+				}
+			});
+		}
+	};
 
-			if (tileSearchType == FindItemDialog::SearchTileType::ProtectionZone && !tile->isPZ()) {
-				return;
-			}
+	// Streams the results into the search window until maxCount of them are listed
+	template <typename Label>
+	void search(Editor &editor, const Finder &finder, bool selectedOnly, const wxString &message, uint32_t maxCount, Label &&label) {
+		SearchResultWindow* window = g_gui.ShowSearchWindow();
+		window->Clear();
 
-			const auto it = std::ranges::find_if(result, [&tile](const auto &pair) {
-				return pair.first == tile;
-			});
+		MapSearch scan(editor, selectedOnly);
+		if (!finder.findTile) {
+			scan.restrictToItem(finder.itemId);
+		}
 
-			if (it != result.end()) {
-				return;
+		size_t listed = 0;
+		scan.run(
+			message,
+			[&](Tile* tile, MapSearch::Results &results) {
+				finder(scan, tile, results);
+			},
+			[&](const MapSearch::Results &results) {
+				for (const auto &[tile, item] : results) {
+					if (listed >= maxCount) {
+						break;
+					}
+					window->AddPosition(label(tile, item), tile->getPosition());
+					++listed;
+				}
+				return listed < maxCount;
 			}
+		);
 
-			result.push_back(std::make_pair(tile, nullptr));
+		if (listed >= maxCount) {
+			wxString msg;
+			msg << "The configured limit has been reached. Only " << maxCount << " results will be displayed.";
+			g_gui.PopupDialog("Notice", msg, wxOK);
 		}
-	};
+	}
 }
 
 void MainMenuBar::OnSearchForItem(wxCommandEvent &WXUNUSED(event)) {
@@ -1707,47 +1807,26 @@ void MainMenuBar::OnSearchForItem(wxCommandEvent &WXUNUSED(event)) {
 		g_settings.setInteger(Config::FIND_ITEM_MODE, static_cast<int>(dialog.getSearchMode()));
 		g_settings.setInteger(Config::FIND_TILE_TYPE, static_cast<int>(dialog.getSearchTileType()));
 
-		OnSearchForItem::Finder finder(dialog.getResultID(), (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE), dialog.getSearchMode() == FindItemDialog::SearchMode::TileTypes);
-
-		g_gui.CreateLoadBar("Searching map...");
-
-		foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, false);
-		std::vector<std::pair<Tile*, Item*>> &result = finder.result;
-
-		g_gui.DestroyLoadBar();
-
-		if (finder.limitReached()) {
-			wxString msg;
-			msg << "The configured limit has been reached. Only " << finder.maxCount << " results will be displayed.";
-			g_gui.PopupDialog("Notice", msg, wxOK);
-		}
-
-		SearchResultWindow* window = g_gui.ShowSearchWindow();
-		window->Clear();
-
+		const OnSearchForItem::Finder finder(dialog.getResultID(), dialog.getSearchMode() == FindItemDialog::SearchMode::TileTypes);
 		const auto &searchTileType = dialog.getSearchTileType();
 
-		for (auto it = result.begin(); it != result.end(); ++it) {
-			const auto &tile = it->first;
-
-			if (dialog.getSearchMode() == FindItemDialog::SearchMode::TileTypes) {
-				wxString tileType;
-
-				if (tile->isNoLogout() && searchTileType == FindItemDialog::SearchTileType::NoLogout) {
-					tileType = "No Logout";
-				} else if (tile->isPVP() && searchTileType == FindItemDialog::SearchTileType::PlayerVsPlayer) {
-					tileType = "PVP";
-				} else if (tile->isNoPVP() && searchTileType == FindItemDialog::SearchTileType::NoPlayerVsPlayer) {
-					tileType = "No PVP";
-				} else if (tile->isPZ() && searchTileType == FindItemDialog::SearchTileType::ProtectionZone) {
-					tileType = "PZ";
-				}
+		OnSearchForItem::search(*g_gui.GetCurrentEditor(), finder, false, "Searching map...", (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE), [&](Tile* tile, Item* item) {
+			if (!finder.findTile) {
+				return wxstr(item->getName());
+			}
 
-				window->AddPosition(tileType, tile->getPosition());
-			} else {
-				window->AddPosition(wxstr(it->second->getName()), tile->getPosition());
+			wxString tileType;
+			if (tile->isNoLogout() && searchTileType == FindItemDialog::SearchTileType::NoLogout) {
+				tileType = "No Logout";
+			} else if (tile->isPVP() && searchTileType == FindItemDialog::SearchTileType::PlayerVsPlayer) {
+				tileType = "PVP";
+			} else if (tile->isNoPVP() && searchTileType == FindItemDialog::SearchTileType::NoPlayerVsPlayer) {
+				tileType = "No PVP";
+			} else if (tile->isPZ() && searchTileType == FindItemDialog::SearchTileType::ProtectionZone) {
+				tileType = "PZ";
 			}
-		}
+			return tileType;
+		});
 	}
 	dialog.Destroy();
 }
@@ -1776,16 +1855,9 @@ namespace OnSearchForStuff {
 		bool search_action;
 		bool search_container;
 		bool search_writeable;
-		std::vector<std::pair<Tile*, Item*>> found;
-
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
-			if (done % 0x8000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
-			}
+		bool matches(Item* item) const {
 			Container* container;
-			if ((search_unique && item->getUniqueID() > 0) || (search_action && item->getActionID() > 0) || (search_container && ((container = dynamic_cast<Container*>(item)) && container->getItemCount())) || (search_writeable && item && item->getText().length() > 0)) {
-				found.push_back(std::make_pair(tile, item));
-			}
+			return (search_unique && item->getUniqueID() > 0) || (search_action && item->getActionID() > 0) || (search_container && ((container = dynamic_cast<Container*>(item)) && container->getItemCount())) || (search_writeable && item && item->getText().length() > 0);
 		}
 
 		wxString desc(Item* item) {
@@ -1811,10 +1883,9 @@ namespace OnSearchForStuff {
 			return label;
 		}
 
-		void sort() {
-			if (search_unique || search_action) {
-				std::sort(found.begin(), found.end(), Searcher::compare);
-			}
+		// Results by action or unique id are listed by id rather than by position
+		bool sorted() const {
+			return search_unique || search_action;
 		}
 
 		static bool compare(const std::pair<Tile*, Item*> &pair1, const std::pair<Tile*, Item*> &pair2) {
@@ -1880,26 +1951,10 @@ void MainMenuBar::OnSearchForItemOnSelection(wxCommandEvent &WXUNUSED(event)) {
 	FindItemDialog dialog(frame, "Search on Selection", false, true);
 	dialog.setSearchMode((FindItemDialog::SearchMode)g_settings.getInteger(Config::FIND_ITEM_MODE));
 	if (dialog.ShowModal() == wxID_OK) {
-		OnSearchForItem::Finder finder(dialog.getResultID(), (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE), false);
-		g_gui.CreateLoadBar("Searching on selected area...");
-
-		foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, true);
-		std::vector<std::pair<Tile*, Item*>> &result = finder.result;
-
-		g_gui.DestroyLoadBar();
-
-		if (finder.limitReached()) {
-			const auto message = wxString::Format("The configured limit has been reached. Only %lu results will be displayed.", finder.maxCount);
-			g_gui.PopupDialog("Notice", message, wxOK);
-		}
-
-		SearchResultWindow* window = g_gui.ShowSearchWindow();
-		window->Clear();
-		for (std::vector<std::pair<Tile*, Item*>>::const_iterator iter = result.begin(); iter != result.end(); ++iter) {
-			Tile* tile = iter->first;
-			Item* item = iter->second;
-			window->AddPosition(wxstr(item->getName()), tile->getPosition());
-		}
+		const OnSearchForItem::Finder finder(dialog.getResultID());
+		OnSearchForItem::search(*g_gui.GetCurrentEditor(), finder, true, "Searching on selected area...", (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE), [](Tile*, Item* item) {
+			return wxstr(item->getName());
+		});
 
 		g_settings.setInteger(Config::FIND_ITEM_MODE, (int)dialog.getSearchMode());
 	}
@@ -2210,55 +2265,6 @@ void MainMenuBar::OnMapRemoveCorpses(wxCommandEvent &WXUNUSED(event)) {
 	}
 }
 
-namespace OnMapRemoveUnreachable {
-	struct condition {
-		condition() { }
-
-		bool isReachable(Tile* tile) {
-			if (tile == nullptr) {
-				return false;
-			}
-			if (!tile->isBlocking()) {
-				return true;
-			}
-			return false;
-		}
-
-		bool operator()(Map &map, Tile* tile, long long removed, long long done, long long total) {
-			if (done % 0x1000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / total));
-			}
-
-			const Position &pos = tile->getPosition();
-			int sx = std::max(pos.x - 10, 0);
-			int ex = std::min(pos.x + 10, 65535);
-			int sy = std::max(pos.y - 8, 0);
-			int ey = std::min(pos.y + 8, 65535);
-			int sz, ez;
-
-			if (pos.z < 8) {
-				sz = 0;
-				ez = 9;
-			} else {
-				// underground
-				sz = std::max(pos.z - 2, rme::MapGroundLayer);
-				ez = std::min(pos.z + 2, rme::MapMaxLayer);
-			}
-
-			for (int z = sz; z <= ez; ++z) {
-				for (int y = sy; y <= ey; ++y) {
-					for (int x = sx; x <= ex; ++x) {
-						if (isReachable(map.getTile(x, y, z))) {
-							return false;
-						}
-					}
-				}
-			}
-			return true;
-		}
-	};
-}
-
 void MainMenuBar::OnMapRemoveUnreachable(wxCommandEvent &WXUNUSED(event)) {
 	if (!g_gui.IsEditorOpen()) {
 		return;
@@ -2267,22 +2273,50 @@ void MainMenuBar::OnMapRemoveUnreachable(wxCommandEvent &WXUNUSED(event)) {
 	int ok = g_gui.PopupDialog("Remove Unreachable Tiles", "Do you want to remove all unreachable items from the map?", wxYES | wxNO);
 
 	if (ok == wxID_YES) {
+		Map &map = g_gui.GetCurrentMap();
+		g_gui.CreateLoadBar("Searching map for tiles to remove...", true);
+
+		// The search runs aside, so the load bar follows it and can stop it
+		UnreachableTiles unreachable;
+		std::vector<Position> positions;
+		std::atomic<bool> searched = false;
+		{
+			std::jthread search([&] {
+				positions = unreachable.find(map);
+				searched = true;
+			});
+			while (!searched) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				if (!g_gui.SetLoadDone(static_cast<int32_t>(unreachable.progress * 50 / UnreachableTiles::ProgressScale))) {
+					unreachable.stop = true;
+				}
+			}
+		}
+
+		if (unreachable.stop) {
+			g_gui.DestroyLoadBar();
+			return;
+		}
+
 		g_gui.GetCurrentEditor()->getSelection().clear();
 		g_gui.GetCurrentEditor()->clearActions();
 
-		OnMapRemoveUnreachable::condition func;
-		g_gui.CreateLoadBar("Searching map for tiles to remove...");
-
-		long long removed = remove_if_TileOnMap(g_gui.GetCurrentMap(), func);
+		g_gui.SetLoadDone(50, "Removing unreachable tiles...");
+		for (size_t i = 0; i < positions.size(); ++i) {
+			if (i % 0x1000 == 0) {
+				g_gui.SetLoadDone(static_cast<int32_t>(50 + 50 * i / positions.size()));
+			}
+			map.setTile(positions[i], nullptr, true);
+		}
 
 		g_gui.DestroyLoadBar();
 
 		wxString msg;
-		msg << removed << " tiles deleted.";
+		msg << positions.size() << " tiles deleted.";
 
 		g_gui.PopupDialog("Search completed", msg, wxOK);
 
-		g_gui.GetCurrentMap().doChange();
+		map.doChange();
 	}
 }
 
@@ -2522,244 +2556,31 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 		return;
 	}
 
-	g_gui.CreateLoadBar("Collecting data...");
-
-	Map* map = &g_gui.GetCurrentMap();
-
-	int load_counter = 0;
-
-	uint64_t tile_count = 0;
-	uint64_t detailed_tile_count = 0;
-	uint64_t blocking_tile_count = 0;
-	uint64_t walkable_tile_count = 0;
-	double percent_pathable = 0.0;
-	double percent_detailed = 0.0;
-	uint64_t spawn_monster_count = 0;
-	uint64_t spawn_npc_count = 0;
-	uint64_t monster_count = 0;
-	uint64_t npc_count = 0;
-	double monsters_per_spawn = 0.0;
-	double npcs_per_spawn = 0.0;
-
-	uint64_t item_count = 0;
-	uint64_t loose_item_count = 0;
-	uint64_t depot_count = 0;
-	uint64_t action_item_count = 0;
-	uint64_t unique_item_count = 0;
-	uint64_t container_count = 0; // Only includes containers containing more than 1 item
-
-	int town_count = map->towns.count();
-	int house_count = map->houses.count();
-	std::map<uint32_t, uint32_t> town_sqm_count;
-	const Town* largest_town = nullptr;
-	uint64_t largest_town_size = 0;
-	uint64_t total_house_sqm = 0;
-	const House* largest_house = nullptr;
-	uint64_t largest_house_size = 0;
-	double houses_per_town = 0.0;
-	double sqm_per_house = 0.0;
-	double sqm_per_town = 0.0;
-
-	for (MapIterator mit = map->begin(); mit != map->end(); ++mit) {
-		Tile* tile = (*mit)->get();
-		if (load_counter % 8192 == 0) {
-			g_gui.SetLoadDone((unsigned int)(int64_t(load_counter) * 95ll / int64_t(map->getTileCount())));
-		}
-
-		if (tile->empty()) {
-			continue;
-		}
-
-		tile_count += 1;
-
-		bool is_detailed = false;
-#define ANALYZE_ITEM(_item)                                             \
-	{                                                                   \
-		item_count += 1;                                                \
-		if (!(_item)->isGroundTile() && !(_item)->isBorder()) {         \
-			is_detailed = true;                                         \
-			const ItemType &it = g_items.getItemType((_item)->getID()); \
-			if (it.moveable) {                                          \
-				loose_item_count += 1;                                  \
-			}                                                           \
-			if (it.isDepot()) {                                         \
-				depot_count += 1;                                       \
-			}                                                           \
-			if ((_item)->getActionID() > 0) {                           \
-				action_item_count += 1;                                 \
-			}                                                           \
-			if ((_item)->getUniqueID() > 0) {                           \
-				unique_item_count += 1;                                 \
-			}                                                           \
-			if (Container* c = dynamic_cast<Container*>((_item))) {     \
-				if (c->getVector().size()) {                            \
-					container_count += 1;                               \
-				}                                                       \
-			}                                                           \
-		}                                                               \
-	}
-		if (tile->ground) {
-			ANALYZE_ITEM(tile->ground);
-		}
-
-		for (Item* item : tile->items) {
-			ANALYZE_ITEM(item);
-		}
-#undef ANALYZE_ITEM
-
-		if (tile->spawnMonster) {
-			spawn_monster_count += 1;
-		}
-
-		if (tile->spawnNpc) {
-			spawn_npc_count += 1;
-		}
-
-		monster_count += tile->monsters.size();
-
-		if (tile->npc) {
-			npc_count += 1;
-		}
-
-		if (tile->isBlocking()) {
-			blocking_tile_count += 1;
-		} else {
-			walkable_tile_count += 1;
-		}
-
-		if (is_detailed) {
-			detailed_tile_count += 1;
-		}
-
-		load_counter += 1;
-	}
-
-	monsters_per_spawn = (spawn_monster_count != 0 ? double(monster_count) / double(spawn_monster_count) : -1.0);
-	npcs_per_spawn = (spawn_npc_count != 0 ? double(npc_count) / double(spawn_npc_count) : -1.0);
-	percent_pathable = 100.0 * (tile_count != 0 ? double(walkable_tile_count) / double(tile_count) : -1.0);
-	percent_detailed = 100.0 * (tile_count != 0 ? double(detailed_tile_count) / double(tile_count) : -1.0);
-
-	load_counter = 0;
-	Houses &houses = map->houses;
-	for (HouseMap::const_iterator hit = houses.begin(); hit != houses.end(); ++hit) {
-		const House* house = hit->second;
-
-		if (load_counter % 64) {
-			g_gui.SetLoadDone((unsigned int)(95ll + int64_t(load_counter) * 5ll / int64_t(house_count)));
-		}
-
-		if (house->size() > largest_house_size) {
-			largest_house = house;
-			largest_house_size = house->size();
-		}
-		total_house_sqm += house->size();
-		town_sqm_count[house->townid] += house->size();
-	}
-
-	houses_per_town = (town_count != 0 ? double(house_count) / double(town_count) : -1.0);
-	sqm_per_house = (house_count != 0 ? double(total_house_sqm) / double(house_count) : -1.0);
-	sqm_per_town = (town_count != 0 ? double(total_house_sqm) / double(town_count) : -1.0);
-
-	Towns &towns = map->towns;
-	for (std::map<uint32_t, uint32_t>::iterator town_iter = town_sqm_count.begin();
-		 town_iter != town_sqm_count.end();
-		 ++town_iter) {
-		// No load bar for this, load is non-existant
-		uint32_t town_id = town_iter->first;
-		uint32_t town_sqm = town_iter->second;
-		Town* town = towns.getTown(town_id);
-		if (town && town_sqm > largest_town_size) {
-			largest_town = town;
-			largest_town_size = town_sqm;
-		} else {
-			// Non-existant town!
-		}
-	}
-
-	g_gui.DestroyLoadBar();
-
-	std::ostringstream os;
-	os.setf(std::ios::fixed, std::ios::floatfield);
-	os.precision(2);
-	os << "Map statistics for the map \"" << map->getMapDescription() << "\"\n";
-	os << "\tTile data:\n";
-	os << "\t\tTotal number of tiles: " << tile_count << "\n";
-	os << "\t\tNumber of pathable tiles: " << walkable_tile_count << "\n";
-	os << "\t\tNumber of unpathable tiles: " << blocking_tile_count << "\n";
-	if (percent_pathable >= 0.0) {
-		os << "\t\tPercent walkable tiles: " << percent_pathable << "%\n";
-	}
-	os << "\t\tDetailed tiles: " << detailed_tile_count << "\n";
-	if (percent_detailed >= 0.0) {
-		os << "\t\tPercent detailed tiles: " << percent_detailed << "%\n";
-	}
-
-	os << "\tItem data:\n";
-	os << "\t\tTotal number of items: " << item_count << "\n";
-	os << "\t\tNumber of moveable tiles: " << loose_item_count << "\n";
-	os << "\t\tNumber of depots: " << depot_count << "\n";
-	os << "\t\tNumber of containers: " << container_count << "\n";
-	os << "\t\tNumber of items with Action ID: " << action_item_count << "\n";
-	os << "\t\tNumber of items with Unique ID: " << unique_item_count << "\n";
-
-	os << "\tMonster data:\n";
-	os << "\t\tTotal monster count: " << monster_count << "\n";
-	os << "\t\tTotal monster spawn count: " << spawn_monster_count << "\n";
-	os << "\t\tTotal npc count: " << npc_count << "\n";
-	os << "\t\tTotal npc spawn count: " << spawn_npc_count << "\n";
-	if (monsters_per_spawn >= 0) {
-		os << "\t\tMean monsters per spawn: " << monsters_per_spawn << "\n";
-	}
-
-	if (npcs_per_spawn >= 0) {
-		os << "\t\tMean npcs per spawn: " << npcs_per_spawn << "\n";
-	}
-
-	os << "\tTown/House data:\n";
-	os << "\t\tTotal number of towns: " << town_count << "\n";
-	os << "\t\tTotal number of houses: " << house_count << "\n";
-	if (houses_per_town >= 0) {
-		os << "\t\tMean houses per town: " << houses_per_town << "\n";
-	}
-	os << "\t\tTotal amount of housetiles: " << total_house_sqm << "\n";
-	if (sqm_per_house >= 0) {
-		os << "\t\tMean tiles per house: " << sqm_per_house << "\n";
-	}
-	if (sqm_per_town >= 0) {
-		os << "\t\tMean tiles per town: " << sqm_per_town << "\n";
-	}
-
-	if (largest_town) {
-		os << "\t\tLargest Town: \"" << largest_town->getName() << "\" (" << largest_town_size << " sqm)\n";
-	}
-	if (largest_house) {
-		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
-	}
-
-	os << "\n";
-	os << "Generated by Canary's Map Editor version " + __RME_VERSION__ + "\n";
+	Map &map = g_gui.GetCurrentMap();
+	const MapStatistics statistics = MapStatistics::collect(map);
 
 	wxDialog* dg = newd wxDialog(frame, wxID_ANY, "Map Statistics", wxDefaultPosition, wxDefaultSize, wxRESIZE_BORDER | wxCAPTION | wxCLOSE_BOX);
 	wxSizer* topsizer = newd wxBoxSizer(wxVERTICAL);
-	wxTextCtrl* text_field = newd wxTextCtrl(dg, wxID_ANY, wxstr(os.str()), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
+	wxTextCtrl* text_field = newd wxTextCtrl(dg, wxID_ANY, wxstr(statistics.toString(map)), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
 	text_field->SetMinSize(wxSize(400, 300));
 	topsizer->Add(text_field, wxSizerFlags(5).Expand());
 
 	wxSizer* choicesizer = newd wxBoxSizer(wxHORIZONTAL);
 	wxButton* export_button = newd wxButton(dg, wxID_OK, "Export as XML");
 	choicesizer->Add(export_button, wxSizerFlags(1).Center());
-	export_button->Enable(false);
 	choicesizer->Add(newd wxButton(dg, wxID_CANCEL, "OK"), wxSizerFlags(1).Center());
 	topsizer->Add(choicesizer, wxSizerFlags(1).Center());
 	dg->SetSizerAndFit(topsizer);
 	dg->Centre(wxBOTH);
 
 	int ret = dg->ShowModal();
+	dg->Destroy();
 
 	if (ret == wxID_OK) {
-		// std::cout << "XML EXPORT";
-	} else if (ret == wxID_CANCEL) {
-		// std::cout << "OK";
+		wxFileDialog dialog(frame, "Export Map Statistics", "", "map_statistics.xml", "XML files (*.xml)|*.xml", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+		if (dialog.ShowModal() == wxID_OK && !statistics.saveXml(nstr(dialog.GetPath()), map)) {
+			g_gui.PopupDialog("Export Map Statistics", "Could not write \"" + dialog.GetPath() + "\".", wxOK);
+		}
 	}
 }
 
@@ -2838,6 +2659,370 @@ void MainMenuBar::OnTakeScreenshot(wxCommandEvent &WXUNUSED(event)) {
 	);
 }
 
+void MainMenuBar::OnExportRenderTrace(wxCommandEvent &WXUNUSED(event)) {
+	if (g_renderProfiler.getTraceEventCount() == 0) {
+		g_gui.PopupDialog("Export Render Trace", "No frames have been recorded yet.\nEnable \"Show performance statistics\" in the preferences and draw a few frames first.", wxOK);
+		return;
+	}
+
+	wxFileDialog dialog(frame, "Export Render Trace", "", "render_trace.json", "Chrome trace (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (dialog.ShowModal() != wxID_OK) {
+		return;
+	}
+
+	if (!g_renderProfiler.exportChromeTrace(nstr(dialog.GetPath()))) {
+		g_gui.PopupDialog("Export Render Trace", "Could not write \"" + dialog.GetPath() + "\".", wxOK);
+	}
+}
+
+#ifdef RME_DEVELOPER_TOOLS
+void MainMenuBar::OnBenchmarkSpriteSheets(wxCommandEvent &WXUNUSED(event)) {
+	if (g_spriteAppearances.getSheets().empty()) {
+		g_gui.PopupDialog("Benchmark Sprite Sheets", "No client sprite sheets are loaded.", wxOK);
+		return;
+	}
+
+	g_gui.CreateLoadBar("Reading and decoding sprite sheets...", true);
+	const SpriteSheetBenchmark result = g_spriteAppearances.benchmarkSpriteSheets();
+	g_gui.DestroyLoadBar();
+	if (result.cancelled) {
+		return;
+	}
+
+	const auto throughput = [](uint64_t bytes, double ms) {
+		return ms > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+	};
+	const size_t decoded = result.sheets - result.failed;
+	const std::string report = std::format(
+		"{} sheets, {:.1f} MB on disk, {:.1f} MB decoded, {} failed\n\n"
+		"Single thread:\n"
+		"  read    {:.0f} ms ({:.1f} MB/s)\n"
+		"  decode  {:.0f} ms ({:.1f} MB/s compressed, {:.1f} sheets/s)\n\n"
+		"{} threads, read and decode:\n"
+		"  {:.0f} ms ({:.1f} sheets/s)",
+		result.sheets, result.file_bytes / (1024.0 * 1024.0), result.decoded_bytes / (1024.0 * 1024.0), result.failed,
+		result.read_ms, throughput(result.file_bytes, result.read_ms),
+		result.decode_ms, throughput(result.file_bytes, result.decode_ms), result.decode_ms > 0.0 ? decoded * 1000.0 / result.decode_ms : 0.0,
+		result.threads, result.parallel_ms, result.parallel_ms > 0.0 ? result.sheets * 1000.0 / result.parallel_ms : 0.0
+	);
+	spdlog::info("Sprite sheet benchmark:\n{}", report);
+	g_gui.PopupDialog("Benchmark Sprite Sheets", wxstr(report), wxOK);
+}
+
+void MainMenuBar::OnBenchmarkSpriteLookups(wxCommandEvent &WXUNUSED(event)) {
+	if (g_spriteAppearances.getSheets().empty()) {
+		g_gui.PopupDialog("Benchmark Sprite Lookups", "No client sprite sheets are loaded.", wxOK);
+		return;
+	}
+
+	// About the number of sprites drawn on a zoomed out, fully stacked viewport
+	constexpr size_t VisibleSprites = 16384;
+
+	wxBusyCursor busy;
+	const SpriteLookupBenchmark result = g_spriteAppearances.benchmarkSpriteLookups(VisibleSprites);
+	const std::string report = std::format(
+		"{} sampled sprite ids ({} without a location skipped), {} lookups\n\n"
+		"Ordered map + sheet binary search:\n"
+		"  {:.1f} ns per blit, {:.2f} ms per {} blits, ~{:.1f} MB\n\n"
+		"Flat tables:\n"
+		"  {:.1f} ns per blit, {:.2f} ms per {} blits, {:.1f} MB\n\n"
+		"Results {}",
+		result.samples, result.skipped, result.lookups,
+		result.tree_ns, result.tree_ns * result.samples / 1e6, result.samples, result.tree_bytes / (1024.0 * 1024.0),
+		result.table_ns, result.table_ns * result.samples / 1e6, result.samples, result.table_bytes / (1024.0 * 1024.0),
+		result.consistent ? "match" : "DIFFER"
+	);
+	spdlog::info("Sprite lookup benchmark:\n{}", report);
+	g_gui.PopupDialog("Benchmark Sprite Lookups", wxstr(report), wxOK);
+}
+
+void MainMenuBar::OnBenchmarkSelectionMove(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	MapTab* tab = g_gui.GetCurrentMapTab();
+	if (!editor || !tab) {
+		return;
+	}
+
+	// A 100x100 area on the eight floors above ground, moved a few tiles so source and destination overlap
+	constexpr int AreaSize = 100;
+	const Position center = tab->GetScreenCenterPosition();
+	const Position start(std::max(center.x - AreaSize / 2, 0), std::max(center.y - AreaSize / 2, 0), rme::MapGroundLayer);
+	const Position end(start.x + AreaSize - 1, start.y + AreaSize - 1, rme::MapMinLayer);
+	const Position offset(-10, -10, 0);
+
+	const auto millisecondsSince = [](std::chrono::steady_clock::time_point since) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+	};
+
+	wxBusyCursor busy;
+
+	// The benchmark runs on a copy of the area and the ring its move and borders
+	// reach, so the user's map, selection and history are left alone
+	Editor scratch(editor->copybuffer);
+	Map &source = editor->getMap();
+	Map &copy = scratch.getMap();
+	copy.setWidth(source.getWidth());
+	copy.setHeight(source.getHeight());
+	for (int z = end.z; z <= start.z; ++z) {
+		for (int y = std::max(start.y + offset.y - 2, 0); y <= end.y + 2; ++y) {
+			for (int x = std::max(start.x + offset.x - 2, 0); x <= end.x + 2; ++x) {
+				if (const Tile* tile = source.getTile(x, y, z)) {
+					copy.setTile(x, y, z, tile->deepCopy(copy));
+				}
+			}
+		}
+	}
+
+	Selection &selection = scratch.getSelection();
+	auto timer = std::chrono::steady_clock::now();
+	selection.start();
+	selection.addArea(start, end, false);
+	selection.finish();
+	const double select_ms = millisecondsSince(timer);
+
+	if (selection.empty()) {
+		g_gui.PopupDialog("Benchmark Selection Move", "There are no tiles on floors 0-7 around the center of the view.", wxOK);
+		return;
+	}
+
+	const SelectionMoveStats stats = scratch.moveSelection(offset);
+
+	timer = std::chrono::steady_clock::now();
+	scratch.undo();
+	const double undo_ms = millisecondsSince(timer);
+
+	timer = std::chrono::steady_clock::now();
+	scratch.redo();
+	const double redo_ms = millisecondsSince(timer);
+
+	const std::string report = std::format(
+		"{} tiles in {},{} - {},{} on floors {}-{}, moved by {},{}\n"
+		"{} moved whole, {} fixed up around the areas\n\n"
+		"select   {:.1f} ms\n"
+		"move     {:.1f} ms\n"
+		"  detach   {:.1f} ms\n"
+		"  place    {:.1f} ms\n"
+		"  borders  {:.1f} ms\n"
+		"undo     {:.1f} ms\n"
+		"redo     {:.1f} ms",
+		stats.tiles, start.x, start.y, end.x, end.y, end.z, start.z, -offset.x, -offset.y,
+		stats.whole_tiles, stats.border_tiles,
+		select_ms, stats.total_ms, stats.detach_ms, stats.place_ms, stats.border_ms, undo_ms, redo_ms
+	);
+	spdlog::info("Selection move benchmark:\n{}", report);
+	g_gui.PopupDialog("Benchmark Selection Move", wxstr(report), wxOK);
+}
+
+void MainMenuBar::OnBenchmarkReplaceItems(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
+
+	// The 20 most common ids that are not grounds, each replaced by one of the next 20
+	constexpr size_t RuleCount = 20;
+	Map &map = editor->getMap();
+
+	wxBusyCursor busy;
+	std::vector<size_t> counts(g_items.getMaxID() + 1, 0);
+	if (const ItemIndex* index = map.getItemIndex()) {
+		for (size_t id = 1; id < counts.size(); ++id) {
+			counts[id] = index->count(static_cast<uint16_t>(id));
+		}
+	} else {
+		auto count = [&counts](Map &, Tile*, Item* item, long long) {
+			if (item->getID() < counts.size()) {
+				++counts[item->getID()];
+			}
+		};
+		foreach_ItemOnMap(map, count, false);
+	}
+
+	std::vector<uint16_t> ids;
+	for (size_t id = 1; id < counts.size(); ++id) {
+		if (counts[id] > 0 && !g_items.getItemType(static_cast<uint16_t>(id)).isGroundTile()) {
+			ids.push_back(static_cast<uint16_t>(id));
+		}
+	}
+	if (ids.size() < RuleCount * 2) {
+		g_gui.PopupDialog("Benchmark Item Replace", wxString::Format("The map needs at least %zu different item ids that are not grounds.", RuleCount * 2), wxOK);
+		return;
+	}
+	std::partial_sort(ids.begin(), ids.begin() + RuleCount * 2, ids.end(), [&counts](uint16_t a, uint16_t b) {
+		return counts[a] > counts[b];
+	});
+
+	ItemReplacer replacer(*editor, false);
+	size_t expected = 0;
+	for (size_t rule = 0; rule < RuleCount; ++rule) {
+		replacer.addRule(ids[rule], ids[RuleCount + rule]);
+		expected += counts[ids[rule]];
+	}
+
+	BatchAction* batch = replacer.run();
+	const ItemReplaceStats &stats = replacer.getStats();
+	if (!batch) {
+		g_gui.PopupDialog("Benchmark Item Replace", stats.cancelled ? "The benchmark was cancelled." : "No item was replaced.", wxOK);
+		return;
+	}
+
+	const size_t undo_bytes = batch->memsize(true);
+	const size_t full_bytes = batch->fullsize();
+
+	const auto millisecondsSince = [](std::chrono::steady_clock::time_point since) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+	};
+
+	// The batch never enters the history, so the user's undo and redo steps stay as they are
+	auto timer = std::chrono::steady_clock::now();
+	batch->undo();
+	const double undo_ms = millisecondsSince(timer);
+
+	timer = std::chrono::steady_clock::now();
+	batch->redo();
+	const double redo_ms = millisecondsSince(timer);
+
+	// Leave the map as it was
+	batch->undo();
+	delete batch;
+	g_gui.RefreshView(false);
+
+	const std::string report = std::format(
+		"{} rules, {} items on {} tiles replaced ({} expected)\n\n"
+		"replace  {:.1f} ms\n"
+		"  scan     {:.1f} ms\n"
+		"  apply    {:.1f} ms\n"
+		"undo     {:.1f} ms\n"
+		"redo     {:.1f} ms\n\n"
+		"undo memory {:.1f} MiB, {:.1f} MiB as full tile copies",
+		RuleCount, stats.items, stats.tiles, expected,
+		stats.total_ms, stats.scan_ms, stats.apply_ms, undo_ms, redo_ms,
+		undo_bytes / 1048576.0, full_bytes / 1048576.0
+	);
+	spdlog::info("Item replace benchmark:\n{}", report);
+	g_gui.PopupDialog("Benchmark Item Replace", wxstr(report), wxOK);
+}
+
+void MainMenuBar::OnBenchmarkUnreachableTiles(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
+
+	Map &map = editor->getMap();
+	const auto secondsSince = [](std::chrono::steady_clock::time_point since) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+	};
+
+	auto timer = std::chrono::steady_clock::now();
+	UnreachableTiles unreachable;
+	const std::vector<Position> found = unreachable.find(map);
+	const double masks_seconds = secondsSince(timer);
+
+	// The neighbourhood lookups take long on large maps, so they can be stopped and compared as far as they got
+	g_gui.CreateLoadBar("Checking every tile's neighbourhood...", true);
+	size_t checked = 0;
+	size_t legacy_found = 0;
+	size_t mismatches = 0;
+	bool cancelled = false;
+	const size_t total = std::max<size_t>(map.getTileCount(), 1);
+	timer = std::chrono::steady_clock::now();
+	for (MapIterator it = map.begin(), end = map.end(); it != end; ++it) {
+		const Tile* tile = (*it)->get();
+		if (!tile) {
+			continue;
+		}
+
+		if (checked % 0x1000 == 0 && !g_gui.SetLoadDone(static_cast<int32_t>(100 * checked / total))) {
+			cancelled = true;
+			break;
+		}
+
+		const Position &position = tile->getPosition();
+		const bool legacy = UnreachableTiles::isUnreachable(map, position);
+		legacy_found += legacy;
+		if (legacy != std::binary_search(found.begin(), found.end(), position)) {
+			if (mismatches < 20) {
+				spdlog::warn("[UnreachableTiles] - Tile {}:{}:{} differs, the neighbourhood lookup finds it {}", position.x, position.y, position.z, legacy ? "unreachable" : "reachable");
+			}
+			++mismatches;
+		}
+		++checked;
+	}
+	const double legacy_seconds = secondsSince(timer);
+	g_gui.DestroyLoadBar();
+
+	std::string report = std::format(
+		"{} tiles, {} unreachable\n\n"
+		"block masks          {:.3f} s\n"
+		"neighbourhood lookup {:.3f} s{}\n\n",
+		map.getTileCount(), found.size(),
+		masks_seconds, legacy_seconds, cancelled ? std::format(" (stopped after {} tiles)", checked) : std::string()
+	);
+	if (mismatches == 0) {
+		report += std::format("Both agree on the {} tiles checked, {} of them unreachable.", checked, legacy_found);
+	} else {
+		report += std::format("{} of the {} tiles checked differ, see the log.", mismatches, checked);
+	}
+
+	if (mismatches == 0) {
+		spdlog::info("Unreachable tiles benchmark:\n{}", report);
+	} else {
+		spdlog::warn("Unreachable tiles benchmark:\n{}", report);
+	}
+	g_gui.PopupDialog("Benchmark Unreachable Tiles", wxstr(report), wxOK);
+}
+
+void MainMenuBar::OnCheckEditJournal(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
+
+	wxBusyCursor busy;
+	const auto start = std::chrono::steady_clock::now();
+	std::string report;
+	const bool passed = EditJournal::check(editor->getMap(), report);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report += std::format("Checked in {:.2f} s", seconds);
+
+	if (passed) {
+		spdlog::info("Edit journal check:\n{}", report);
+	} else {
+		spdlog::warn("Edit journal check:\n{}", report);
+	}
+	g_gui.PopupDialog("Check Edit Journal", wxstr(report), wxOK);
+}
+#endif
+
+void MainMenuBar::OnVerifyItemIndex(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
+
+	wxBusyCursor busy;
+	const auto start = std::chrono::steady_clock::now();
+	std::string report;
+	const bool consistent = editor->getMap().verifyItemIndex(report);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (consistent) {
+		report += std::format("The item index matches the {} tiles of the map.\n", editor->getMap().getTileCount());
+	}
+	if (const ItemIndex* index = editor->getMap().getItemIndex()) {
+		report += std::format("The index holds {:.1f} MiB.\n", index->memoryUsage() / 1048576.0);
+	}
+	report += std::format("Checked in {:.2f} s", seconds);
+
+	if (consistent) {
+		spdlog::info("Item index verification:\n{}", report);
+	} else {
+		spdlog::warn("Item index verification:\n{}", report);
+	}
+	g_gui.PopupDialog("Verify Item Index", wxstr(report), wxOK);
+}
+
 void MainMenuBar::OnZoomIn(wxCommandEvent &event) {
 	double zoom = g_gui.GetCurrentZoom();
 	g_gui.SetCurrentZoom(zoom - 0.1);
@@ -3127,25 +3312,41 @@ void MainMenuBar::SearchItems(bool unique, bool action, bool container, bool wri
 
 	const auto searchType = onSelection ? "selected area" : "map";
 
-	g_gui.CreateLoadBar(wxString::Format("Searching on %s...", searchType));
-
 	OnSearchForStuff::Searcher searcher;
 	searcher.search_unique = unique;
 	searcher.search_action = action;
 	searcher.search_container = container;
 	searcher.search_writeable = writable;
 
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), searcher, onSelection);
-	searcher.sort();
-	std::vector<std::pair<Tile*, Item*>> &found = searcher.found;
-
-	g_gui.DestroyLoadBar();
-
 	SearchResultWindow* result = g_gui.ShowSearchWindow();
 	result->Clear();
 
-	for (std::vector<std::pair<Tile*, Item*>>::iterator iter = found.begin(); iter != found.end(); ++iter) {
-		result->AddPosition(searcher.desc(iter->second), iter->first->getPosition());
+	MapSearch scan(*g_gui.GetCurrentEditor(), onSelection);
+	std::vector<std::pair<Tile*, Item*>> found;
+	scan.run(
+		wxString::Format("Searching on %s...", searchType),
+		[&](Tile* tile, MapSearch::Results &results) {
+			scan.forEachItem(tile, [&](Item* item) {
+				if (searcher.matches(item)) {
+					results.emplace_back(tile, item);
+				}
+			});
+		},
+		[&](const MapSearch::Results &results) {
+			for (const auto &[tile, item] : results) {
+				result->AddPosition(searcher.desc(item), tile->getPosition());
+			}
+			found.insert(found.end(), results.begin(), results.end());
+			return true;
+		}
+	);
+
+	if (searcher.sorted()) {
+		std::stable_sort(found.begin(), found.end(), OnSearchForStuff::Searcher::compare);
+		result->Clear();
+		for (const auto &[tile, item] : found) {
+			result->AddPosition(searcher.desc(item), tile->getPosition());
+		}
 	}
 }
 
@@ -3173,37 +3374,61 @@ void MainMenuBar::OnSearchForWallsUponWallsOnSelection(wxCommandEvent &WXUNUSED(
 	SearchWallsUponWalls(true);
 }
 
-namespace SearchDuplicatedItems {
-	struct condition {
-		std::unordered_set<Tile*> foundTiles;
-
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
-			if (done % 0x8000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
+namespace SearchTiles {
+	// Lists, in map order, the tiles on which the condition holds for some item
+	template <typename Condition>
+	size_t search(const Condition &condition, bool onSelection, const wxString &label) {
+		SearchResultWindow* result = g_gui.ShowSearchWindow();
+		result->Clear();
+
+		MapSearch scan(*g_gui.GetCurrentEditor(), onSelection);
+		size_t found = 0;
+		scan.run(
+			wxString::Format("Searching on %s...", onSelection ? "selected area" : "map"),
+			[&](Tile* tile, MapSearch::Results &results) {
+				bool hit = false;
+				scan.forEachItem(tile, [&](const Item* item) {
+					hit = hit || condition(tile, item);
+				});
+				if (hit) {
+					results.emplace_back(tile, nullptr);
+				}
+			},
+			[&](const MapSearch::Results &results) {
+				for (const auto &[tile, item] : results) {
+					result->AddPosition(label, tile->getPosition());
+				}
+				found += results.size();
+				return true;
 			}
+		);
+		return found;
+	}
+}
 
+namespace SearchDuplicatedItems {
+	struct condition {
+		bool operator()(const Tile* tile, const Item* item) const {
 			if (!tile) {
-				return;
+				return false;
 			}
 
 			if (!item) {
-				return;
+				return false;
 			}
 
 			if (item->isGroundTile()) {
-				return;
+				return false;
 			}
 
-			if (foundTiles.count(tile) == 0) {
-				std::unordered_set<int> itemIDs;
-				for (Item* existingItem : tile->items) {
-					if (itemIDs.count(existingItem->getID()) > 0 && !existingItem->hasElevation()) {
-						foundTiles.insert(tile);
-						break;
-					}
-					itemIDs.insert(existingItem->getID());
+			std::unordered_set<int> itemIDs;
+			for (Item* existingItem : tile->items) {
+				if (itemIDs.count(existingItem->getID()) > 0 && !existingItem->hasElevation()) {
+					return true;
 				}
+				itemIDs.insert(existingItem->getID());
 			}
+			return false;
 		}
 	};
 }
@@ -3213,26 +3438,9 @@ void MainMenuBar::SearchDuplicatedItems(bool onSelection /* = false*/) {
 		return;
 	}
 
-	const auto searchType = onSelection ? "selected area" : "map";
-
-	g_gui.CreateLoadBar(wxString::Format("Searching on %s...", searchType));
-
-	SearchDuplicatedItems::condition finder;
-
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, onSelection);
-	std::unordered_set<Tile*> &foundTiles = finder.foundTiles;
-
-	g_gui.DestroyLoadBar();
-
-	const auto tilesFoundAmount = foundTiles.size();
+	const auto tilesFoundAmount = SearchTiles::search(SearchDuplicatedItems::condition(), onSelection, "Duplicated items");
 
 	g_gui.PopupDialog("Search completed", wxString::Format("%zu tiles with duplicated items founded.", tilesFoundAmount), wxOK);
-
-	SearchResultWindow* result = g_gui.ShowSearchWindow();
-	result->Clear();
-	for (const Tile* tile : foundTiles) {
-		result->AddPosition("Duplicated items", tile->getPosition());
-	}
 }
 
 namespace RemoveDuplicatesItems {
@@ -3307,45 +3515,33 @@ void MainMenuBar::RemoveDuplicatesItems(bool onSelection /* = false*/) {
 
 namespace SearchWallsUponWalls {
 	struct condition {
-		std::unordered_set<Tile*> foundTiles;
-
-		void operator()(const Map &map, Tile* tile, const Item* item, long long done) {
-			if (done % 0x8000 == 0) {
-				g_gui.SetLoadDone(static_cast<unsigned int>(100 * done / map.getTileCount()));
-			}
-
+		bool operator()(const Tile* tile, const Item* item) const {
 			if (!tile) {
-				return;
+				return false;
 			}
 
 			if (!item) {
-				return;
+				return false;
 			}
 
 			if (!item->isBlockMissiles()) {
-				return;
+				return false;
 			}
 
 			if (!item->isWall() && !item->isDoor()) {
-				return;
+				return false;
 			}
 
-			std::unordered_set<int> itemIDs;
 			for (const Item* itemInTile : tile->items) {
 				if (!itemInTile || (!itemInTile->isWall() && !itemInTile->isDoor())) {
 					continue;
 				}
 
 				if (item->getID() != itemInTile->getID()) {
-					itemIDs.insert(itemInTile->getID());
+					return true;
 				}
 			}
-
-			if (!itemIDs.empty()) {
-				foundTiles.insert(tile);
-			}
-
-			itemIDs.clear();
+			return false;
 		}
 	};
 }
@@ -3355,25 +3551,7 @@ void MainMenuBar::SearchWallsUponWalls(bool onSelection /* = false*/) {
 		return;
 	}
 
-	const auto searchType = onSelection ? "selected area" : "map";
-
-	g_gui.CreateLoadBar(wxString::Format("Searching on %s...", searchType));
-
-	SearchWallsUponWalls::condition finder;
-
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, onSelection);
-
-	const std::unordered_set<Tile*> &foundTiles = finder.foundTiles;
-
-	g_gui.DestroyLoadBar();
-
-	const auto tilesFoundAmount = foundTiles.size();
+	const auto tilesFoundAmount = SearchTiles::search(SearchWallsUponWalls::condition(), onSelection, "Item Under");
 
 	g_gui.PopupDialog("Search completed", wxString::Format("%zu items under walls and doors founded.", tilesFoundAmount), wxOK);
-
-	SearchResultWindow* result = g_gui.ShowSearchWindow();
-	result->Clear();
-	for (const Tile* tile : foundTiles) {
-		result->AddPosition("Item Under", tile->getPosition());
-	}
 }
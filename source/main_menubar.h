@@ -45,6 +45,9 @@ namespace MenuBar {
 		EXIT,
 		UNDO,
 		REDO,
+#ifdef RME_DEVELOPER_TOOLS
+		UNDO_MEMORY_REPORT,
+#endif
 		FIND_ITEM,
 		REPLACE_ITEMS,
 		SEARCH_ON_MAP_EVERYTHING,
@@ -134,6 +137,16 @@ namespace MenuBar {
 		WIN_SQLITE_MATERIALS_INSPECTOR,
 		NEW_PALETTE,
 		TAKE_SCREENSHOT,
+		EXPORT_RENDER_TRACE,
+#ifdef RME_DEVELOPER_TOOLS
+		BENCHMARK_SPRITE_SHEETS,
+		BENCHMARK_SPRITE_LOOKUPS,
+		BENCHMARK_SELECTION_MOVE,
+		BENCHMARK_REPLACE_ITEMS,
+		BENCHMARK_UNREACHABLE_TILES,
+		CHECK_EDIT_JOURNAL,
+#endif
+		VERIFY_ITEM_INDEX,
 		LIVE_START,
 		LIVE_JOIN,
 		LIVE_CLOSE,
@@ -229,6 +242,9 @@ public:
 
 	// Edit Menu
 	void OnUndo(wxCommandEvent &event);
+#ifdef RME_DEVELOPER_TOOLS
+	void OnUndoMemoryReport(wxCommandEvent &event);
+#endif
 	void OnRedo(wxCommandEvent &event);
 	void OnBorderizeSelection(wxCommandEvent &event);
 	void OnBorderizeMap(wxCommandEvent &event);
@@ -300,6 +316,16 @@ public:
 	void OnSQLiteMaterialsInspector(wxCommandEvent &event);
 	void OnNewPalette(wxCommandEvent &event);
 	void OnTakeScreenshot(wxCommandEvent &event);
+	void OnExportRenderTrace(wxCommandEvent &event);
+#ifdef RME_DEVELOPER_TOOLS
+	void OnBenchmarkSpriteSheets(wxCommandEvent &event);
+	void OnBenchmarkSpriteLookups(wxCommandEvent &event);
+	void OnBenchmarkSelectionMove(wxCommandEvent &event);
+	void OnBenchmarkReplaceItems(wxCommandEvent &event);
+	void OnBenchmarkUnreachableTiles(wxCommandEvent &event);
+	void OnCheckEditJournal(wxCommandEvent &event);
+#endif
+	void OnVerifyItemIndex(wxCommandEvent &event);
 	void OnSelectTerrainPalette(wxCommandEvent &event);
 	void OnSelectDoodadPalette(wxCommandEvent &event);
 	void OnSelectItemPalette(wxCommandEvent &event);
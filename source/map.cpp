@@ -244,6 +244,7 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
 		}
 	}
+	invalidateTileIndexes();
 
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
@@ -281,6 +282,7 @@ void Map::cleanInvalidTiles(bool showdialog) {
 			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
 		}
 	}
+	invalidateTileIndexes();
 
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
@@ -351,6 +353,26 @@ bool Map::clearChanges() {
 	return doupdate;
 }
 
+void Map::addDamagedArea(const Position &from, const Position &to) {
+	if (damaged_areas.size() >= MaxDamagedAreas) {
+		damage_base += damaged_areas.size();
+		damaged_areas.clear();
+	}
+	damaged_areas.push_back({ from, to });
+}
+
+bool Map::getDamagedAreas(uint64_t generation, std::vector<MapDamageArea> &areas) const {
+	if (generation < damage_base) {
+		return false;
+	}
+
+	const size_t first = static_cast<size_t>(generation - damage_base);
+	if (first < damaged_areas.size()) {
+		areas.insert(areas.end(), damaged_areas.begin() + first, damaged_areas.end());
+	}
+	return true;
+}
+
 void Map::setWidth(int new_width) {
 	if (new_width > 65000) {
 		width = 65000;
@@ -409,6 +431,7 @@ bool Map::addSpawnMonster(Tile* tile) {
 				ctile_loc->increaseSpawnCount();
 			}
 		}
+		addDamagedArea(Position(start_x, start_y, z), Position(end_x, end_y, z));
 		spawnsMonster.addSpawnMonster(tile);
 		return true;
 	}
@@ -433,6 +456,7 @@ void Map::removeSpawnMonsterInternal(Tile* tile) {
 			}
 		}
 	}
+	addDamagedArea(Position(start_x, start_y, z), Position(end_x, end_y, z));
 }
 
 void Map::removeSpawnMonster(Tile* tile) {
@@ -539,6 +563,7 @@ bool Map::addSpawnNpc(Tile* tile) {
 				ctile_loc->increaseSpawnNpcCount();
 			}
 		}
+		addDamagedArea(Position(start_x, start_y, z), Position(end_x, end_y, z));
 		spawnsNpc.addSpawnNpc(tile);
 		return true;
 	}
@@ -563,6 +588,7 @@ void Map::removeSpawnNpcInternal(Tile* tile) {
 			}
 		}
 	}
+	addDamagedArea(Position(start_x, start_y, z), Position(end_x, end_y, z));
 }
 
 void Map::removeSpawnNpc(Tile* tile) {
@@ -835,6 +861,43 @@ void Map::updateUniqueIds(Tile* old_tile, Tile* new_tile) {
 	}
 }
 
+void Map::updateTileIndexes(const Tile* old_tile, const Tile* new_tile) {
+	itemIndex.update(old_tile, new_tile);
+	tileStatistics.update(old_tile, new_tile);
+}
+
+const ItemIndex* Map::getItemIndex() {
+	if (!g_settings.getBoolean(Config::ITEM_INDEX)) {
+		itemIndex.invalidate();
+		return nullptr;
+	}
+
+	if (!itemIndex.isValid()) {
+		itemIndex.build(*this);
+	}
+	return &itemIndex;
+}
+
+const TileCounters &Map::getTileCounters() {
+	if (!tileStatistics.isValid()) {
+		tileStatistics.build(*this);
+	}
+	return tileStatistics.getCounters();
+}
+
+bool Map::verifyItemIndex(std::string &report) {
+	const bool was_valid = itemIndex.isValid();
+	const ItemIndex* index = getItemIndex();
+	if (!index) {
+		report = "The item index is turned off.\n";
+		return false;
+	}
+	if (!was_valid) {
+		report = "The item index was out of date and has been built again.\n";
+	}
+	return index->verify(*this, report);
+}
+
 void Map::addUniqueId(uint16_t uid) {
 	auto it = std::find(uniqueIds.begin(), uniqueIds.end(), uid);
 	if (it == uniqueIds.end()) {
@@ -881,6 +944,9 @@ int64_t RemoveMonstersOnMap(Map &map, bool selectedOnly) {
 
 		++it;
 	}
+	if (removed > 0) {
+		map.invalidateTileIndexes();
+	}
 	return removed;
 }
 
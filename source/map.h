@@ -28,6 +28,13 @@
 #include "zones.h"
 #include "templates.h"
 #include "spawn_npc.h"
+#include "item_index.h"
+#include "map_statistics.h"
+
+struct MapDamageArea {
+	Position from;
+	Position to;
+};
 
 class Map : public BaseMap {
 public:
@@ -150,6 +157,38 @@ public:
 
 	bool hasUniqueId(uint16_t uid) const;
 
+	// Where each item id is on the map, built first if it is not up to date;
+	// nullptr when the index is turned off in the preferences
+	const ItemIndex* getItemIndex();
+	// For changes made to tiles while they are on the map, which the item index,
+	// the tile statistics and the damage log can not follow
+	void invalidateTileIndexes() {
+		itemIndex.invalidate();
+		tileStatistics.invalidate();
+		addDamagedMap();
+	}
+	// Checks the index against a scan of the whole map, the differences go to report
+	bool verifyItemIndex(std::string &report);
+	// Counts of the tiles of the map, counted first if they are not up to date
+	const TileCounters &getTileCounters();
+
+	// Areas changed since the views last drew them, so a view can repaint only
+	// the damaged part of its cached scene. Old entries are dropped once the log
+	// is full; getDamagedAreas then returns false and the view redraws fully.
+	void addDamagedArea(const Position &from, const Position &to);
+	void addDamagedPosition(const Position &position) {
+		addDamagedArea(position, position);
+	}
+	// Drops the log, so every view redraws its whole scene
+	void addDamagedMap() {
+		damage_base += damaged_areas.size() + 1;
+		damaged_areas.clear();
+	}
+	uint64_t getDamageGeneration() const noexcept {
+		return damage_base + damaged_areas.size();
+	}
+	bool getDamagedAreas(uint64_t generation, std::vector<MapDamageArea> &areas) const;
+
 protected:
 	// Loads a map
 	bool open(const std::string identifier);
@@ -183,6 +222,7 @@ public:
 
 protected:
 	void updateUniqueIds(Tile* old_tile, Tile* new_tile) override;
+	void updateTileIndexes(const Tile* old_tile, const Tile* new_tile) override;
 	void addUniqueId(uint16_t uid);
 	void removeUniqueId(uint16_t uid);
 
@@ -198,9 +238,49 @@ public:
 	Zones zones;
 
 private:
+	static constexpr size_t MaxDamagedAreas = 4096;
+
 	std::vector<uint16_t> uniqueIds;
+	ItemIndex itemIndex;
+	TileStatistics tileStatistics;
+	std::vector<MapDamageArea> damaged_areas;
+	uint64_t damage_base = 0;
 };
 
+template <typename ForeachType>
+inline void foreach_ItemOnTile(Map &map, Tile* tile, ForeachType &foreach, long long done) {
+	if (tile->ground) {
+		foreach (map, tile, tile->ground, done)
+			;
+	}
+
+	std::queue<Container*> containers;
+	for (ItemVector::iterator itemiter = tile->items.begin(); itemiter != tile->items.end(); ++itemiter) {
+		Item* item = *itemiter;
+		Container* container = dynamic_cast<Container*>(item);
+		foreach (map, tile, item, done)
+			;
+		if (container) {
+			containers.push(container);
+
+			do {
+				container = containers.front();
+				ItemVector &v = container->getVector();
+				for (ItemVector::iterator containeriter = v.begin(); containeriter != v.end(); ++containeriter) {
+					Item* i = *containeriter;
+					Container* c = dynamic_cast<Container*>(i);
+					foreach (map, tile, i, done)
+						;
+					if (c) {
+						containers.push(c);
+					}
+				}
+				containers.pop();
+			} while (containers.size());
+		}
+	}
+}
+
 template <typename ForeachType>
 inline void foreach_ItemOnMap(Map &map, ForeachType &foreach, bool selectedTiles) {
 	MapIterator tileiter = map.begin();
@@ -215,37 +295,59 @@ inline void foreach_ItemOnMap(Map &map, ForeachType &foreach, bool selectedTiles
 			continue;
 		}
 
-		if (tile->ground) {
-			foreach (map, tile, tile->ground, done)
-				;
-		}
+		foreach_ItemOnTile(map, tile, foreach, done);
+		++tileiter;
+	}
+}
 
-		std::queue<Container*> containers;
-		for (ItemVector::iterator itemiter = tile->items.begin(); itemiter != tile->items.end(); ++itemiter) {
-			Item* item = *itemiter;
-			Container* container = dynamic_cast<Container*>(item);
+// Calls foreach for the items with the given id only, in the same order as
+// foreach_ItemOnMap; with the item index on, only the leaves holding the id are visited
+template <typename ForeachType>
+inline void foreach_ItemOnMap(Map &map, uint16_t itemId, ForeachType &foreach, bool selectedTiles) {
+	auto matching = [itemId, &foreach](Map &map, Tile* tile, Item* item, long long done) {
+		if (item->getID() == itemId) {
 			foreach (map, tile, item, done)
 				;
-			if (container) {
-				containers.push(container);
-
-				do {
-					container = containers.front();
-					ItemVector &v = container->getVector();
-					for (ItemVector::iterator containeriter = v.begin(); containeriter != v.end(); ++containeriter) {
-						Item* i = *containeriter;
-						Container* c = dynamic_cast<Container*>(i);
-						foreach (map, tile, i, done)
-							;
-						if (c) {
-							containers.push(c);
-						}
-					}
-					containers.pop();
-				} while (containers.size());
+		}
+	};
+
+	const ItemIndex* index = map.getItemIndex();
+	if (!index) {
+		foreach_ItemOnMap(map, matching, selectedTiles);
+		return;
+	}
+
+	const ItemIndex::LeafCounts* leaves = index->find(itemId);
+	if (!leaves) {
+		return;
+	}
+
+	long long done = 0;
+	for (const auto &[key, amount] : *leaves) {
+		const Position corner = BaseMap::getLeafPosition(key);
+		QTreeNode* leaf = map.getLeaf(corner.x, corner.y);
+		if (!leaf) {
+			continue;
+		}
+
+		for (int z = rme::MapMinLayer; z <= rme::MapMaxLayer; ++z) {
+			Floor* floor = leaf->getFloor(z);
+			if (!floor) {
+				continue;
+			}
+
+			for (TileLocation &location : floor->locs) {
+				Tile* tile = location.get();
+				if (!tile) {
+					continue;
+				}
+				++done;
+				if (selectedTiles && !tile->isSelected()) {
+					continue;
+				}
+				foreach_ItemOnTile(map, tile, matching, done);
 			}
 		}
-		++tileiter;
 	}
 }
 
@@ -318,6 +420,11 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 		}
 		++it;
 	}
+
+	// Items were taken off tiles that stay on the map
+	if (removed > 0) {
+		map.invalidateTileIndexes();
+	}
 	return removed;
 }
 
@@ -362,6 +469,11 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 		}
 		++it;
 	}
+
+	// Items were taken off tiles that stay on the map
+	if (removed > 0) {
+		map.invalidateTileIndexes();
+	}
 	return removed;
 }
 
@@ -30,6 +30,8 @@
 #include "palette_window.h"
 #include "map_display.h"
 #include "map_drawer.h"
+#include "render_profiler.h"
+#include "sprite_decode_pool.h"
 #include "application.h"
 #include "live_server.h"
 #include "browse_tile_window.h"
@@ -237,16 +239,23 @@ void MapCanvas::OnPaint(wxPaintEvent &event) {
 			options.show_moveables = g_settings.getBoolean(Config::SHOW_MOVEABLES);
 			options.show_avoidables = g_settings.getBoolean(Config::SHOW_AVOIDABLES);
 			options.hide_items_when_zoomed = g_settings.getBoolean(Config::HIDE_ITEMS_WHEN_ZOOMED);
+			options.minimap_lod_zoom = g_settings.getInteger(Config::MINIMAP_LOD_ZOOM);
 		}
 
 		options.dragging = boundbox_selection;
+		if (!screenshot_buffer) {
+			g_renderProfiler.setEnabled(options.show_performance_stats);
+		}
+		// Begun once the overlay setting is known, so the frame it is turned on in is measured
+		g_renderProfiler.beginFrame();
 
 		const bool animate_position_indicator = drawer->GetPositionIndicatorTime() != 0;
 		const bool animate_preview = options.show_preview && zoom <= 2.0f;
 		if (animate_position_indicator) {
 			animation_timer->StartRefresh(16, true);
 		} else if (animate_preview) {
-			animation_timer->StartRefresh(250, true);
+			// Animated tiles are drawn over the cached scene every frame
+			animation_timer->StartRefresh(250, false);
 		} else if (options.show_performance_stats) {
 			animation_timer->StartRefresh(500, false);
 		} else {
@@ -270,6 +279,8 @@ void MapCanvas::OnPaint(wxPaintEvent &event) {
 	// Swap buffer
 	SwapBuffers();
 
+	g_renderProfiler.endFrame();
+
 	// Send newd node requests
 	editor.SendNodeRequests();
 }
@@ -290,9 +301,12 @@ void MapCanvas::TakeScreenshot(wxFileName path, wxString format) {
 	delete[] screenshot_buffer;
 	screenshot_buffer = newd uint8_t[3 * screensize_x * screensize_y];
 
-	// Draw the window
-	Refresh();
-	wxGLCanvas::Update(); // Forces immediate redraws the window.
+	// Draw the window, with every sprite sheet decoded before it is drawn
+	{
+		SpriteDecodePool::SynchronousScope synchronous(g_spriteDecodePool);
+		Refresh();
+		wxGLCanvas::Update(); // Forces immediate redraws the window.
+	}
 
 	// screenshot_buffer should now contain the screenbuffer
 	if (screenshot_buffer == nullptr) {
@@ -493,6 +507,10 @@ void MapCanvas::OnMouseMove(wxMouseEvent &event) {
 	if (map_update) {
 		UpdatePositionStatus(cursor_x, cursor_y);
 		UpdateZoomStatus();
+		// The paste and doodad previews follow the cursor inside the cached scene
+		if (g_gui.secondary_map) {
+			QueueRefresh(true);
+		}
 	}
 
 	if (g_gui.IsSelectionMode()) {
@@ -596,7 +614,8 @@ void MapCanvas::OnMouseMove(wxMouseEvent &event) {
 			// Create newd doodad layout (does nothing if a non-doodad brush is selected)
 			g_gui.FillDoodadPreviewBuffer();
 
-			g_gui.RefreshView();
+			// A new doodad preview has to reach the scene even when the stroke changed nothing
+			g_gui.RefreshView(g_gui.secondary_map != nullptr);
 		} else if (dragging_draw) {
 			g_gui.RefreshView();
 		} else if (map_update && brush) {
@@ -1037,7 +1056,7 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 	last_click_map_x = mouse_map_x;
 	last_click_map_y = mouse_map_y;
 	last_click_map_z = floor;
-	g_gui.RefreshView();
+	g_gui.RefreshView(!g_gui.IsDrawingMode());
 	g_gui.UpdateMinimap();
 }
 
@@ -1082,9 +1101,6 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent &event) {
 						last_click_map_y = tmp;
 					}
 
-					int numtiles = 0;
-					int threadcount = std::max(g_settings.getInteger(Config::WORKER_THREADS), 1);
-
 					int start_x = 0, start_y = 0, start_z = 0;
 					int end_x = 0, end_y = 0, end_z = 0;
 
@@ -1112,8 +1128,6 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent &event) {
 								end_x -= (floor < rme::MapGroundLayer ? rme::MapGroundLayer - floor : 0);
 								end_y -= (floor < rme::MapGroundLayer ? rme::MapGroundLayer - floor : 0);
 							}
-
-							numtiles = (start_z - end_z) * (end_x - start_x) * (end_y - start_y);
 							break;
 						}
 						case SELECT_VISIBLE_FLOORS: {
@@ -1139,44 +1153,8 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent &event) {
 						}
 					}
 
-					if (numtiles < 500) {
-						// No point in threading for such a small set.
-						threadcount = 1;
-					}
-					// Subdivide the selection area
-					// We know it's a square, just split it into several areas
-					int width = end_x - start_x;
-					if (width < threadcount) {
-						threadcount = std::min(1, width);
-					}
-					// Let's divide!
-					int remainder = width;
-					int cleared = 0;
-					std::vector<SelectionThread*> threads;
-					if (width == 0) {
-						threads.push_back(newd SelectionThread(editor, Position(start_x, start_y, start_z), Position(start_x, end_y, end_z)));
-					} else {
-						for (int i = 0; i < threadcount; ++i) {
-							int chunksize = width / threadcount;
-							// The last threads takes all the remainder
-							if (i == threadcount - 1) {
-								chunksize = remainder;
-							}
-							threads.push_back(newd SelectionThread(editor, Position(start_x + cleared, start_y, start_z), Position(start_x + cleared + chunksize, end_y, end_z)));
-							cleared += chunksize;
-							remainder -= chunksize;
-						}
-					}
-					ASSERT(cleared == width);
-					ASSERT(remainder == 0);
-
 					selection.start(); // Start a selection session
-					for (SelectionThread* thread : threads) {
-						thread->Execute();
-					}
-					for (SelectionThread* thread : threads) {
-						selection.join(thread);
-					}
+					selection.addArea(Position(start_x, start_y, start_z), Position(end_x, end_y, end_z), g_settings.getInteger(Config::COMPENSATED_SELECT));
 					selection.finish(); // Finish the selection session
 					selection.updateSelectionCount();
 				}
@@ -1363,7 +1341,7 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent &event) {
 		replace_dragging = false;
 		editor.replace_brush = nullptr;
 	}
-	g_gui.RefreshView();
+	g_gui.RefreshView(!g_gui.IsDrawingMode());
 	g_gui.UpdateMinimap();
 }
 
@@ -1512,15 +1490,7 @@ void MapCanvas::OnMousePropertiesRelease(wxMouseEvent &event) {
 			selection.start(); // Start a selection session
 			switch (g_settings.getInteger(Config::SELECTION_TYPE)) {
 				case SELECT_CURRENT_FLOOR: {
-					for (int x = last_click_map_x; x <= mouse_map_x; x++) {
-						for (int y = last_click_map_y; y <= mouse_map_y; y++) {
-							Tile* tile = editor.getMap().getTile(x, y, floor);
-							if (!tile) {
-								continue;
-							}
-							selection.add(tile);
-						}
-					}
+					selection.addArea(Position(last_click_map_x, last_click_map_y, floor), Position(mouse_map_x, mouse_map_y, floor), false);
 					break;
 				}
 				case SELECT_ALL_FLOORS: {
@@ -1542,23 +1512,7 @@ void MapCanvas::OnMousePropertiesRelease(wxMouseEvent &event) {
 						end_y -= (floor < rme::MapGroundLayer ? rme::MapGroundLayer - floor : 0);
 					}
 
-					for (int z = start_z; z >= end_z; z--) {
-						for (int x = start_x; x <= end_x; x++) {
-							for (int y = start_y; y <= end_y; y++) {
-								Tile* tile = editor.getMap().getTile(x, y, z);
-								if (!tile) {
-									continue;
-								}
-								selection.add(tile);
-							}
-						}
-						if (z <= rme::MapGroundLayer && g_settings.getInteger(Config::COMPENSATED_SELECT)) {
-							start_x++;
-							start_y++;
-							end_x++;
-							end_y++;
-						}
-					}
+					selection.addArea(Position(start_x, start_y, start_z), Position(end_x, end_y, end_z), g_settings.getInteger(Config::COMPENSATED_SELECT));
 					break;
 				}
 				case SELECT_VISIBLE_FLOORS: {
@@ -1584,23 +1538,7 @@ void MapCanvas::OnMousePropertiesRelease(wxMouseEvent &event) {
 						end_y -= (floor < rme::MapGroundLayer ? rme::MapGroundLayer - floor : 0);
 					}
 
-					for (int z = start_z; z >= end_z; z--) {
-						for (int x = start_x; x <= end_x; x++) {
-							for (int y = start_y; y <= end_y; y++) {
-								Tile* tile = editor.getMap().getTile(x, y, z);
-								if (!tile) {
-									continue;
-								}
-								selection.add(tile);
-							}
-						}
-						if (z <= rme::MapGroundLayer && g_settings.getInteger(Config::COMPENSATED_SELECT)) {
-							start_x++;
-							start_y++;
-							end_x++;
-							end_y++;
-						}
-					}
+					selection.addArea(Position(start_x, start_y, start_z), Position(end_x, end_y, end_z), g_settings.getInteger(Config::COMPENSATED_SELECT));
 					break;
 				}
 			}
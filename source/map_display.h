@@ -131,13 +131,13 @@ public:
 	void ShowPositionIndicator(const Position &position);
 	void TakeScreenshot(wxFileName path, wxString format);
 
+	void QueueRefresh(bool mark_scene_dirty);
+
 protected:
 	void getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, PositionVector* tilestodraw, PositionVector* tilestoborder, bool fill = false);
 	bool floodFill(Map* map, const Position &center, int x, int y, GroundBrush* brush, PositionVector* positions);
 
 private:
-	void QueueRefresh(bool mark_scene_dirty);
-
 	enum {
 		BLOCK_SIZE = 64
 	};
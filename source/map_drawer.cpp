@@ -34,6 +34,10 @@
 #include <format>
 #include <array>
 #include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <ranges>
+#include <tuple>
 
 #include "editor.h"
 #include "gui.h"
@@ -51,6 +55,9 @@
 #include "house_brush.h"
 #include "spawn_monster_brush.h"
 #include "sprite_appearances.h"
+#include "sprite_decode_pool.h"
+#include "sprite_sheet_cache.h"
+#include "residency_manager.h"
 #include "npc_brush.h"
 #include "spawn_npc_brush.h"
 #include "wall_brush.h"
@@ -61,6 +68,7 @@
 #include "zone_brush.h"
 #include "light_drawer.h"
 #include "gl_renderer.h"
+#include "render_profiler.h"
 
 DrawingOptions::DrawingOptions() {
 	SetDefault();
@@ -98,6 +106,7 @@ void DrawingOptions::SetDefault() {
 	show_moveables = false;
 	show_avoidables = false;
 	hide_items_when_zoomed = true;
+	minimap_lod_zoom = 12;
 }
 
 void DrawingOptions::SetIngame() {
@@ -133,6 +142,7 @@ void DrawingOptions::SetIngame() {
 	show_moveables = false;
 	show_avoidables = false;
 	hide_items_when_zoomed = false;
+	minimap_lod_zoom = 0;
 }
 
 bool DrawingOptions::isOnlyColors() const noexcept {
@@ -150,6 +160,13 @@ bool DrawingOptions::isTooltips() const noexcept {
 	return show_tooltips && !isOnlyColors();
 }
 
+bool DrawingOptions::isMinimapLOD(float zoom) const noexcept {
+	if (ingame || show_only_colors) {
+		return false;
+	}
+	return show_as_minimap || (minimap_lod_zoom > 0 && zoom >= static_cast<float>(minimap_lod_zoom));
+}
+
 MapDrawer::MapDrawer(MapCanvas* canvas) :
 	canvas(canvas),
 	editor(canvas->editor)
@@ -202,6 +219,8 @@ void MapDrawer::SetupVars() {
 
 	end_x = start_x + screensize_x / tile_size + 2;
 	end_y = start_y + screensize_y / tile_size + 2;
+
+	animation_layer = options.show_preview && zoom <= 2.0f && !options.show_lights && !g_gui.secondary_map;
 }
 
 void MapDrawer::SetupGL() {
@@ -220,6 +239,7 @@ void MapDrawer::Release() {
 		light_drawer->clear();
 	}
 
+	RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::GLFlush);
 	renderer->flush();
 }
 
@@ -251,57 +271,232 @@ bool MapDrawer::isSceneDirty() const {
 	if (dragging || dragging_draw) {
 		return true;
 	}
-	if (options.show_preview && zoom <= 2.0f) {
+	if (animation_layer != prevAnimationLayer) {
+		return true;
+	}
+	// Without the animation layer, animated tiles and the paste and doodad previews are part of the scene
+	if (options.show_preview && zoom <= 2.0f && !animation_layer) {
 		return true;
 	}
 	return false;
 }
 
-void MapDrawer::Draw() {
-	renderer->ensureFBO(screensize_x, screensize_y);
+bool MapDrawer::getSceneDamage(int &x0, int &y0, int &x1, int &y1) {
+	const Map &map = editor.getMap();
+	std::vector<MapDamageArea> areas;
+	if (!map.getDamagedAreas(damage_generation, areas)) {
+		return false;
+	}
+	damage_generation = map.getDamageGeneration();
 
-	if (isSceneDirty()) {
-		renderer->beginFBO();
+	// Tooltips and lights are collected over the whole view, and the paste and
+	// doodad previews are drawn into the scene, so those need the full redraw.
+	if (!renderer->hasFBO() || g_gui.secondary_map || options.isTooltips() || options.show_lights || animation_layer) {
+		return false;
+	}
+
+	const int width = static_cast<int>(screensize_x * zoom);
+	const int height = static_cast<int>(screensize_y * zoom);
+	x0 = width;
+	y0 = height;
+	x1 = 0;
+	y1 = 0;
+
+	for (const MapDamageArea &area : areas) {
+		if (area.from.z < end_z || area.from.z > start_z) {
+			continue;
+		}
+
+		int from_x, from_y, to_x, to_y;
+		getDrawPosition(area.from, from_x, from_y);
+		getDrawPosition(area.to, to_x, to_y);
+
+		// Large sprites and elevation reach up to two tiles up and left
+		x0 = std::min(x0, from_x - 2 * rme::TileSize);
+		y0 = std::min(y0, from_y - 2 * rme::TileSize);
+		x1 = std::max(x1, to_x + rme::TileSize);
+		y1 = std::max(y1, to_y + rme::TileSize);
+	}
+
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min(x1, width);
+	y1 = std::min(y1, height);
+
+	// Past half of the view the scissored pass costs more than it saves
+	if (x0 < x1 && y0 < y1) {
+		return static_cast<int64_t>(x1 - x0) * (y1 - y0) * 2 < static_cast<int64_t>(width) * height;
+	}
+	return true;
+}
+
+void MapDrawer::DrawScene() {
+	const bool view_moved = view_scroll_x != prevScrollX || view_scroll_y != prevScrollY || zoom != prevZoom || floor != prevFloor || screensize_x != prevScreenW || screensize_y != prevScreenH;
 
+	renderer->beginFBO();
+
+	{
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::FloorIteration);
 		DrawBackground();
 		DrawMap();
-		if (options.show_lights) {
-			light_drawer->draw(start_x, start_y, end_x, end_y, view_scroll_x, view_scroll_y, renderer.get());
-		}
+	}
+	if (options.show_lights) {
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::Lights);
+		light_drawer->draw(start_x, start_y, end_x, end_y, view_scroll_x, view_scroll_y, renderer.get());
+	}
+	{
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::GLFlush);
 		renderer->flush();
+	}
+
+	renderer->endFBO();
+
+	prevScrollX = view_scroll_x;
+	prevScrollY = view_scroll_y;
+	prevZoom = zoom;
+	prevFloor = floor;
+	prevStartZ = start_z;
+	prevScreenW = screensize_x;
+	prevScreenH = screensize_y;
+	prevAnimationLayer = animation_layer;
+	fboDirty = false;
+	damage_generation = editor.getMap().getDamageGeneration();
+
+	if (view_moved && !minimap_lod) {
+		PrefetchSprites();
+	}
+}
+
+void MapDrawer::PrefetchSprites() {
+	// Sheets for a ring of tiles around the view, so scrolling a little
+	// further finds them decoded. The visible tiles request their own.
+	constexpr int PrefetchMargin = 8;
+
+	const Map &map = editor.getMap();
+	const auto prefetchItem = [](const Item* item) {
+		if (const GameSprite* sprite = g_items.getItemType(item->getID()).sprite) {
+			sprite->prefetchSheets();
+		}
+	};
+
+	for (int map_z = start_z; map_z >= end_z; --map_z) {
+		for (int map_y = start_y - PrefetchMargin; map_y <= end_y + PrefetchMargin; ++map_y) {
+			const bool visible_row = map_y >= start_y && map_y <= end_y;
+			for (int map_x = start_x - PrefetchMargin; map_x <= end_x + PrefetchMargin; ++map_x) {
+				if (visible_row && map_x == start_x) {
+					map_x = end_x;
+					continue;
+				}
+
+				const Tile* tile = map.getTile(map_x, map_y, map_z);
+				if (!tile) {
+					continue;
+				}
+				if (tile->ground) {
+					prefetchItem(tile->ground);
+				}
+				for (const Item* item : tile->items) {
+					prefetchItem(item);
+				}
+			}
+		}
+	}
+}
+
+void MapDrawer::DrawSceneRegion(int x0, int y0, int x1, int y1) {
+	const int saved_start_x = start_x;
+	const int saved_start_y = start_y;
+	const int saved_end_x = end_x;
+	const int saved_end_y = end_y;
+
+	const int offset = getFloorOffset(start_z);
+
+	const auto toTile = [](int value) {
+		return value >= 0 ? value / rme::TileSize : (value - rme::TileSize + 1) / rme::TileSize;
+	};
+
+	// Tiles on the lowest floor whose sprites can reach the region; DrawMap
+	// widens the range by one tile per floor on its way up.
+	start_x = toTile(x0 + view_scroll_x + offset) - 1;
+	start_y = toTile(y0 + view_scroll_y + offset) - 1;
+	end_x = toTile(x1 + view_scroll_x + offset) + 3;
+	end_y = toTile(y1 + view_scroll_y + offset) + 3;
+
+	// Scissor is in framebuffer pixels with the origin at the bottom
+	const int scissor_x0 = static_cast<int>(std::floor(x0 / zoom));
+	const int scissor_y0 = static_cast<int>(std::floor(y0 / zoom));
+	const int scissor_x1 = static_cast<int>(std::ceil(x1 / zoom));
+	const int scissor_y1 = static_cast<int>(std::ceil(y1 / zoom));
+
+	renderer->beginFBO();
+	renderer->setScissor(scissor_x0, screensize_y - scissor_y1, scissor_x1 - scissor_x0, scissor_y1 - scissor_y0);
+
+	{
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::FloorIteration);
+		DrawBackground();
+		DrawMap();
+	}
+	{
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::GLFlush);
+		renderer->clearScissor();
+	}
 
-		renderer->endFBO();
+	renderer->endFBO();
 
-		prevScrollX = view_scroll_x;
-		prevScrollY = view_scroll_y;
-		prevZoom = zoom;
-		prevFloor = floor;
-		prevStartZ = start_z;
-		prevScreenW = screensize_x;
-		prevScreenH = screensize_y;
-		fboDirty = false;
+	start_x = saved_start_x;
+	start_y = saved_start_y;
+	end_x = saved_end_x;
+	end_y = saved_end_y;
+}
+
+void MapDrawer::Draw() {
+	renderer->ensureFBO(screensize_x, screensize_y);
+
+	double redrawn = 0.0;
+	if (isSceneDirty()) {
+		DrawScene();
+		redrawn = 1.0;
+	} else if (damage_generation != editor.getMap().getDamageGeneration()) {
+		int x0, y0, x1, y1;
+		if (!getSceneDamage(x0, y0, x1, y1)) {
+			DrawScene();
+			redrawn = 1.0;
+		} else if (x0 < x1 && y0 < y1) {
+			DrawSceneRegion(x0, y0, x1, y1);
+			redrawn = static_cast<double>(x1 - x0) * (y1 - y0) / (static_cast<double>(screensize_x) * screensize_y * zoom * zoom);
+		}
 	}
+	redraw_sum += redrawn;
+	++redraw_frames;
 
 	if (renderer->hasFBO()) {
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::FBOBlit);
 		float w = screensize_x * zoom;
 		float h = screensize_y * zoom;
 		renderer->blitFBO(w, h);
 	}
-
-	DrawDraggingShadow();
-	DrawHigherFloors();
-	if (options.dragging) {
-		DrawSelectionBox();
-	}
-	DrawLiveCursors();
-	DrawBrush();
-	if (options.show_grid && zoom <= 10.f) {
-		DrawGrid();
+	if (animation_layer) {
+		DrawAnimationLayer();
 	}
-	if (options.show_ingame_box) {
-		DrawIngameBox();
+
+	{
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::Overlays);
+		DrawDraggingShadow();
+		DrawHigherFloors();
+		if (options.dragging) {
+			DrawSelectionBox();
+		}
+		DrawLiveCursors();
+		DrawBrush();
+		if (options.show_grid && zoom <= 10.f) {
+			DrawGrid();
+		}
+		if (options.show_ingame_box) {
+			DrawIngameBox();
+		}
 	}
 	if (options.isTooltips() || globalTooltipFade > 0.0f) {
+		RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::Tooltips);
 		DrawTooltips();
 	}
 	if (options.show_performance_stats) {
@@ -335,6 +530,7 @@ void MapDrawer::DrawShade(int map_z) {
 
 void MapDrawer::DrawMap() {
 	tooltips.clear();
+	animated_tiles.clear();
 	bool live_client = editor.IsLiveClient();
 
 	Brush* brush = g_gui.GetCurrentBrush();
@@ -351,13 +547,18 @@ void MapDrawer::DrawMap() {
 
 	bool only_colors = options.isOnlyColors();
 	bool tile_indicators = options.isTileIndicators();
+	minimap_lod = options.isMinimapLOD(zoom);
 
 	for (int map_z = start_z; map_z >= superend_z; map_z--) {
 		if (options.show_shade) {
 			DrawShade(map_z);
 		}
 
-		if (map_z >= end_z) {
+		if (map_z >= end_z && minimap_lod) {
+			DrawMinimapLOD(map_z);
+			DrawPositionIndicator(map_z);
+		} else if (map_z >= end_z) {
+			const bool collect_animated = animation_layer && map_z == end_z;
 
 			int nd_start_x = start_x & ~3;
 			int nd_start_y = start_y & ~3;
@@ -376,9 +577,15 @@ void MapDrawer::DrawMap() {
 					}
 
 					if (!live_client || nd->isVisible(map_z > rme::MapGroundLayer)) {
+						uint16_t animated_mask = 0;
 						for (int map_x = 0; map_x < 4; ++map_x) {
 							for (int map_y = 0; map_y < 4; ++map_y) {
 								TileLocation* location = nd->getTile(map_x, map_y, map_z);
+								if (collect_animated && isAnimationLayerTile(location)) {
+									animated_tiles.push_back(location);
+									animated_mask |= 1 << (map_x * 4 + map_y);
+									continue;
+								}
 								DrawTile(location);
 								// draw light, but only if not zoomed too far
 								if (location && options.show_lights && zoom <= 10) {
@@ -389,7 +596,9 @@ void MapDrawer::DrawMap() {
 						if (tile_indicators) {
 							for (int map_x = 0; map_x < 4; ++map_x) {
 								for (int map_y = 0; map_y < 4; ++map_y) {
-									DrawTileIndicators(nd->getTile(map_x, map_y, map_z));
+									if (!(animated_mask & (1 << (map_x * 4 + map_y)))) {
+										DrawTileIndicators(nd->getTile(map_x, map_y, map_z));
+									}
 								}
 							}
 						}
@@ -418,6 +627,125 @@ void MapDrawer::DrawMap() {
 		++end_x;
 		++end_y;
 	}
+
+	static_tooltip_count = tooltips.size();
+}
+
+bool MapDrawer::isAnimationLayerTile(const TileLocation* location) const {
+	const Tile* tile = location ? location->get() : nullptr;
+	if (!tile) {
+		return false;
+	}
+
+	const auto isAnimated = [](const Tile* tile) {
+		if (tile->ground && tile->ground->hasAnimation()) {
+			return true;
+		}
+		return std::ranges::any_of(tile->items, [](const Item* item) { return item->hasAnimation(); });
+	};
+	if (isAnimated(tile)) {
+		return true;
+	}
+	if (tile->items.empty()) {
+		return false;
+	}
+
+	// Items may reach up to two tiles up and left, over an animated tile
+	const Position &position = location->getPosition();
+	for (int dx = 0; dx <= 2; ++dx) {
+		for (int dy = 0; dy <= 2; ++dy) {
+			if (dx == 0 && dy == 0) {
+				continue;
+			}
+			const Tile* neighbour = editor.getMap().getTile(position.x - dx, position.y - dy, position.z);
+			if (neighbour && isAnimated(neighbour)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void MapDrawer::DrawAnimationLayer() {
+	// Tooltips of the layer tiles are written again below
+	tooltips.resize(static_tooltip_count);
+
+	const bool tile_indicators = options.isTileIndicators();
+	for (TileLocation* location : animated_tiles) {
+		DrawTile(location);
+	}
+	if (tile_indicators) {
+		for (TileLocation* location : animated_tiles) {
+			DrawTileIndicators(location);
+		}
+	}
+}
+
+void MapDrawer::DrawMinimapLOD(int map_z) {
+	// Far zoom: one quad per run of equally coloured tiles, using the same
+	// palette as IOMinimap, instead of blitting every sprite on every tile.
+	bool live_client = editor.IsLiveClient();
+	bool underground = map_z > rme::MapGroundLayer;
+
+	const int offset = getFloorOffset(map_z);
+
+	int nd_start_x = start_x & ~3;
+	int nd_start_y = start_y & ~3;
+	int nd_end_x = (end_x & ~3) + 4;
+	int nd_end_y = (end_y & ~3) + 4;
+
+	std::vector<QTreeNode*> row;
+	row.reserve((nd_end_x - nd_start_x) / 4 + 1);
+
+	for (int nd_map_y = nd_start_y; nd_map_y <= nd_end_y; nd_map_y += 4) {
+		row.clear();
+		for (int nd_map_x = nd_start_x; nd_map_x <= nd_end_x; nd_map_x += 4) {
+			QTreeNode* nd = editor.getMap().getLeaf(nd_map_x, nd_map_y);
+			if (nd && live_client && !nd->isVisible(underground)) {
+				if (!nd->isRequested(underground)) {
+					editor.QueryNode(nd_map_x, nd_map_y, underground);
+					nd->setRequested(underground, true);
+				}
+				nd = nullptr;
+			}
+			row.push_back(nd);
+		}
+
+		for (int map_y = 0; map_y < 4; ++map_y) {
+			int cy = (nd_map_y + map_y) * rme::TileSize - view_scroll_y - offset;
+			int run_color = -1;
+			int run_start = nd_start_x;
+			int x = nd_start_x;
+
+			auto flushRun = [&]() {
+				if (run_color >= 0) {
+					wxColor color = colorFromEightBit(run_color);
+					int cx = run_start * rme::TileSize - view_scroll_x - offset;
+					renderer->drawColoredQuad(cx, cy, (x - run_start) * rme::TileSize, rme::TileSize, { color.Red(), color.Green(), color.Blue(), 255 });
+				}
+			};
+
+			for (QTreeNode* nd : row) {
+				for (int map_x = 0; map_x < 4; ++map_x, ++x) {
+					int color = -1;
+					if (nd) {
+						TileLocation* location = nd->getTile(map_x, map_y, map_z);
+						Tile* tile = location ? location->get() : nullptr;
+						if (tile && (tile->ground || !tile->items.empty()) && (!options.show_only_modified || tile->isModified())) {
+							color = tile->getMiniMapColor();
+						}
+					}
+
+					if (color != run_color) {
+						flushRun();
+						run_color = color;
+						run_start = x;
+					}
+				}
+			}
+			flushRun();
+		}
+	}
 }
 
 void MapDrawer::DrawSecondaryMap(int map_z) {
@@ -427,6 +755,7 @@ void MapDrawer::DrawSecondaryMap(int map_z) {
 
 	BaseMap* secondary_map = g_gui.secondary_map;
 	if (!secondary_map) {
+		paste_preview.clear();
 		return;
 	}
 
@@ -435,11 +764,37 @@ void MapDrawer::DrawSecondaryMap(int map_z) {
 
 	if (canvas->isPasting()) {
 		normal_pos = editor.copybuffer.getPosition();
-	} else {
-		Brush* brush = g_gui.GetCurrentBrush();
-		if (brush && brush->isDoodad()) {
-			normal_pos = Position(0x8000, 0x8000, 0x8);
+
+		// The paste buffer stays the same while it follows the cursor; a new
+		// buffer may reuse the address of the old one, so its generation is checked too
+		const uint64_t generation = g_gui.copybuffer.getGeneration();
+		if (!paste_preview.matches(secondary_map, secondary_map->size(), normal_pos, zoom, generation)) {
+			std::vector<const Tile*> tiles;
+			tiles.reserve(secondary_map->size());
+			for (MapIterator it = secondary_map->begin(); it != secondary_map->end(); ++it) {
+				if (const Tile* tile = (*it)->get()) {
+					tiles.push_back(tile);
+				}
+			}
+			RecordShadowCache(paste_preview, tiles, [this](const Tile* tile, int draw_x, int draw_y) {
+				DrawPreviewTile(tile, draw_x, draw_y);
+			});
+			paste_preview.source = secondary_map;
+			paste_preview.source_size = secondary_map->size();
+			paste_preview.source_generation = generation;
+			paste_preview.source_position = normal_pos;
 		}
+
+		const Position move = normal_pos - to_pos;
+		ReplayShadowCache(paste_preview, move.x, move.y, move.z, map_z);
+		return;
+	}
+
+	paste_preview.clear();
+
+	Brush* brush = g_gui.GetCurrentBrush();
+	if (brush && brush->isDoodad()) {
+		normal_pos = Position(0x8000, 0x8000, 0x8);
 	}
 
 	for (int map_x = start_x; map_x <= end_x; map_x++) {
@@ -457,67 +812,132 @@ void MapDrawer::DrawSecondaryMap(int map_z) {
 
 			int draw_x, draw_y;
 			getDrawPosition(final_pos, draw_x, draw_y);
+			DrawPreviewTile(tile, draw_x, draw_y);
+		}
+	}
+}
 
-			// Draw ground
-			uint8_t r = 160, g = 160, b = 160;
-			if (tile->ground) {
-				if (options.show_blocking && tile->isBlocking()) {
-					g = g / 3 * 2;
-					b = b / 3 * 2;
-				}
-				if (options.show_houses && tile->isHouseTile()) {
-					if (tile->getHouseID() == current_house_id) {
-						r /= 2;
-					} else {
-						r /= 2;
-						g /= 2;
-					}
-				} else if (options.show_special_tiles && tile->isPZ()) {
-					r /= 2;
-					b /= 2;
-				}
-				if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_PVPZONE) {
-					r = r / 3 * 2;
-					b = r / 3 * 2;
-				}
-				if (options.show_special_tiles && tile->hasZone(g_gui.zone_brush->getZone())) {
-					r = r / 3 * 2;
-					b = b / 3 * 2;
-				}
-				if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOLOGOUT) {
-					b /= 2;
-				}
-				if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOPVP) {
-					g /= 2;
-				}
-				BlitItem(draw_x, draw_y, tile, tile->ground, true, r, g, b, 160);
+void MapDrawer::DrawPreviewTile(const Tile* tile, int draw_x, int draw_y) {
+	// Draw ground
+	uint8_t r = 160, g = 160, b = 160;
+	if (tile->ground) {
+		if (options.show_blocking && tile->isBlocking()) {
+			g = g / 3 * 2;
+			b = b / 3 * 2;
+		}
+		if (options.show_houses && tile->isHouseTile()) {
+			if (tile->getHouseID() == current_house_id) {
+				r /= 2;
+			} else {
+				r /= 2;
+				g /= 2;
 			}
+		} else if (options.show_special_tiles && tile->isPZ()) {
+			r /= 2;
+			b /= 2;
+		}
+		if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_PVPZONE) {
+			r = r / 3 * 2;
+			b = r / 3 * 2;
+		}
+		if (options.show_special_tiles && tile->hasZone(g_gui.zone_brush->getZone())) {
+			r = r / 3 * 2;
+			b = b / 3 * 2;
+		}
+		if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOLOGOUT) {
+			b /= 2;
+		}
+		if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOPVP) {
+			g /= 2;
+		}
+		BlitItem(draw_x, draw_y, tile, tile->ground, true, r, g, b, 160);
+	}
 
-			bool hidden = options.hide_items_when_zoomed && zoom > 10.f;
+	bool hidden = options.hide_items_when_zoomed && zoom > 10.f;
 
-			// Draw items
-			if (!hidden && !tile->items.empty()) {
-				for (const Item* item : tile->items) {
-					if (item->isBorder()) {
-						BlitItem(draw_x, draw_y, tile, item, true, 160, r, g, b);
-					} else {
-						BlitItem(draw_x, draw_y, tile, item, true, 160, 160, 160, 160);
-					}
-				}
+	// Draw items
+	if (!hidden && !tile->items.empty()) {
+		for (const Item* item : tile->items) {
+			if (item->isBorder()) {
+				BlitItem(draw_x, draw_y, tile, item, true, 160, r, g, b);
+			} else {
+				BlitItem(draw_x, draw_y, tile, item, true, 160, 160, 160, 160);
 			}
+		}
+	}
 
-			// Monsters
-			if (!hidden && options.show_monsters && !tile->monsters.empty()) {
-				for (auto monster : tile->monsters) {
-					BlitCreature(draw_x, draw_y, monster);
-				}
-			}
+	// Monsters
+	if (!hidden && options.show_monsters && !tile->monsters.empty()) {
+		for (auto monster : tile->monsters) {
+			BlitCreature(draw_x, draw_y, monster);
+		}
+	}
 
-			// NPCS
-			if (!hidden && options.show_npcs && tile->npc) {
-				BlitCreature(draw_x, draw_y, tile->npc);
+	// NPCS
+	if (!hidden && options.show_npcs && tile->npc) {
+		BlitCreature(draw_x, draw_y, tile->npc);
+	}
+}
+
+template <typename TileRange, typename DrawFunction>
+void MapDrawer::RecordShadowCache(ShadowCache &cache, TileRange &&tiles, DrawFunction &&draw) {
+	cache.chunks.clear();
+	cache.zoom = zoom;
+	cache.texture_generation = GLRenderer::getTextureGeneration();
+
+	const auto chunkOf = [](int value) {
+		return value & ~(ShadowCache::ChunkSize - 1);
+	};
+
+	// Sorted by floor and chunk so every chunk is recorded in one go
+	using TilePointer = std::ranges::range_value_t<TileRange>;
+	std::vector<TilePointer> sorted(std::ranges::begin(tiles), std::ranges::end(tiles));
+	std::ranges::sort(sorted, [&chunkOf](const auto* lhs, const auto* rhs) {
+		const Position &a = lhs->getPosition();
+		const Position &b = rhs->getPosition();
+		return std::tuple(a.z, chunkOf(a.y), chunkOf(a.x), a.y, a.x) < std::tuple(b.z, chunkOf(b.y), chunkOf(b.x), b.y, b.x);
+	});
+
+	size_t first = 0;
+	while (first < sorted.size()) {
+		const Position &origin = sorted[first]->getPosition();
+		ShadowCache::Chunk chunk { chunkOf(origin.x), chunkOf(origin.y), origin.z, {} };
+
+		renderer->beginRecording();
+		size_t last = first;
+		for (; last < sorted.size(); ++last) {
+			const Position &position = sorted[last]->getPosition();
+			if (position.z != chunk.z || chunkOf(position.x) != chunk.x || chunkOf(position.y) != chunk.y) {
+				break;
 			}
+			draw(sorted[last], position.x * rme::TileSize, position.y * rme::TileSize);
+		}
+		chunk.commands = renderer->endRecording();
+
+		if (!chunk.commands.empty()) {
+			cache.chunks.push_back(std::move(chunk));
 		}
+		first = last;
+	}
+}
+
+void MapDrawer::ReplayShadowCache(const ShadowCache &cache, int move_x, int move_y, int move_z, int map_z) {
+	for (const ShadowCache::Chunk &chunk : cache.chunks) {
+		const int dest_z = chunk.z - move_z;
+		if (dest_z < 0 || dest_z >= rme::MapLayers || (map_z >= 0 && dest_z != map_z)) {
+			continue;
+		}
+
+		const int dest_x = chunk.x - move_x;
+		const int dest_y = chunk.y - move_y;
+		if (dest_x + ShadowCache::ChunkSize + 2 <= start_x || dest_x > end_x || dest_y + ShadowCache::ChunkSize + 2 <= start_y || dest_y > end_y) {
+			continue;
+		}
+
+		const int offset = getFloorOffset(dest_z);
+		const float dx = static_cast<float>(-move_x * rme::TileSize - view_scroll_x - offset);
+		const float dy = static_cast<float>(-move_y * rme::TileSize - view_scroll_y - offset);
+		renderer->replay(chunk.commands, dx, dy);
 	}
 }
 
@@ -619,66 +1039,102 @@ void MapDrawer::DrawGrid() {
 
 void MapDrawer::DrawDraggingShadow() {
 	if (!dragging || options.ingame || editor.getSelection().isBusy()) {
+		dragging_shadow.clear();
 		return;
 	}
 
-	for (Tile* tile : editor.getSelection()) {
-		int move_z = canvas->drag_start_z - floor;
-		int move_x = canvas->drag_start_x - mouse_map_x;
-		int move_y = canvas->drag_start_y - mouse_map_y;
+	int move_z = canvas->drag_start_z - floor;
+	int move_x = canvas->drag_start_x - mouse_map_x;
+	int move_y = canvas->drag_start_y - mouse_map_y;
 
-		if (move_x == 0 && move_y == 0 && move_z == 0) {
-			continue;
-		}
+	if (move_x == 0 && move_y == 0 && move_z == 0) {
+		return;
+	}
 
-		const Position &position = tile->getPosition();
-		int pos_z = position.z - move_z;
-		if (pos_z < 0 || pos_z >= rme::MapLayers) {
-			continue;
+	// The selection cannot change while it is dragged, so it is recorded once
+	// for every phase of the move its sprite patterns can tell apart
+	const Position move(move_x, move_y, move_z);
+	const auto phaseOf = [&move](const ShadowCache &cache) {
+		// Hooks come from the tiles under the drop position, so every move differs
+		if (cache.per_move) {
+			return move;
 		}
+		const Position &period = cache.pattern_period;
+		return Position((move.x % period.x + period.x) % period.x, (move.y % period.y + period.y) % period.y, (move.z % period.z + period.z) % period.z);
+	};
 
-		int pos_x = position.x - move_x;
-		int pos_y = position.y - move_y;
-
-		// On screen and dragging?
-		if (pos_x + 2 > start_x && pos_x < end_x && pos_y + 2 > start_y && pos_y < end_y) {
-			Position pos(pos_x, pos_y, pos_z);
-			int draw_x, draw_y;
-			getDrawPosition(pos, draw_x, draw_y);
-
-			ItemVector items = tile->getSelectedItems();
-			Tile* dest_tile = editor.getMap().getTile(pos);
-
-			for (Item* item : items) {
-				if (dest_tile) {
-					BlitItem(draw_x, draw_y, dest_tile, item, true, 160, 160, 160, 160);
-				} else {
-					BlitItem(draw_x, draw_y, pos, item, true, 160, 160, 160, 160);
+	Selection &selection = editor.getSelection();
+	if (!dragging_shadow.matches(&selection, selection.size(), phaseOf(dragging_shadow), zoom)) {
+		if (dragging_shadow.source != &selection || dragging_shadow.source_size != selection.size()) {
+			Position &period = dragging_shadow.pattern_period;
+			period = Position(1, 1, 1);
+			dragging_shadow.per_move = false;
+			for (const Tile* tile : selection) {
+				for (const Item* item : tile->getSelectedItems()) {
+					const ItemType &type = g_items.getItemType(item->getID());
+					dragging_shadow.per_move = dragging_shadow.per_move || type.isHangable;
+					if (const GameSprite* sprite = type.sprite) {
+						period.x = std::lcm(period.x, std::max<int>(sprite->pattern_x, 1));
+						period.y = std::lcm(period.y, std::max<int>(sprite->pattern_y, 1));
+						period.z = std::lcm(period.z, std::max<int>(sprite->pattern_z, 1));
+					}
 				}
 			}
+		}
 
-			if (options.show_monsters && !tile->monsters.empty()) {
-				for (auto monster : tile->monsters) {
-					if (!monster->isSelected()) {
-						continue;
-					}
+		RecordShadowCache(dragging_shadow, selection.getTiles(), [this, &move](Tile* tile, int draw_x, int draw_y) {
+			DrawShadowTile(tile, draw_x, draw_y, move);
+		});
+		dragging_shadow.source = &selection;
+		dragging_shadow.source_size = selection.size();
+		dragging_shadow.source_position = phaseOf(dragging_shadow);
+	}
 
-					BlitCreature(draw_x, draw_y, monster);
-				}
-			}
+	ReplayShadowCache(dragging_shadow, move_x, move_y, move_z);
+}
 
-			if (tile->spawnMonster && tile->spawnMonster->isSelected()) {
-				DrawIndicator(draw_x, draw_y, EDITOR_SPRITE_MONSTERS, 160, 160, 160, 160);
-			}
+void MapDrawer::DrawShadowTile(Tile* tile, int draw_x, int draw_y, const Position &move) {
+	// Patterns and hooks follow the drop position, not the dragged tile. A drop
+	// position off the map has no tile and is drawn with the patterns it would
+	// have, taken from a position of the same pattern phase on the map.
+	Position position = tile->getPosition() - move;
+	Tile* dest_tile = nullptr;
+	if (position.x < 0 || position.y < 0 || position.z < 0 || position.z >= rme::MapLayers) {
+		const Position &period = dragging_shadow.pattern_period;
+		position = Position((position.x % period.x + period.x) % period.x, (position.y % period.y + period.y) % period.y, (position.z % period.z + period.z) % period.z);
+	} else {
+		dest_tile = editor.getMap().getTile(position);
+	}
 
-			if (options.show_npcs && tile->npc && tile->npc->isSelected()) {
-				BlitCreature(draw_x, draw_y, tile->npc);
-			}
-			if (tile->spawnNpc && tile->spawnNpc->isSelected()) {
-				DrawIndicator(draw_x, draw_y, EDITOR_SPRITE_NPCS, 160, 160, 160, 160);
+	ItemVector items = tile->getSelectedItems();
+	for (Item* item : items) {
+		if (dest_tile) {
+			BlitItem(draw_x, draw_y, dest_tile, item, true, 160, 160, 160, 160);
+		} else {
+			BlitItem(draw_x, draw_y, position, item, true, 160, 160, 160, 160);
+		}
+	}
+
+	if (options.show_monsters && !tile->monsters.empty()) {
+		for (auto monster : tile->monsters) {
+			if (!monster->isSelected()) {
+				continue;
 			}
+
+			BlitCreature(draw_x, draw_y, monster);
 		}
 	}
+
+	if (tile->spawnMonster && tile->spawnMonster->isSelected()) {
+		DrawIndicator(draw_x, draw_y, EDITOR_SPRITE_MONSTERS, 160, 160, 160, 160);
+	}
+
+	if (options.show_npcs && tile->npc && tile->npc->isSelected()) {
+		BlitCreature(draw_x, draw_y, tile->npc);
+	}
+	if (tile->spawnNpc && tile->spawnNpc->isSelected()) {
+		DrawIndicator(draw_x, draw_y, EDITOR_SPRITE_NPCS, 160, 160, 160, 160);
+	}
 }
 
 void MapDrawer::DrawHigherFloors() {
@@ -1447,6 +1903,8 @@ void MapDrawer::DrawTile(TileLocation* location) {
 		return;
 	}
 
+	RenderProfiler::ScopedTimer timer(g_renderProfiler, RenderPhase::Tiles);
+
 	if (options.show_only_modified && !tile->isModified()) {
 		return;
 	}
@@ -1574,14 +2032,17 @@ void MapDrawer::DrawTile(TileLocation* location) {
 		}
 	}
 
-	if (!hidden && options.show_monsters && !tile->monsters.empty()) {
-		for (auto monster : tile->monsters) {
-			BlitCreature(draw_x, draw_y, monster);
+	if (!hidden && ((options.show_monsters && !tile->monsters.empty()) || (options.show_npcs && tile->npc))) {
+		RenderProfiler::ScopedTimer creatureTimer(g_renderProfiler, RenderPhase::Creatures);
+		if (options.show_monsters) {
+			for (auto monster : tile->monsters) {
+				BlitCreature(draw_x, draw_y, monster);
+			}
 		}
-	}
 
-	if (!hidden && options.show_npcs && tile->npc) {
-		BlitCreature(draw_x, draw_y, tile->npc);
+		if (options.show_npcs && tile->npc) {
+			BlitCreature(draw_x, draw_y, tile->npc);
+		}
 	}
 
 	if (show_tooltips && position.z == floor) {
@@ -2107,7 +2568,11 @@ void MapDrawer::UpdateCPUUsage() {
 }
 
 std::string MapDrawer::FormatPerformanceStats() const {
-	return std::format("FPS: {:.1f} | CPU: {:.1f}% | RAM: {} MB", current_fps, current_cpu, current_ram);
+	std::string text = std::format("FPS: {:.1f} | CPU: {:.1f}% | RAM: {} MB | Redraw: {:.1f}%", current_fps, current_cpu, current_ram, current_redraw);
+	if (minimap_lod) {
+		text += " | Minimap LOD";
+	}
+	return text;
 }
 
 void MapDrawer::DrawPerformanceStats() {
@@ -2118,6 +2583,13 @@ void MapDrawer::DrawPerformanceStats() {
 		frame_count = 0;
 		UpdateRAMUsage();
 		UpdateCPUUsage();
+		for (size_t i = 0; i < phase_stats.size(); ++i) {
+			phase_stats[i] = g_renderProfiler.getStats(static_cast<RenderPhase>(i));
+		}
+		// Share of the scene pixels repainted per frame, averaged over the period
+		current_redraw = redraw_frames > 0 ? redraw_sum * 100.0 / redraw_frames : 0.0;
+		redraw_sum = 0.0;
+		redraw_frames = 0;
 		perf_update_timer.Start();
 	}
 
@@ -2128,6 +2600,35 @@ void MapDrawer::DrawPerformanceStats() {
 
 	renderer->drawText(10.0f, 20.0f, stats_text, 255, 255, 0, 255);
 
+	// Rolling per-phase percentiles (ms) over the last frames
+	float line_y = 20.0f + renderer->getLineHeight();
+	for (size_t i = 0; i < phase_stats.size(); ++i) {
+		const RenderPhaseStats &stats = phase_stats[i];
+		const auto phase = static_cast<RenderPhase>(i);
+		// Nested phases are a sub-row of the phase that already counts their time
+		const RenderPhase parent = RenderProfiler::getParentPhase(phase);
+		const std::string name = parent == RenderPhase::Count ? RenderProfiler::getPhaseName(phase) : std::format("  {} (in {})", RenderProfiler::getPhaseName(phase), RenderProfiler::getPhaseName(parent));
+		std::string line = std::format("{}: p50 {:.2f} | p95 {:.2f} | p99 {:.2f} ms", name, stats.p50, stats.p95, stats.p99);
+		renderer->drawText(10.0f, line_y, line, 255, 255, 0, 200);
+		line_y += renderer->getLineHeight();
+	}
+
+	const SpriteDecodeStats decode_stats = g_spriteDecodePool.getStats();
+	std::string decode_line = std::format("Sheet decode: queue {} | in flight {} | latency avg {:.1f} max {:.1f} ms | decode avg {:.1f} ms | {} decoded", decode_stats.queue_depth, decode_stats.in_flight, decode_stats.average_latency_ms, decode_stats.max_latency_ms, decode_stats.average_decode_ms, decode_stats.decoded);
+	if (g_spriteSheetCache.isEnabled()) {
+		const SpriteSheetCacheStats cache_stats = g_spriteSheetCache.getStats();
+		decode_line += std::format(" | disk cache {} hits, {} misses", cache_stats.hits, cache_stats.misses);
+	}
+	renderer->drawText(10.0f, line_y, decode_line, 255, 255, 0, 200);
+	line_y += renderer->getLineHeight();
+
+	const ResidencyStats &residency = g_residency.getStats();
+	const uint64_t lookups = residency.hits + residency.misses;
+	const double hit_rate = lookups > 0 ? 100.0 * static_cast<double>(residency.hits) / static_cast<double>(lookups) : 0.0;
+	constexpr size_t MB = 1024 * 1024;
+	std::string residency_line = std::format("Residency: {}/{} MB (sheets {} MB, sheet textures {} MB, sprite textures {} MB) | {} entries | hits {:.1f}% | misses {} | evictions {}", residency.resident_bytes / MB, residency.budget_bytes / MB, residency.kind_bytes[std::to_underlying(ResidencyKind::SheetData)] / MB, residency.kind_bytes[std::to_underlying(ResidencyKind::SheetTexture)] / MB, residency.kind_bytes[std::to_underlying(ResidencyKind::SpriteTexture)] / MB, residency.entries, hit_rate, residency.misses, residency.evictions);
+	renderer->drawText(10.0f, line_y, residency_line, 255, 255, 0, 200);
+
 	renderer->flush();
 
 	std::array<int, 4> vPort {};
@@ -2210,13 +2711,13 @@ void MapDrawer::glBlitTexture(int sx, int sy, int textureId, const GLColor &colo
 	auto height = rme::TileSize;
 	// Adjusts the offset of normal sprites
 	if (!opts.isEditorSprite) {
-		SpriteSheetPtr sheet = g_spriteAppearances.getSheetBySpriteId(opts.spriteId > 0 ? opts.spriteId : textureId);
-		if (!sheet) {
+		const SpriteLocation* location = g_spriteAppearances.getSpriteLocation(opts.spriteId > 0 ? opts.spriteId : textureId);
+		if (!location) {
 			return;
 		}
 
-		width = sheet->getSpriteSize().width;
-		height = sheet->getSpriteSize().height;
+		width = location->width;
+		height = location->height;
 
 		// If the sprite is an outfit and the size is 64x64, adjust the offset
 		if (width == 64 && height == 64 && (opts.outfit.lookType > 0 || opts.outfit.lookItem > 0)) {
@@ -2319,13 +2820,15 @@ void MapDrawer::drawFilledRect(int x, int y, int w, int h, const wxColor &color)
 	renderer->drawColoredQuad(static_cast<float>(x), static_cast<float>(y), static_cast<float>(w), static_cast<float>(h), { color.Red(), color.Green(), color.Blue(), color.Alpha() });
 }
 
-void MapDrawer::getDrawPosition(const Position &position, int &x, int &y) {
-	int offset;
-	if (position.z <= rme::MapGroundLayer) {
-		offset = (rme::MapGroundLayer - position.z) * rme::TileSize;
-	} else {
-		offset = rme::TileSize * (floor - position.z);
+int MapDrawer::getFloorOffset(int map_z) const noexcept {
+	if (map_z <= rme::MapGroundLayer) {
+		return (rme::MapGroundLayer - map_z) * rme::TileSize;
 	}
+	return rme::TileSize * (floor - map_z);
+}
+
+void MapDrawer::getDrawPosition(const Position &position, int &x, int &y) {
+	const int offset = getFloorOffset(position.z);
 
 	x = ((position.x * rme::TileSize) - view_scroll_x) - offset;
 	y = ((position.y * rme::TileSize) - view_scroll_y) - offset;
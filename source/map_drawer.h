@@ -23,6 +23,7 @@
 #include <utility>
 #include "light_drawer.h"
 #include "gl_renderer.h"
+#include "render_profiler.h"
 
 class GameSprite;
 
@@ -66,6 +67,7 @@ public:
 	bool isOnlyColors() const noexcept;
 	bool isTileIndicators() const noexcept;
 	bool isTooltips() const noexcept;
+	bool isMinimapLOD(float zoom) const noexcept;
 
 	bool transparent_floors;
 	bool transparent_items;
@@ -99,10 +101,45 @@ public:
 	bool show_moveables;
 	bool show_avoidables;
 	bool hide_items_when_zoomed;
+	int minimap_lod_zoom;
 };
 
 class MapCanvas;
 
+// Draw commands of a dragged selection or of the paste buffer, recorded once
+// per chunk of tiles in unscrolled map pixels and replayed at the current
+// offset every frame.
+struct ShadowCache {
+	static constexpr int ChunkSize = 16;
+
+	struct Chunk {
+		int x; // top-left tile of the chunk
+		int y;
+		int z;
+		GLRenderer::Recording commands;
+	};
+
+	const void* source = nullptr;
+	size_t source_size = 0;
+	uint64_t source_generation = 0; // for sources whose address can be reused
+	Position source_position;
+	// Sprite patterns drawn from the drop position repeat every pattern_period
+	// tiles of the move, unless per_move says every move draws differently
+	Position pattern_period { 1, 1, 1 };
+	bool per_move = false;
+	float zoom = 0.f;
+	uint64_t texture_generation = 0;
+	std::vector<Chunk> chunks;
+
+	bool matches(const void* source, size_t source_size, const Position &source_position, float zoom, uint64_t source_generation = 0) const noexcept {
+		return this->source == source && this->source_size == source_size && this->source_generation == source_generation && this->source_position == source_position && this->zoom == zoom && texture_generation == GLRenderer::getTextureGeneration();
+	}
+	void clear() {
+		source = nullptr;
+		chunks.clear();
+	}
+};
+
 struct BlitOptions {
 	bool adjustZoom = false;
 	bool isEditorSprite = false;
@@ -119,6 +156,12 @@ class MapDrawer {
 	std::unique_ptr<GLRenderer> renderer = std::make_unique<GLRenderer>();
 
 	bool isSceneDirty() const;
+	bool getSceneDamage(int &x0, int &y0, int &x1, int &y1);
+	void DrawScene();
+	void DrawSceneRegion(int x0, int y0, int x1, int y1);
+	bool isAnimationLayerTile(const TileLocation* location) const;
+	void PrefetchSprites();
+	void DrawAnimationLayer();
 
 	// Scene cache tracking
 	int prevScrollX = -1;
@@ -128,10 +171,22 @@ class MapDrawer {
 	int prevStartZ = -1;
 	int prevScreenW = -1;
 	int prevScreenH = -1;
+	bool prevAnimationLayer = false;
 	bool fboDirty = true;
+	uint64_t damage_generation = 0; // map damage already drawn into the scene
 
 	float zoom;
 	float globalTooltipFade = 0.0f;
+	bool minimap_lod = false;
+
+	// Animated tiles of the current floor, and the tiles drawn over them, are
+	// left out of the cached scene and drawn on top of it every frame.
+	bool animation_layer = false;
+	std::vector<TileLocation*> animated_tiles;
+	size_t static_tooltip_count = 0;
+
+	ShadowCache dragging_shadow;
+	ShadowCache paste_preview;
 
 	uint32_t current_house_id;
 
@@ -157,6 +212,10 @@ protected:
 	wxStopWatch perf_update_timer;
 	double current_cpu = 0.0;
 	size_t current_ram = 0;
+	std::array<RenderPhaseStats, std::to_underlying(RenderPhase::Count)> phase_stats {};
+	double redraw_sum = 0.0; // fraction of the scene redrawn, summed over redraw_frames
+	int redraw_frames = 0;
+	double current_redraw = 0.0;
 
 #ifdef __WINDOWS__
 	ULARGE_INTEGER last_cpu_time;
@@ -185,6 +244,7 @@ public:
 	void DrawBackground();
 	void DrawShade(int mapz);
 	void DrawMap();
+	void DrawMinimapLOD(int map_z);
 	void DrawSecondaryMap(int mapz);
 	void DrawDraggingShadow();
 	void DrawHigherFloors();
@@ -228,6 +288,11 @@ protected:
 	void BlitCreature(int screenx, int screeny, const Npc* c, int red = 255, int green = 255, int blue = 255, int alpha = 255);
 	void BlitCreature(int screenx, int screeny, const Outfit &outfit, const Direction &dir, int red = 255, int green = 255, int blue = 255, int alpha = 255);
 	void DrawTile(TileLocation* tile);
+	void DrawShadowTile(Tile* tile, int draw_x, int draw_y, const Position &move);
+	void DrawPreviewTile(const Tile* tile, int draw_x, int draw_y);
+	template <typename TileRange, typename DrawFunction>
+	void RecordShadowCache(ShadowCache &cache, TileRange &&tiles, DrawFunction &&draw);
+	void ReplayShadowCache(const ShadowCache &cache, int move_x, int move_y, int move_z, int map_z = -1);
 	void DrawBrushIndicator(int x, int y, [[maybe_unused]] Brush* brush, uint8_t r, uint8_t g, uint8_t b);
 	void DrawHookIndicator(int x, int y, const ItemType &type);
 	void DrawLightStrength(int x, int y, const Item*&item);
@@ -263,6 +328,7 @@ protected:
 	void drawFilledRect(int x, int y, int w, int h, const wxColor &color);
 
 private:
+	int getFloorOffset(int map_z) const noexcept;
 	void getDrawPosition(const Position &position, int &x, int &y);
 };
 
@@ -124,6 +124,10 @@ public:
 // This is not a QuadTree, but a HexTree (16 child nodes to every node), so the name is abit misleading
 class QTreeNode {
 public:
+	// A node splits its area in ChildSplit by ChildSplit children, indexed by x then y
+	static constexpr int ChildSplit = 4;
+	static constexpr int ChildCount = ChildSplit * ChildSplit;
+
 	QTreeNode(BaseMap &map);
 	virtual ~QTreeNode();
 
@@ -164,7 +168,7 @@ protected:
 	bool isLeaf;
 
 	union {
-		QTreeNode* child[rme::MapLayers];
+		QTreeNode* child[ChildCount];
 		Floor* array[rme::MapLayers];
 		// #if 16 != rme::MapLayers
 		// #    error "You need to rewrite the QuadTree in order to handle more or less than 16 floors"
@@ -0,0 +1,155 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "map_search.h"
+
+#include "editor.h"
+#include "gui.h"
+#include "item_index.h"
+#include "parallel_for.h"
+#include "settings.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+	// Leaves searched by one worker in one go; the results of a chunk are handed over together
+	constexpr size_t SearchChunkSize = 256;
+}
+
+MapSearch::MapSearch(Editor &editor, bool selected_only) :
+	map(editor.getMap()), selected_only(selected_only), threaded(!editor.IsLiveServer()) {
+	map.getLeaves(0, 0, 0xFFFF, 0xFFFF, leaves);
+}
+
+void MapSearch::restrictToItem(uint16_t id) {
+	const ItemIndex* index = map.getItemIndex();
+	if (!index) {
+		return;
+	}
+
+	// Leaf keys sort in tree order, so the restricted leaves keep the order of a full scan
+	leaves.clear();
+	if (const ItemIndex::LeafCounts* counts = index->find(id)) {
+		for (const auto &[key, amount] : *counts) {
+			const Position corner = BaseMap::getLeafPosition(key);
+			if (QTreeNode* leaf = map.getLeaf(corner.x, corner.y)) {
+				leaves.push_back(leaf);
+			}
+		}
+	}
+}
+
+MapSearch::Results MapSearch::searchChunk(size_t chunk, const Visitor &visitor, const std::atomic<bool> &stop) const {
+	Results found;
+	const size_t end = std::min(leaves.size(), (chunk + 1) * SearchChunkSize);
+	for (size_t i = chunk * SearchChunkSize; i < end && !stop; ++i) {
+		for (int z = rme::MapMinLayer; z <= rme::MapMaxLayer; ++z) {
+			Floor* floor = leaves[i]->getFloor(z);
+			if (!floor) {
+				continue;
+			}
+
+			for (TileLocation &location : floor->locs) {
+				Tile* tile = location.get();
+				if (tile && (!selected_only || tile->isSelected())) {
+					visitor(tile, found);
+				}
+			}
+		}
+	}
+	return found;
+}
+
+bool MapSearch::run(const wxString &message, const Visitor &visitor, const Consumer &consumer) {
+	const size_t chunks = (leaves.size() + SearchChunkSize - 1) / SearchChunkSize;
+	std::atomic<bool> stop = false;
+
+	if (!threaded) {
+		g_gui.CreateLoadBar(message, true);
+		bool cancelled = false;
+		for (size_t chunk = 0; chunk < chunks; ++chunk) {
+			const Results found = searchChunk(chunk, visitor, stop);
+			if (!found.empty() && !consumer(found)) {
+				break;
+			}
+			if (!g_gui.SetLoadDone(static_cast<int32_t>((chunk + 1) * 99 / chunks))) {
+				cancelled = true;
+				break;
+			}
+		}
+		g_gui.DestroyLoadBar();
+		return !cancelled;
+	}
+
+	std::vector<Results> results(chunks);
+	std::vector<bool> finished(chunks, false);
+	std::mutex mutex;
+	std::condition_variable changed;
+	size_t finished_count = 0;
+
+	const unsigned int threads = static_cast<unsigned int>(std::max(g_settings.getInteger(Config::WORKER_THREADS), 1));
+	std::jthread search([&] {
+		rme::parallelFor(chunks, threads, [&](size_t chunk) {
+			Results found = searchChunk(chunk, visitor, stop);
+
+			std::scoped_lock lock(mutex);
+			results[chunk] = std::move(found);
+			finished[chunk] = true;
+			++finished_count;
+			changed.notify_one();
+		});
+	});
+
+	g_gui.CreateLoadBar(message, true);
+
+	bool cancelled = false;
+	size_t next = 0;
+	while (next < chunks && !stop) {
+		Results ready;
+		size_t progress;
+		{
+			std::unique_lock lock(mutex);
+			changed.wait_for(lock, std::chrono::milliseconds(50), [&] {
+				return finished[next];
+			});
+			progress = finished_count;
+			// Only the chunks following the ones already handed over can be passed on
+			while (next < chunks && finished[next]) {
+				ready.insert(ready.end(), results[next].begin(), results[next].end());
+				Results().swap(results[next]);
+				++next;
+			}
+		}
+
+		if (!ready.empty() && !consumer(ready)) {
+			stop = true;
+		}
+
+		if (!g_gui.SetLoadDone(static_cast<int32_t>(progress * 99 / std::max<size_t>(chunks, 1)))) {
+			cancelled = true;
+			stop = true;
+		}
+	}
+
+	search.join();
+	g_gui.DestroyLoadBar();
+	return !cancelled;
+}
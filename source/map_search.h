@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_SEARCH_H_
+#define RME_MAP_SEARCH_H_
+
+#include "map.h"
+
+class Editor;
+
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Searches the tiles of a map on the worker threads. The leaves to search
+// are split in fixed chunks; each chunk is searched by one worker into its
+// own result list, and the lists are handed to the caller on the UI thread
+// in map order, each as soon as the chunks before it are done. The results
+// come in the same order as a foreach_ItemOnMap scan, whatever the thread
+// count. A cancellable progress bar is shown while the search runs.
+//
+// Visitors run on the worker threads and must only read the map. While the
+// editor hosts a live session, client edits are applied whenever the
+// progress bar lets events through, so the chunks are searched one by one
+// on the UI thread between them instead.
+class MapSearch {
+public:
+	using Result = std::pair<Tile*, Item*>;
+	using Results = std::vector<Result>;
+	// Appends what it finds on the tile
+	using Visitor = std::function<void(Tile* tile, Results &results)>;
+	// Receives the next results in map order; returning false ends the search
+	using Consumer = std::function<bool(const Results &results)>;
+
+	MapSearch(Editor &editor, bool selected_only);
+
+	// Searches only the leaves the item index lists for the id, when the index is on
+	void restrictToItem(uint16_t id);
+
+	// Returns false when the user cancelled the search
+	bool run(const wxString &message, const Visitor &visitor, const Consumer &consumer);
+
+	// Calls fn for the ground, the items and the container contents of the tile, in foreach_ItemOnMap order
+	template <typename Function>
+	void forEachItem(Tile* tile, Function &&fn) {
+		auto visit = [&fn](Map &, Tile*, Item* item, long long) {
+			fn(item);
+		};
+		foreach_ItemOnTile(map, tile, visit, 0);
+	}
+
+private:
+	Results searchChunk(size_t chunk, const Visitor &visitor, const std::atomic<bool> &stop) const;
+
+	Map &map;
+	bool selected_only;
+	bool threaded;
+	std::vector<QTreeNode*> leaves;
+};
+
+#endif
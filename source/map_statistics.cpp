@@ -0,0 +1,361 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "map_statistics.h"
+
+#include "complexitem.h"
+#include "items.h"
+#include "map.h"
+#include "parallel_for.h"
+#include "settings.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace {
+	// Leaves counted by one worker before it takes the next chunk
+	constexpr size_t LeavesPerChunk = 256;
+
+	unsigned int getThreadCount() {
+		return static_cast<unsigned int>(std::max(g_settings.getInteger(Config::WORKER_THREADS), 1));
+	}
+
+	// Counts the tile's own contents only; what its location holds (house exits, waypoints) can change without the tile being replaced
+	bool hasContents(const Tile* tile) {
+		return tile->ground || !tile->items.empty() || !tile->monsters.empty() || tile->spawnMonster || tile->npc || tile->spawnNpc;
+	}
+
+	void countItem(TileCounters &counters, const Item* item, bool &detailed) {
+		counters.items += 1;
+		if (item->isGroundTile() || item->isBorder()) {
+			return;
+		}
+
+		detailed = true;
+		const ItemType &type = g_items.getItemType(item->getID());
+		if (type.moveable) {
+			counters.moveable_items += 1;
+		}
+		if (type.isDepot()) {
+			counters.depots += 1;
+		}
+		if (item->getActionID() > 0) {
+			counters.action_items += 1;
+		}
+		if (item->getUniqueID() > 0) {
+			counters.unique_items += 1;
+		}
+		if (const Container* container = dynamic_cast<const Container*>(item)) {
+			if (container->getItemCount() > 0) {
+				counters.containers += 1;
+			}
+		}
+	}
+}
+
+TileCounters TileCounters::count(const Tile* tile) {
+	TileCounters counters;
+	if (!tile || !hasContents(tile)) {
+		return counters;
+	}
+
+	counters.tiles = 1;
+
+	bool detailed = false;
+	if (tile->ground) {
+		countItem(counters, tile->ground, detailed);
+	}
+	for (const Item* item : tile->items) {
+		countItem(counters, item, detailed);
+	}
+	if (detailed) {
+		counters.detailed_tiles = 1;
+	}
+
+	if (tile->isBlocking()) {
+		counters.blocking_tiles = 1;
+	} else {
+		counters.walkable_tiles = 1;
+	}
+
+	counters.monsters = tile->monsters.size();
+	counters.monster_spawns = tile->spawnMonster ? 1 : 0;
+	counters.npcs = tile->npc ? 1 : 0;
+	counters.npc_spawns = tile->spawnNpc ? 1 : 0;
+	return counters;
+}
+
+TileCounters &TileCounters::operator+=(const TileCounters &other) noexcept {
+	tiles += other.tiles;
+	detailed_tiles += other.detailed_tiles;
+	blocking_tiles += other.blocking_tiles;
+	walkable_tiles += other.walkable_tiles;
+	items += other.items;
+	moveable_items += other.moveable_items;
+	depots += other.depots;
+	containers += other.containers;
+	action_items += other.action_items;
+	unique_items += other.unique_items;
+	monsters += other.monsters;
+	monster_spawns += other.monster_spawns;
+	npcs += other.npcs;
+	npc_spawns += other.npc_spawns;
+	return *this;
+}
+
+TileCounters &TileCounters::operator-=(const TileCounters &other) noexcept {
+	tiles -= other.tiles;
+	detailed_tiles -= other.detailed_tiles;
+	blocking_tiles -= other.blocking_tiles;
+	walkable_tiles -= other.walkable_tiles;
+	items -= other.items;
+	moveable_items -= other.moveable_items;
+	depots -= other.depots;
+	containers -= other.containers;
+	action_items -= other.action_items;
+	unique_items -= other.unique_items;
+	monsters -= other.monsters;
+	monster_spawns -= other.monster_spawns;
+	npcs -= other.npcs;
+	npc_spawns -= other.npc_spawns;
+	return *this;
+}
+
+bool TileCounters::covers(const TileCounters &other) const noexcept {
+	return tiles >= other.tiles
+		&& detailed_tiles >= other.detailed_tiles
+		&& blocking_tiles >= other.blocking_tiles
+		&& walkable_tiles >= other.walkable_tiles
+		&& items >= other.items
+		&& moveable_items >= other.moveable_items
+		&& depots >= other.depots
+		&& containers >= other.containers
+		&& action_items >= other.action_items
+		&& unique_items >= other.unique_items
+		&& monsters >= other.monsters
+		&& monster_spawns >= other.monster_spawns
+		&& npcs >= other.npcs
+		&& npc_spawns >= other.npc_spawns;
+}
+
+void TileStatistics::build(BaseMap &map) {
+	std::vector<QTreeNode*> leaves;
+	map.getLeaves(0, 0, 0xFFFF, 0xFFFF, leaves);
+
+	const size_t chunks = (leaves.size() + LeavesPerChunk - 1) / LeavesPerChunk;
+	std::vector<TileCounters> results(chunks);
+	rme::parallelFor(chunks, getThreadCount(), [&](size_t chunk) {
+		TileCounters &counted = results[chunk];
+		const size_t last = std::min(leaves.size(), (chunk + 1) * LeavesPerChunk);
+		for (size_t index = chunk * LeavesPerChunk; index < last; ++index) {
+			for (int z = rme::MapMinLayer; z <= rme::MapMaxLayer; ++z) {
+				const Floor* floor = leaves[index]->getFloor(z);
+				if (!floor) {
+					continue;
+				}
+				for (const TileLocation &location : floor->locs) {
+					counted += TileCounters::count(location.get());
+				}
+			}
+		}
+	});
+
+	counters = TileCounters();
+	for (const TileCounters &counted : results) {
+		counters += counted;
+	}
+	valid = true;
+}
+
+void TileStatistics::update(const Tile* old_tile, const Tile* new_tile) {
+	if (!valid || old_tile == new_tile) {
+		return;
+	}
+
+	const TileCounters removed = TileCounters::count(old_tile);
+	// The tile was changed behind the counters' back, so they can not be trusted anymore
+	if (!counters.covers(removed)) {
+		invalidate();
+		return;
+	}
+
+	counters -= removed;
+	counters += TileCounters::count(new_tile);
+}
+
+MapStatistics MapStatistics::collect(Map &map) {
+	MapStatistics statistics;
+	statistics.counters = map.getTileCounters();
+	statistics.towns = map.towns.count();
+	statistics.houses = map.houses.count();
+
+	std::vector<const House*> houses;
+	houses.reserve(map.houses.count());
+	for (const auto &[id, house] : map.houses) {
+		houses.push_back(house);
+	}
+
+	// Measuring a house looks up each of its tiles
+	std::vector<uint64_t> sizes(houses.size());
+	rme::parallelFor(houses.size(), getThreadCount(), [&](size_t index) {
+		sizes[index] = houses[index]->size();
+	});
+
+	std::map<uint32_t, uint64_t> town_sizes;
+	for (size_t index = 0; index < houses.size(); ++index) {
+		const House* house = houses[index];
+		if (sizes[index] > statistics.largest_house_size) {
+			statistics.largest_house = house;
+			statistics.largest_house_size = sizes[index];
+		}
+		statistics.house_tiles += sizes[index];
+		town_sizes[house->townid] += sizes[index];
+	}
+
+	for (const auto &[town_id, size] : town_sizes) {
+		const Town* town = map.towns.getTown(town_id);
+		if (town && size > statistics.largest_town_size) {
+			statistics.largest_town = town;
+			statistics.largest_town_size = size;
+		}
+	}
+	return statistics;
+}
+
+std::string MapStatistics::toString(const Map &map) const {
+	const auto ratio = [](uint64_t part, uint64_t whole) {
+		return whole != 0 ? double(part) / double(whole) : -1.0;
+	};
+	const double percent_pathable = 100.0 * ratio(counters.walkable_tiles, counters.tiles);
+	const double percent_detailed = 100.0 * ratio(counters.detailed_tiles, counters.tiles);
+	const double monsters_per_spawn = ratio(counters.monsters, counters.monster_spawns);
+	const double npcs_per_spawn = ratio(counters.npcs, counters.npc_spawns);
+	const double houses_per_town = ratio(houses, towns);
+	const double sqm_per_house = ratio(house_tiles, houses);
+	const double sqm_per_town = ratio(house_tiles, towns);
+
+	std::ostringstream os;
+	os.setf(std::ios::fixed, std::ios::floatfield);
+	os.precision(2);
+	os << "Map statistics for the map \"" << map.getMapDescription() << "\"\n";
+	os << "\tTile data:\n";
+	os << "\t\tTotal number of tiles: " << counters.tiles << "\n";
+	os << "\t\tNumber of pathable tiles: " << counters.walkable_tiles << "\n";
+	os << "\t\tNumber of unpathable tiles: " << counters.blocking_tiles << "\n";
+	if (percent_pathable >= 0.0) {
+		os << "\t\tPercent walkable tiles: " << percent_pathable << "%\n";
+	}
+	os << "\t\tDetailed tiles: " << counters.detailed_tiles << "\n";
+	if (percent_detailed >= 0.0) {
+		os << "\t\tPercent detailed tiles: " << percent_detailed << "%\n";
+	}
+
+	os << "\tItem data:\n";
+	os << "\t\tTotal number of items: " << counters.items << "\n";
+	os << "\t\tNumber of moveable tiles: " << counters.moveable_items << "\n";
+	os << "\t\tNumber of depots: " << counters.depots << "\n";
+	os << "\t\tNumber of containers: " << counters.containers << "\n";
+	os << "\t\tNumber of items with Action ID: " << counters.action_items << "\n";
+	os << "\t\tNumber of items with Unique ID: " << counters.unique_items << "\n";
+
+	os << "\tMonster data:\n";
+	os << "\t\tTotal monster count: " << counters.monsters << "\n";
+	os << "\t\tTotal monster spawn count: " << counters.monster_spawns << "\n";
+	os << "\t\tTotal npc count: " << counters.npcs << "\n";
+	os << "\t\tTotal npc spawn count: " << counters.npc_spawns << "\n";
+	if (monsters_per_spawn >= 0) {
+		os << "\t\tMean monsters per spawn: " << monsters_per_spawn << "\n";
+	}
+
+	if (npcs_per_spawn >= 0) {
+		os << "\t\tMean npcs per spawn: " << npcs_per_spawn << "\n";
+	}
+
+	os << "\tTown/House data:\n";
+	os << "\t\tTotal number of towns: " << towns << "\n";
+	os << "\t\tTotal number of houses: " << houses << "\n";
+	if (houses_per_town >= 0) {
+		os << "\t\tMean houses per town: " << houses_per_town << "\n";
+	}
+	os << "\t\tTotal amount of housetiles: " << house_tiles << "\n";
+	if (sqm_per_house >= 0) {
+		os << "\t\tMean tiles per house: " << sqm_per_house << "\n";
+	}
+	if (sqm_per_town >= 0) {
+		os << "\t\tMean tiles per town: " << sqm_per_town << "\n";
+	}
+
+	if (largest_town) {
+		os << "\t\tLargest Town: \"" << largest_town->getName() << "\" (" << largest_town_size << " sqm)\n";
+	}
+	if (largest_house) {
+		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
+	}
+
+	os << "\n";
+	os << "Generated by Canary's Map Editor version " + __RME_VERSION__ + "\n";
+	return os.str();
+}
+
+bool MapStatistics::saveXml(const std::string &path, const Map &map) const {
+	pugi::xml_document doc;
+	pugi::xml_node decl = doc.prepend_child(pugi::node_declaration);
+	decl.append_attribute("version") = "1.0";
+
+	pugi::xml_node root = doc.append_child("map_statistics");
+	root.append_attribute("map") = map.getMapDescription().c_str();
+	root.append_attribute("editor_version") = __RME_VERSION__.c_str();
+
+	pugi::xml_node tile_node = root.append_child("tiles");
+	tile_node.append_attribute("total") = counters.tiles;
+	tile_node.append_attribute("walkable") = counters.walkable_tiles;
+	tile_node.append_attribute("blocking") = counters.blocking_tiles;
+	tile_node.append_attribute("detailed") = counters.detailed_tiles;
+
+	pugi::xml_node item_node = root.append_child("items");
+	item_node.append_attribute("total") = counters.items;
+	item_node.append_attribute("moveable") = counters.moveable_items;
+	item_node.append_attribute("depots") = counters.depots;
+	item_node.append_attribute("containers") = counters.containers;
+	item_node.append_attribute("action_id") = counters.action_items;
+	item_node.append_attribute("unique_id") = counters.unique_items;
+
+	pugi::xml_node creature_node = root.append_child("creatures");
+	creature_node.append_attribute("monsters") = counters.monsters;
+	creature_node.append_attribute("monster_spawns") = counters.monster_spawns;
+	creature_node.append_attribute("npcs") = counters.npcs;
+	creature_node.append_attribute("npc_spawns") = counters.npc_spawns;
+
+	pugi::xml_node house_node = root.append_child("houses");
+	house_node.append_attribute("towns") = towns;
+	house_node.append_attribute("houses") = houses;
+	house_node.append_attribute("house_tiles") = house_tiles;
+	if (largest_town) {
+		pugi::xml_node node = house_node.append_child("largest_town");
+		node.append_attribute("name") = largest_town->getName().c_str();
+		node.append_attribute("size") = largest_town_size;
+	}
+	if (largest_house) {
+		pugi::xml_node node = house_node.append_child("largest_house");
+		node.append_attribute("name") = largest_house->name.c_str();
+		node.append_attribute("size") = largest_house_size;
+	}
+
+	return doc.save_file(path.c_str(), "\t", pugi::format_default, pugi::encoding_utf8);
+}
@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_STATISTICS_H_
+#define RME_MAP_STATISTICS_H_
+
+#include <cstdint>
+#include <string>
+
+class BaseMap;
+class Map;
+class House;
+class Tile;
+class Town;
+
+// Counts over a set of tiles. Counters of two sets add up to the counters
+// of their union, so they can follow a map tile by tile.
+struct TileCounters {
+	uint64_t tiles = 0; // tiles with a ground, items, creatures or spawns
+	uint64_t detailed_tiles = 0; // tiles with items besides grounds and borders
+	uint64_t blocking_tiles = 0;
+	uint64_t walkable_tiles = 0;
+
+	uint64_t items = 0; // grounds and items on tiles, not in containers
+	uint64_t moveable_items = 0;
+	uint64_t depots = 0;
+	uint64_t containers = 0; // only those holding items
+	uint64_t action_items = 0;
+	uint64_t unique_items = 0;
+
+	uint64_t monsters = 0;
+	uint64_t monster_spawns = 0;
+	uint64_t npcs = 0;
+	uint64_t npc_spawns = 0;
+
+	static TileCounters count(const Tile* tile);
+
+	TileCounters &operator+=(const TileCounters &other) noexcept;
+	TileCounters &operator-=(const TileCounters &other) noexcept;
+	// True when every counter is at least the one of other, so it can be taken out
+	bool covers(const TileCounters &other) const noexcept;
+};
+
+// The tile counters of a map, kept up to date from the tiles placed on the
+// map and taken off it, so reading them costs nothing. Changes made to a
+// tile while it is on the map go around them, like they go around the item
+// index; the code doing that invalidates both, and the counters are counted
+// again on the next read.
+class TileStatistics {
+public:
+	// Counts every leaf, spread over the worker threads
+	void build(BaseMap &map);
+	void invalidate() noexcept {
+		valid = false;
+	}
+	bool isValid() const noexcept {
+		return valid;
+	}
+
+	// Takes the counts of old_tile out and adds those of new_tile
+	void update(const Tile* old_tile, const Tile* new_tile);
+
+	const TileCounters &getCounters() const noexcept {
+		return counters;
+	}
+
+private:
+	TileCounters counters;
+	bool valid = false;
+};
+
+// Everything the map statistics dialog shows: the tile counters, and what
+// derives from the houses and towns of the map.
+struct MapStatistics {
+	TileCounters counters;
+
+	uint64_t towns = 0;
+	uint64_t houses = 0;
+	uint64_t house_tiles = 0;
+	const Town* largest_town = nullptr;
+	uint64_t largest_town_size = 0;
+	const House* largest_house = nullptr;
+	uint64_t largest_house_size = 0;
+
+	// House sizes are measured on the worker threads
+	static MapStatistics collect(Map &map);
+
+	std::string toString(const Map &map) const;
+	bool saveXml(const std::string &path, const Map &map) const;
+};
+
+#endif
@@ -52,6 +52,9 @@ public:
 
 	bool isNpc() const;
 
+	const std::string &getTypeName() const noexcept {
+		return type_name;
+	}
 	std::string getName() const;
 	NpcBrush* getBrush() const;
 
@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "outfit_colorizer.h"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define RME_OUTFIT_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define RME_OUTFIT_SSE2
+#endif
+
+namespace {
+	// Template pixels select a part by which of their B, G, R channels are
+	// non-zero; as little-endian BGRA words these are the patterns below.
+	constexpr std::array<uint32_t, OUTFIT_COLOR_PARTS> PartPatterns {
+		0x00FFFF00, // yellow => head
+		0x00FF0000, // red => body
+		0x0000FF00, // green => legs
+		0x000000FF, // blue => feet
+	};
+
+	// Channel multiplier as a BGRA word; alpha is kept as is
+	uint32_t toFactor(uint32_t color) {
+		return 0xFF000000 | (color & 0xFFFFFF);
+	}
+
+	// channel * factor / 255, rounded
+	uint8_t multiplyChannel(uint32_t channel, uint32_t factor) {
+		const uint32_t x = channel * factor + 128;
+		return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+	}
+
+	void colorizeScalar(uint8_t* pixels, const uint8_t* templatePixels, size_t pixelCount, const std::array<uint32_t, OUTFIT_COLOR_PARTS> &factors) {
+		for (size_t i = 0; i < pixelCount; ++i) {
+			const uint8_t* mask = templatePixels + i * 4;
+			const uint32_t pattern = (mask[0] ? 0x0000FF : 0) | (mask[1] ? 0x00FF00 : 0) | (mask[2] ? 0xFF0000 : 0);
+			if (pattern == 0) {
+				continue;
+			}
+
+			for (size_t part = 0; part < OUTFIT_COLOR_PARTS; ++part) {
+				if (pattern != PartPatterns[part]) {
+					continue;
+				}
+
+				uint8_t* pixel = pixels + i * 4;
+				const uint32_t factor = factors[part];
+				pixel[0] = multiplyChannel(pixel[0], factor & 0xFF);
+				pixel[1] = multiplyChannel(pixel[1], (factor >> 8) & 0xFF);
+				pixel[2] = multiplyChannel(pixel[2], (factor >> 16) & 0xFF);
+				break;
+			}
+		}
+	}
+
+#if defined(RME_OUTFIT_AVX2)
+	__m256i multiplyChannels(__m256i channels, __m256i factors) {
+		const __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(channels, factors), _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+	}
+
+	size_t colorizeVector(uint8_t* pixels, const uint8_t* templatePixels, size_t pixelCount, const std::array<uint32_t, OUTFIT_COLOR_PARTS> &factors) {
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+		const __m256i keep = _mm256_set1_epi32(-1);
+
+		size_t i = 0;
+		for (; i + 8 <= pixelCount; i += 8) {
+			const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(templatePixels + i * 4));
+			const __m256i pattern = _mm256_andnot_si256(_mm256_cmpeq_epi8(mask, zero), rgbMask);
+			if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(pattern, zero)) == -1) {
+				continue;
+			}
+
+			__m256i factor = keep;
+			for (size_t part = 0; part < OUTFIT_COLOR_PARTS; ++part) {
+				const __m256i selected = _mm256_cmpeq_epi32(pattern, _mm256_set1_epi32(static_cast<int>(PartPatterns[part])));
+				factor = _mm256_or_si256(_mm256_andnot_si256(selected, factor), _mm256_and_si256(selected, _mm256_set1_epi32(static_cast<int>(factors[part]))));
+			}
+
+			uint8_t* target = pixels + i * 4;
+			const __m256i source = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(target));
+			const __m256i low = multiplyChannels(_mm256_unpacklo_epi8(source, zero), _mm256_unpacklo_epi8(factor, zero));
+			const __m256i high = multiplyChannels(_mm256_unpackhi_epi8(source, zero), _mm256_unpackhi_epi8(factor, zero));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target), _mm256_packus_epi16(low, high));
+		}
+		return i;
+	}
+#elif defined(RME_OUTFIT_SSE2)
+	__m128i multiplyChannels(__m128i channels, __m128i factors) {
+		const __m128i x = _mm_add_epi16(_mm_mullo_epi16(channels, factors), _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+	}
+
+	size_t colorizeVector(uint8_t* pixels, const uint8_t* templatePixels, size_t pixelCount, const std::array<uint32_t, OUTFIT_COLOR_PARTS> &factors) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i keep = _mm_set1_epi32(-1);
+
+		size_t i = 0;
+		for (; i + 4 <= pixelCount; i += 4) {
+			const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(templatePixels + i * 4));
+			const __m128i pattern = _mm_andnot_si128(_mm_cmpeq_epi8(mask, zero), rgbMask);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(pattern, zero)) == 0xFFFF) {
+				continue;
+			}
+
+			__m128i factor = keep;
+			for (size_t part = 0; part < OUTFIT_COLOR_PARTS; ++part) {
+				const __m128i selected = _mm_cmpeq_epi32(pattern, _mm_set1_epi32(static_cast<int>(PartPatterns[part])));
+				factor = _mm_or_si128(_mm_andnot_si128(selected, factor), _mm_and_si128(selected, _mm_set1_epi32(static_cast<int>(factors[part]))));
+			}
+
+			uint8_t* target = pixels + i * 4;
+			const __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target));
+			const __m128i low = multiplyChannels(_mm_unpacklo_epi8(source, zero), _mm_unpacklo_epi8(factor, zero));
+			const __m128i high = multiplyChannels(_mm_unpackhi_epi8(source, zero), _mm_unpackhi_epi8(factor, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target), _mm_packus_epi16(low, high));
+		}
+		return i;
+	}
+#else
+	size_t colorizeVector(uint8_t*, const uint8_t*, size_t, const std::array<uint32_t, OUTFIT_COLOR_PARTS> &) {
+		return 0;
+	}
+#endif
+}
+
+void colorizeOutfit(uint8_t* pixels, const uint8_t* templatePixels, size_t pixelCount, const OutfitColors &colors) {
+	std::array<uint32_t, OUTFIT_COLOR_PARTS> factors;
+	for (size_t part = 0; part < OUTFIT_COLOR_PARTS; ++part) {
+		factors[part] = toFactor(colors[part]);
+	}
+
+	const size_t done = colorizeVector(pixels, templatePixels, pixelCount, factors);
+	colorizeScalar(pixels + done * 4, templatePixels + done * 4, pixelCount - done, factors);
+}
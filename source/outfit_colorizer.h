@@ -0,0 +1,42 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_OUTFIT_COLORIZER_H_
+#define RME_OUTFIT_COLORIZER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum OutfitColorPart {
+	OUTFIT_COLOR_HEAD,
+	OUTFIT_COLOR_BODY,
+	OUTFIT_COLOR_LEGS,
+	OUTFIT_COLOR_FEET,
+	OUTFIT_COLOR_PARTS,
+};
+
+using OutfitColors = std::array<uint32_t, OUTFIT_COLOR_PARTS>; // 0xRRGGBB per part
+
+// Tints the BGRA pixels of an outfit sprite in place. Each pixel is
+// multiplied by the head, body, legs or feet colour selected by the yellow,
+// red, green or blue pixel at the same position of the template sprite;
+// other pixels are left untouched. Uses AVX2 or SSE2 when the build targets
+// them, with identical results on every path.
+void colorizeOutfit(uint8_t* pixels, const uint8_t* templatePixels, size_t pixelCount, const OutfitColors &colors);
+
+#endif
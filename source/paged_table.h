@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_PAGED_TABLE_H_
+#define RME_PAGED_TABLE_H_
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Flat lookup table for densely packed ids such as client sprite ids.
+// Slots live in fixed-size pages that are allocated on first write, so a
+// lookup is two array indexings instead of a tree walk, and sparse id
+// ranges cost nothing. Unwritten slots read as a value-initialized T.
+template <typename T, size_t PageBits = 10>
+class PagedTable {
+public:
+	static constexpr size_t PageSize = size_t(1) << PageBits;
+
+	const T* find(size_t id) const noexcept {
+		const size_t page = id >> PageBits;
+		if (page >= pages.size() || !pages[page]) {
+			return nullptr;
+		}
+		return &(*pages[page])[id & PageMask];
+	}
+
+	// The stored value, or T{} if the slot was never written
+	T get(size_t id) const noexcept {
+		const T* slot = find(id);
+		return slot ? *slot : T {};
+	}
+
+	T &operator[](size_t id) {
+		const size_t page = id >> PageBits;
+		if (page >= pages.size()) {
+			pages.resize(page + 1);
+		}
+		if (!pages[page]) {
+			pages[page] = std::make_unique<Page>();
+		}
+		return (*pages[page])[id & PageMask];
+	}
+
+	// Calls fn(id, slot) for every slot of every allocated page
+	template <typename Function>
+	void forEach(Function &&fn) {
+		for (size_t page = 0; page < pages.size(); ++page) {
+			if (!pages[page]) {
+				continue;
+			}
+			for (size_t i = 0; i < PageSize; ++i) {
+				fn((page << PageBits) | i, (*pages[page])[i]);
+			}
+		}
+	}
+
+	void clear() noexcept {
+		pages.clear();
+	}
+
+	size_t memoryUsage() const noexcept {
+		size_t allocated = 0;
+		for (const auto &page : pages) {
+			allocated += page ? sizeof(Page) : 0;
+		}
+		return allocated + pages.capacity() * sizeof(std::unique_ptr<Page>);
+	}
+
+private:
+	static constexpr size_t PageMask = PageSize - 1;
+	using Page = std::array<T, PageSize>;
+
+	std::vector<std::unique_ptr<Page>> pages;
+};
+
+#endif
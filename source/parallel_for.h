@@ -0,0 +1,65 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_PARALLEL_FOR_H_
+#define RME_PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rme {
+	inline unsigned int getWorkerThreadCount() {
+		return std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	// Runs fn(0) ... fn(count - 1) spread over the given number of threads and
+	// returns once every call has finished. Indices are handed out one at a
+	// time, so uneven work per index balances itself.
+	template <typename Function>
+	void parallelFor(size_t count, unsigned int threads, Function &&fn) {
+		threads = static_cast<unsigned int>(std::min<size_t>(std::max(threads, 1u), count));
+		if (threads <= 1) {
+			for (size_t index = 0; index < count; ++index) {
+				fn(index);
+			}
+			return;
+		}
+
+		std::atomic<size_t> next = 0;
+		std::vector<std::jthread> workers;
+		workers.reserve(threads);
+		for (unsigned int i = 0; i < threads; ++i) {
+			workers.emplace_back([&] {
+				for (size_t index = next++; index < count; index = next++) {
+					fn(index);
+				}
+			});
+		}
+	}
+
+	template <typename Function>
+	void parallelFor(size_t count, Function &&fn) {
+		parallelFor(count, getWorkerThreadCount(), std::forward<Function>(fn));
+	}
+}
+
+#endif
@@ -95,6 +95,26 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	use_old_item_properties_window->SetToolTip("Enables the use of the old item properties window");
 	sizer->Add(use_old_item_properties_window, 0, wxLEFT | wxTOP, 5);
 
+	undo_delta_records_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Store undo steps as item changes");
+	undo_delta_records_chkbox->SetValue(g_settings.getBoolean(Config::UNDO_DELTA_RECORDS));
+	undo_delta_records_chkbox->SetToolTip("Undo steps keep only the items a change added, removed or modified instead of copies of whole tiles, so the undo memory limit lasts much longer. Not used in live sessions.");
+	sizer->Add(undo_delta_records_chkbox, 0, wxLEFT | wxTOP, 5);
+
+	undo_spill_to_disk_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Keep older undo steps on disk");
+	undo_spill_to_disk_chkbox->SetValue(g_settings.getBoolean(Config::UNDO_SPILL_TO_DISK));
+	undo_spill_to_disk_chkbox->SetToolTip("Undo steps beyond the undo queue size or memory limit are compressed into a temporary file instead of being discarded, and read back when you undo that far. Not used in live sessions.");
+	sizer->Add(undo_spill_to_disk_chkbox, 0, wxLEFT | wxTOP, 5);
+
+	edit_journal_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Journal edits for crash recovery");
+	edit_journal_chkbox->SetValue(g_settings.getBoolean(Config::EDIT_JOURNAL));
+	edit_journal_chkbox->SetToolTip("Every change to a saved map is appended to a .journal file next to it. If the editor closes unexpectedly, the changes can be replayed the next time the map is opened. Takes effect when a map is opened or saved.");
+	sizer->Add(edit_journal_chkbox, 0, wxLEFT | wxTOP, 5);
+
+	item_index_chkbox = newd wxCheckBox(general_page, wxID_ANY, "Index items by id");
+	item_index_chkbox->SetValue(g_settings.getBoolean(Config::ITEM_INDEX));
+	item_index_chkbox->SetToolTip("Keeps track of where each item id is on the map, so finding and replacing an item only looks at the areas that hold it instead of scanning the whole map. Built when a map is opened.");
+	sizer->Add(item_index_chkbox, 0, wxLEFT | wxTOP, 5);
+
 	sizer->AddSpacer(10);
 
 	auto* grid_sizer = newd wxFlexGridSizer(2, 10, 10);
@@ -259,6 +279,16 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 	sizer->Add(show_performance_stats_chkbox, 0, wxLEFT | wxTOP, 5);
 	SetWindowToolTip(show_performance_stats_chkbox, "Display real-time FPS, CPU and RAM usage on screen.");
 
+	preload_sprite_sheets_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Decode all sprite sheets on startup");
+	preload_sprite_sheets_chkbox->SetValue(g_settings.getBoolean(Config::PRELOAD_SPRITE_SHEETS));
+	sizer->Add(preload_sprite_sheets_chkbox, 0, wxLEFT | wxTOP, 5);
+	SetWindowToolTip(preload_sprite_sheets_chkbox, "Decodes the client's sprite sheets on all cores while loading, up to the sprite memory budget, so scrolling never waits for a sheet. Takes effect the next time the client is loaded.");
+
+	sprite_sheet_disk_cache_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Cache decoded sprite sheets on disk");
+	sprite_sheet_disk_cache_chkbox->SetValue(g_settings.getBoolean(Config::SPRITE_SHEET_DISK_CACHE));
+	sizer->Add(sprite_sheet_disk_cache_chkbox, 0, wxLEFT | wxTOP, 5);
+	SetWindowToolTip(sprite_sheet_disk_cache_chkbox, "Keeps uncompressed copies of the client's sprite sheets in the user folder, so later sessions load them without LZMA decoding. Needs about 600 KB per sheet; entries are replaced automatically when the client assets change. Takes effect the next time the client is loaded.");
+
 	icon_selection_shadow_chkbox = newd wxCheckBox(graphics_page, wxID_ANY, "Use icon selection shadow");
 	icon_selection_shadow_chkbox->SetValue(g_settings.getBoolean(Config::USE_GUI_SELECTION_SHADOW));
 	sizer->Add(icon_selection_shadow_chkbox, 0, wxLEFT | wxTOP, 5);
@@ -281,6 +311,16 @@ wxNotebookPage* PreferencesWindow::CreateGraphicsPage() {
 	subsizer->Add(palette_icons_row_size, 0);
 	SetWindowToolTip(palette_icons_row_size, tmp, "This will set the row size of the palette when using SMALL ICONS and LARGE ICONS will be the value divided by 2. The max rows are 99.");
 
+	minimap_lod_zoom_spin = newd wxSpinCtrl(graphics_page, wxID_ANY, i2ws(g_settings.getInteger(Config::MINIMAP_LOD_ZOOM)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 25);
+	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Minimap colors from zoom: "), 0);
+	subsizer->Add(minimap_lod_zoom_spin, 0);
+	SetWindowToolTip(minimap_lod_zoom_spin, tmp, "From this zoom level on, tiles are drawn with their minimap colors instead of sprites, which keeps very large maps responsive when zoomed far out. Set to 0 to always draw sprites.");
+
+	texture_memory_budget_spin = newd wxSpinCtrl(graphics_page, wxID_ANY, i2ws(g_settings.getInteger(Config::TEXTURE_MEMORY_BUDGET)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 64, 16384);
+	subsizer->Add(tmp = newd wxStaticText(graphics_page, wxID_ANY, "Sprite memory budget (MB): "), 0);
+	subsizer->Add(texture_memory_budget_spin, 0);
+	SetWindowToolTip(texture_memory_budget_spin, tmp, "Decoded sprite sheets and sprite textures are kept in memory up to this size. The least recently drawn ones are released first.");
+
 	// Icon background color
 	icon_background_choice = newd wxChoice(graphics_page, wxID_ANY);
 	icon_background_choice->Append("Black background");
@@ -659,6 +699,10 @@ void PreferencesWindow::Apply() {
 	g_settings.setInteger(Config::ONLY_ONE_INSTANCE, only_one_instance_chkbox->GetValue());
 	g_settings.setInteger(Config::UNDO_SIZE, undo_size_spin->GetValue());
 	g_settings.setInteger(Config::UNDO_MEM_SIZE, undo_mem_size_spin->GetValue());
+	g_settings.setInteger(Config::UNDO_DELTA_RECORDS, undo_delta_records_chkbox->GetValue());
+	g_settings.setInteger(Config::UNDO_SPILL_TO_DISK, undo_spill_to_disk_chkbox->GetValue());
+	g_settings.setInteger(Config::EDIT_JOURNAL, edit_journal_chkbox->GetValue());
+	g_settings.setInteger(Config::ITEM_INDEX, item_index_chkbox->GetValue());
 	g_settings.setInteger(Config::WORKER_THREADS, worker_threads_spin->GetValue());
 	g_settings.setInteger(Config::REPLACE_SIZE, replace_size_spin->GetValue());
 	g_settings.setInteger(Config::DELETE_BACKUP_DAYS, delete_backup_days_spin->GetValue());
@@ -730,7 +774,11 @@ void PreferencesWindow::Apply() {
 	// g_settings.setInteger(Config::CURSOR_ALT_ALPHA, clr.Alpha());
 
 	g_settings.setInteger(Config::HIDE_ITEMS_WHEN_ZOOMED, hide_items_when_zoomed_chkbox->GetValue());
+	g_settings.setInteger(Config::MINIMAP_LOD_ZOOM, minimap_lod_zoom_spin->GetValue());
+	g_settings.setInteger(Config::TEXTURE_MEMORY_BUDGET, texture_memory_budget_spin->GetValue());
 	g_settings.setInteger(Config::SHOW_PERFORMANCE_STATS, show_performance_stats_chkbox->GetValue());
+	g_settings.setInteger(Config::PRELOAD_SPRITE_SHEETS, preload_sprite_sheets_chkbox->GetValue());
+	g_settings.setInteger(Config::SPRITE_SHEET_DISK_CACHE, sprite_sheet_disk_cache_chkbox->GetValue());
 	/*
 	g_settings.setInteger(Config::TEXTURE_MANAGEMENT, texture_managment_chkbox->GetValue());
 	g_settings.setInteger(Config::TEXTURE_CLEAN_PULSE, clean_interval_spin->GetValue());
@@ -51,6 +51,10 @@ protected:
 	wxCheckBox* show_welcome_dialog_chkbox;
 	wxCheckBox* enable_tileset_editing_chkbox;
 	wxCheckBox* use_old_item_properties_window;
+	wxCheckBox* undo_delta_records_chkbox;
+	wxCheckBox* undo_spill_to_disk_chkbox;
+	wxCheckBox* edit_journal_chkbox;
+	wxCheckBox* item_index_chkbox;
 	wxSpinCtrl* undo_size_spin;
 	wxSpinCtrl* undo_mem_size_spin;
 	wxSpinCtrl* worker_threads_spin;
@@ -80,8 +84,12 @@ protected:
 	wxDirPickerCtrl* screenshot_directory_picker;
 	wxChoice* screenshot_format_choice;
 	wxCheckBox* hide_items_when_zoomed_chkbox;
+	wxSpinCtrl* minimap_lod_zoom_spin;
+	wxSpinCtrl* texture_memory_budget_spin;
 	wxColourPickerCtrl* cursor_color_pick;
 	wxCheckBox* show_performance_stats_chkbox;
+	wxCheckBox* preload_sprite_sheets_chkbox;
+	wxCheckBox* sprite_sheet_disk_cache_chkbox;
 	wxColourPickerCtrl* cursor_alt_color_pick;
 	wxTextCtrl* palette_icons_col_size;
 	wxTextCtrl* palette_icons_row_size;
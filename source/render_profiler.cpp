@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "render_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+RenderProfiler g_renderProfiler;
+
+const char* RenderProfiler::getPhaseName(RenderPhase phase) noexcept {
+	switch (phase) {
+		case RenderPhase::Frame:
+			return "Frame";
+		case RenderPhase::FloorIteration:
+			return "Floors";
+		case RenderPhase::Tiles:
+			return "Tiles";
+		case RenderPhase::Creatures:
+			return "Creatures";
+		case RenderPhase::Lights:
+			return "Lights";
+		case RenderPhase::Tooltips:
+			return "Tooltips";
+		case RenderPhase::Overlays:
+			return "Overlays";
+		case RenderPhase::GLFlush:
+			return "GL flush";
+		case RenderPhase::FBOBlit:
+			return "FBO blit";
+		default:
+			return "Unknown";
+	}
+}
+
+bool RenderProfiler::isAccumulated(RenderPhase phase) noexcept {
+	return phase == RenderPhase::Tiles || phase == RenderPhase::Creatures;
+}
+
+RenderPhase RenderProfiler::getParentPhase(RenderPhase phase) noexcept {
+	return phase == RenderPhase::Creatures ? RenderPhase::Tiles : RenderPhase::Count;
+}
+
+void RenderProfiler::beginFrame() {
+	if (!enabled) {
+		inFrame = false;
+		return;
+	}
+
+	frameTotals.fill(0);
+	frameStart = Clock::now();
+	inFrame = true;
+}
+
+void RenderProfiler::endFrame() {
+	if (!inFrame) {
+		return;
+	}
+	inFrame = false;
+
+	const auto frameEnd = Clock::now();
+	frameTotals[std::to_underlying(RenderPhase::Frame)] = std::chrono::duration_cast<std::chrono::nanoseconds>(frameEnd - frameStart).count();
+	pushTraceEvent(RenderPhase::Frame, toMicroseconds(frameStart), toMicroseconds(frameEnd) - toMicroseconds(frameStart));
+
+	const int64_t frameTimestamp = toMicroseconds(frameStart);
+	for (size_t i = 0; i < PhaseCount; ++i) {
+		history[i][historyHead] = static_cast<float>(frameTotals[i] / 1e6);
+
+		const auto phase = static_cast<RenderPhase>(i);
+		if (isAccumulated(phase)) {
+			pushTraceEvent(phase, frameTimestamp, frameTotals[i] / 1000);
+		}
+	}
+
+	historyHead = (historyHead + 1) % HistoryFrames;
+	historySize = std::min(historySize + 1, HistoryFrames);
+}
+
+void RenderProfiler::record(RenderPhase phase, Clock::time_point start, Clock::time_point end) {
+	if (!inFrame) {
+		return;
+	}
+
+	frameTotals[std::to_underlying(phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	if (!isAccumulated(phase)) {
+		const int64_t timestamp = toMicroseconds(start);
+		pushTraceEvent(phase, timestamp, toMicroseconds(end) - timestamp);
+	}
+}
+
+RenderPhaseStats RenderProfiler::getStats(RenderPhase phase) const {
+	RenderPhaseStats stats;
+	if (historySize == 0) {
+		return stats;
+	}
+
+	const auto &samples = history[std::to_underlying(phase)];
+	std::vector<float> sorted(samples.begin(), samples.begin() + historySize);
+	std::ranges::sort(sorted);
+
+	const auto percentile = [&sorted](double p) {
+		const auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+		return static_cast<double>(sorted[index]);
+	};
+
+	stats.p50 = percentile(0.50);
+	stats.p95 = percentile(0.95);
+	stats.p99 = percentile(0.99);
+	return stats;
+}
+
+bool RenderProfiler::exportChromeTrace(const std::string &path) const {
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	nlohmann::json events = nlohmann::json::array();
+
+	// The trace buffer is a ring; once full, traceHead points at the oldest event.
+	const size_t count = trace.size();
+	const size_t first = count < MaxTraceEvents ? 0 : traceHead;
+	for (size_t i = 0; i < count; ++i) {
+		const TraceEvent &event = trace[(first + i) % count];
+		if (isAccumulated(event.phase)) {
+			events.push_back({
+				{ "name", getPhaseName(event.phase) },
+				{ "cat", "render" },
+				{ "ph", "C" },
+				{ "ts", event.timestamp },
+				{ "pid", 1 },
+				{ "args", { { "ms", event.duration / 1000.0 } } },
+			});
+		} else {
+			events.push_back({
+				{ "name", getPhaseName(event.phase) },
+				{ "cat", "render" },
+				{ "ph", "X" },
+				{ "ts", event.timestamp },
+				{ "dur", event.duration },
+				{ "pid", 1 },
+				{ "tid", 1 },
+			});
+		}
+	}
+
+	nlohmann::json root = {
+		{ "traceEvents", std::move(events) },
+		{ "displayTimeUnit", "ms" },
+	};
+	file << root.dump();
+	return file.good();
+}
+
+int64_t RenderProfiler::toMicroseconds(Clock::time_point time) const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(time - epoch).count();
+}
+
+void RenderProfiler::pushTraceEvent(RenderPhase phase, int64_t timestamp, int64_t duration) {
+	if (trace.size() < MaxTraceEvents) {
+		trace.push_back({ phase, timestamp, duration });
+		return;
+	}
+
+	trace[traceHead] = { phase, timestamp, duration };
+	traceHead = (traceHead + 1) % MaxTraceEvents;
+}
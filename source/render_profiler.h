@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_RENDER_PROFILER_H_
+#define RME_RENDER_PROFILER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class RenderPhase : uint8_t {
+	Frame,
+	FloorIteration,
+	Tiles,
+	Creatures,
+	Lights,
+	Tooltips,
+	Overlays,
+	GLFlush,
+	FBOBlit,
+	Count,
+};
+
+struct RenderPhaseStats {
+	double p50 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+};
+
+// Collects per-phase timings of the map canvas paint. Phases entered once or
+// a few times per frame are kept as trace events; phases entered once per tile
+// are summed into a single value per frame and exported as trace counters.
+// Creatures are timed inside the Tiles phase, so their time is part of it.
+class RenderProfiler {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	class ScopedTimer {
+	public:
+		ScopedTimer(RenderProfiler &profiler, RenderPhase phase) noexcept :
+			profiler(profiler), phase(phase), active(profiler.isEnabled()) {
+			if (active) {
+				start = Clock::now();
+			}
+		}
+		~ScopedTimer() {
+			if (active) {
+				profiler.record(phase, start, Clock::now());
+			}
+		}
+
+		ScopedTimer(const ScopedTimer &) = delete;
+		ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+	private:
+		RenderProfiler &profiler;
+		RenderPhase phase;
+		bool active;
+		Clock::time_point start;
+	};
+
+	static const char* getPhaseName(RenderPhase phase) noexcept;
+	static bool isAccumulated(RenderPhase phase) noexcept;
+	// The phase whose time includes this one, Count for top level phases
+	static RenderPhase getParentPhase(RenderPhase phase) noexcept;
+
+	void setEnabled(bool enabled) noexcept {
+		this->enabled = enabled;
+	}
+	bool isEnabled() const noexcept {
+		return enabled;
+	}
+
+	void beginFrame();
+	void endFrame();
+	void record(RenderPhase phase, Clock::time_point start, Clock::time_point end);
+
+	RenderPhaseStats getStats(RenderPhase phase) const;
+	size_t getTraceEventCount() const noexcept {
+		return trace.size();
+	}
+
+	bool exportChromeTrace(const std::string &path) const;
+
+private:
+	static constexpr size_t PhaseCount = std::to_underlying(RenderPhase::Count);
+	static constexpr size_t HistoryFrames = 240;
+	static constexpr size_t MaxTraceEvents = 64 * 1024;
+
+	struct TraceEvent {
+		RenderPhase phase;
+		int64_t timestamp; // microseconds since epoch
+		int64_t duration; // microseconds, or the summed phase time for counters
+	};
+
+	int64_t toMicroseconds(Clock::time_point time) const;
+	void pushTraceEvent(RenderPhase phase, int64_t timestamp, int64_t duration);
+
+	bool enabled = false;
+	bool inFrame = false;
+	Clock::time_point epoch = Clock::now();
+	Clock::time_point frameStart;
+
+	std::array<int64_t, PhaseCount> frameTotals {}; // nanoseconds spent in each phase this frame
+	std::array<std::array<float, HistoryFrames>, PhaseCount> history {}; // milliseconds
+	size_t historyHead = 0;
+	size_t historySize = 0;
+
+	std::vector<TraceEvent> trace;
+	size_t traceHead = 0;
+};
+
+extern RenderProfiler g_renderProfiler;
+
+#endif
@@ -22,6 +22,7 @@
 #include "gui.h"
 #include "artprovider.h"
 #include "items.h"
+#include "item_replacer.h"
 
 // ============================================================================
 // ReplaceItemsButton
@@ -330,38 +331,22 @@ void ReplaceItemsDialog::OnExecuteButtonClicked(wxCommandEvent &WXUNUSED(event))
 
 	Editor* editor = tab->GetEditor();
 
-	int done = 0;
+	ItemReplacer replacer(*editor, selectionOnly);
+	replacer.setLimit((size_t)std::max(g_settings.getInteger(Config::REPLACE_SIZE), 0));
 	for (const ReplacingItem &info : items) {
-		ItemFinder finder(info.replaceId, (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
-
-		// search on map
-		foreach_ItemOnMap(editor->getMap(), finder, selectionOnly);
-
-		uint32_t total = 0;
-		const auto &result = finder.result;
-
-		if (!result.empty()) {
-			BatchAction* batch = editor->createBatch(ACTION_REPLACE_ITEMS);
-			Action* action = editor->createAction(batch);
-			for (const auto &pair : result) {
-				Tile* new_tile = pair.first->deepCopy(editor->getMap());
-				int index = pair.first->getIndexOf(pair.second);
-				ASSERT(index != wxNOT_FOUND);
-				Item* item = new_tile->getItemAt(index);
-				ASSERT(item && item->getID() == pair.second->getID());
-				transformItem(item, info.withId, new_tile);
-				action->addChange(new Change(new_tile));
-				total++;
-			}
-			batch->addAndCommitAction(action);
-			editor->addBatch(batch);
-			editor->updateActions();
-		}
+		replacer.addRule(info.replaceId, info.withId);
+	}
 
-		done++;
-		const int value = static_cast<int>((done / items.size()) * 100);
-		progress->SetValue(std::clamp<int>(value, 0, 100));
-		list->MarkAsComplete(info, total);
+	if (BatchAction* batch = replacer.run()) {
+		editor->addBatch(batch);
+		editor->updateActions();
+	}
+
+	if (!replacer.getStats().cancelled) {
+		for (size_t rule = 0; rule < items.size(); ++rule) {
+			list->MarkAsComplete(items[rule], static_cast<uint32_t>(replacer.getReplaced(rule)));
+		}
+		progress->SetValue(100);
 	}
 
 	tab->Refresh();
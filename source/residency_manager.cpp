@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "residency_manager.h"
+
+ResidencyManager g_residency;
+
+ResidencyManager::ResidencyManager() noexcept {
+	head.prev = &head;
+	head.next = &head;
+}
+
+void ResidencyManager::track(ResidencyNode &node, ResidencyKind kind, size_t bytes, void* owner, ResidencyNode::EvictFunction evict) noexcept {
+	release(node);
+
+	node.kind = kind;
+	node.bytes = bytes;
+	node.owner = owner;
+	node.evict = evict;
+	node.last_frame = frame;
+	link(node);
+
+	++stats.entries;
+	stats.resident_bytes += bytes;
+	stats.kind_bytes[std::to_underlying(kind)] += bytes;
+}
+
+void ResidencyManager::touch(ResidencyNode &node) noexcept {
+	if (!node.linked) {
+		return;
+	}
+
+	++stats.hits;
+	node.last_frame = frame;
+	if (head.next != &node) {
+		unlink(node);
+		link(node);
+	}
+}
+
+void ResidencyManager::release(ResidencyNode &node) noexcept {
+	if (!node.linked) {
+		return;
+	}
+
+	unlink(node);
+	--stats.entries;
+	stats.resident_bytes -= node.bytes;
+	stats.kind_bytes[std::to_underlying(node.kind)] -= node.bytes;
+}
+
+size_t ResidencyManager::enforceBudget() {
+	size_t evicted = 0;
+	while (stats.resident_bytes > stats.budget_bytes && head.prev != &head) {
+		ResidencyNode &node = *head.prev;
+		if (node.last_frame == frame) {
+			break;
+		}
+
+		// Unlink first so the owner's own release call becomes a no-op
+		release(node);
+		++stats.evictions;
+		++evicted;
+		if (node.evict) {
+			node.evict(node.owner);
+		}
+	}
+
+	++frame;
+	return evicted;
+}
+
+void ResidencyManager::link(ResidencyNode &node) noexcept {
+	node.prev = &head;
+	node.next = head.next;
+	head.next->prev = &node;
+	head.next = &node;
+	node.linked = true;
+}
+
+void ResidencyManager::unlink(ResidencyNode &node) noexcept {
+	node.prev->next = node.next;
+	node.next->prev = node.prev;
+	node.prev = nullptr;
+	node.next = nullptr;
+	node.linked = false;
+}
@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_RESIDENCY_MANAGER_H_
+#define RME_RESIDENCY_MANAGER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+enum class ResidencyKind : uint8_t {
+	SheetData, // decoded sprite sheet pixels in system memory
+	SheetTexture, // sprite sheet uploaded as a GL texture
+	SpriteTexture, // per-sprite GL texture (colorized outfits)
+	Count,
+};
+
+// Embedded in every resource the manager may evict. The owner must call
+// ResidencyManager::release before the node goes away.
+struct ResidencyNode {
+	using EvictFunction = void (*)(void* owner);
+
+	ResidencyNode() = default;
+	ResidencyNode(const ResidencyNode &) = delete;
+	ResidencyNode &operator=(const ResidencyNode &) = delete;
+
+	bool isResident() const noexcept {
+		return linked;
+	}
+
+	ResidencyNode* prev = nullptr;
+	ResidencyNode* next = nullptr;
+	void* owner = nullptr;
+	EvictFunction evict = nullptr;
+	size_t bytes = 0;
+	uint64_t last_frame = 0;
+	ResidencyKind kind = ResidencyKind::SheetData;
+	bool linked = false;
+};
+
+struct ResidencyStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	size_t entries = 0;
+	size_t resident_bytes = 0;
+	size_t budget_bytes = 0;
+	std::array<size_t, std::to_underlying(ResidencyKind::Count)> kind_bytes {};
+};
+
+// Least-recently-used bookkeeping for sprite sheet buffers and textures.
+// Tracking, touching and releasing an entry are O(1); enforceBudget evicts
+// from the cold end of the list until the resident size fits the budget.
+// Entries used during the current frame are never evicted, so a budget
+// smaller than one frame's working set overshoots instead of thrashing.
+// Only used from the UI thread.
+class ResidencyManager {
+public:
+	ResidencyManager() noexcept;
+	ResidencyManager(const ResidencyManager &) = delete;
+	ResidencyManager &operator=(const ResidencyManager &) = delete;
+
+	void setBudget(size_t bytes) noexcept {
+		stats.budget_bytes = bytes;
+	}
+
+	void track(ResidencyNode &node, ResidencyKind kind, size_t bytes, void* owner, ResidencyNode::EvictFunction evict) noexcept;
+	void touch(ResidencyNode &node) noexcept;
+	void release(ResidencyNode &node) noexcept;
+	void miss() noexcept {
+		++stats.misses;
+	}
+
+	// Evicts cold entries until the budget is met and starts a new frame.
+	// Returns the number of entries evicted.
+	size_t enforceBudget();
+
+	const ResidencyStats &getStats() const noexcept {
+		return stats;
+	}
+
+private:
+	void link(ResidencyNode &node) noexcept;
+	void unlink(ResidencyNode &node) noexcept;
+
+	// Sentinel of the circular list: head.next is the most recently used
+	// entry, head.prev the least recently used one.
+	ResidencyNode head;
+	ResidencyStats stats;
+	uint64_t frame = 1;
+};
+
+extern ResidencyManager g_residency;
+
+#endif
@@ -24,6 +24,9 @@
 #include "item.h"
 #include "editor.h"
 #include "gui.h"
+#include "parallel_for.h"
+
+#include <array>
 
 Selection::Selection(Editor &editor) :
 	editor(editor),
@@ -40,44 +43,27 @@ Selection::~Selection() {
 	delete session;
 }
 
-Position Selection::minPosition() const {
-	Position min_pos(0x10000, 0x10000, 0x10);
-	for (const Tile* tile : tiles) {
-		if (!tile) {
-			continue;
-		}
-		const Position &tile_pos = tile->getPosition();
-		if (min_pos.x > tile_pos.x) {
-			min_pos.x = tile_pos.x;
+namespace {
+	// Marks the ground and the borders on it, like Tile::selectGround does, in a selection state
+	void setGroundState(const Tile* tile, std::vector<bool> &state, bool selected) {
+		size_t index = 0;
+		if (tile->ground) {
+			state[index++] = selected;
 		}
-		if (min_pos.y > tile_pos.y) {
-			min_pos.y = tile_pos.y;
-		}
-		if (min_pos.z > tile_pos.z) {
-			min_pos.z = tile_pos.z;
+		for (const Item* item : tile->items) {
+			if (!item->isBorder()) {
+				break;
+			}
+			state[index++] = selected;
 		}
 	}
-	return min_pos;
-}
 
-Position Selection::maxPosition() const {
-	Position max_pos;
-	for (const Tile* tile : tiles) {
-		if (!tile) {
-			continue;
-		}
-		const Position &tile_pos = tile->getPosition();
-		if (max_pos.x < tile_pos.x) {
-			max_pos.x = tile_pos.x;
-		}
-		if (max_pos.y < tile_pos.y) {
-			max_pos.y = tile_pos.y;
-		}
-		if (max_pos.z < tile_pos.z) {
-			max_pos.z = tile_pos.z;
-		}
+	// A change that selects or deselects everything on the tile
+	Change* selectAll(const Tile* tile, bool selected) {
+		std::vector<bool> state = tile->getSelectionState();
+		state.assign(state.size(), selected);
+		return Change::Create(tile, std::move(state));
 	}
-	return max_pos;
 }
 
 void Selection::add(const Tile* tile, Item* item) {
@@ -89,18 +75,18 @@ void Selection::add(const Tile* tile, Item* item) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
+	// Read the state of the tile with the item selected
 	item->select();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	item->deselect();
 
 	if (g_settings.getInteger(Config::BORDER_IS_GROUND)) {
 		if (item->isBorder()) {
-			new_tile->selectGround();
+			setGroundState(tile, state, true);
 		}
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::add(const Tile* tile, SpawnMonster* spawnMonster) {
@@ -112,12 +98,12 @@ void Selection::add(const Tile* tile, SpawnMonster* spawnMonster) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
+	// Read the state of the tile with the spawn selected
 	spawnMonster->select();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	spawnMonster->deselect();
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::add(const Tile* tile, SpawnNpc* spawnNpc) {
@@ -129,28 +115,32 @@ void Selection::add(const Tile* tile, SpawnNpc* spawnNpc) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
+	// Read the state of the tile with the spawn selected
 	spawnNpc->select();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	spawnNpc->deselect();
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::add(const Tile* tile, const std::vector<Monster*> &monsters) {
 	ASSERT(subsession);
 	ASSERT(tile);
 
-	// Make a copy of the tile with the monsters selected
+	// Read the state of the tile with the monsters selected
+	std::vector<Monster*> unselected;
 	for (const auto monster : monsters) {
-		monster->select();
+		if (!monster->isSelected()) {
+			unselected.emplace_back(monster);
+			monster->select();
+		}
 	}
-	Tile* new_tile = tile->deepCopy(editor.getMap());
-	for (const auto monster : monsters) {
+	std::vector<bool> state = tile->getSelectionState();
+	for (const auto monster : unselected) {
 		monster->deselect();
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::add(const Tile* tile, Monster* monster) {
@@ -162,12 +152,12 @@ void Selection::add(const Tile* tile, Monster* monster) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
+	// Read the state of the tile with the monster selected
 	monster->select();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	monster->deselect();
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::add(const Tile* tile, Npc* npc) {
@@ -179,22 +169,19 @@ void Selection::add(const Tile* tile, Npc* npc) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
+	// Read the state of the tile with the npc selected
 	npc->select();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	npc->deselect();
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::add(const Tile* tile) {
 	ASSERT(subsession);
 	ASSERT(tile);
 
-	Tile* new_tile = tile->deepCopy(editor.getMap());
-	new_tile->select();
-
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(selectAll(tile, true));
 }
 
 void Selection::remove(Tile* tile, Item* item) {
@@ -204,15 +191,15 @@ void Selection::remove(Tile* tile, Item* item) {
 
 	bool selected = item->isSelected();
 	item->deselect();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	if (selected) {
 		item->select();
 	}
 	if (item->isBorder() && g_settings.getInteger(Config::BORDER_IS_GROUND)) {
-		new_tile->deselectGround();
+		setGroundState(tile, state, false);
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::remove(Tile* tile, SpawnMonster* spawnMonster) {
@@ -222,12 +209,12 @@ void Selection::remove(Tile* tile, SpawnMonster* spawnMonster) {
 
 	bool selected = spawnMonster->isSelected();
 	spawnMonster->deselect();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	if (selected) {
 		spawnMonster->select();
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::remove(Tile* tile, SpawnNpc* spawnNpc) {
@@ -237,12 +224,12 @@ void Selection::remove(Tile* tile, SpawnNpc* spawnNpc) {
 
 	bool selected = spawnNpc->isSelected();
 	spawnNpc->deselect();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	if (selected) {
 		spawnNpc->select();
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::remove(Tile* tile, const std::vector<Monster*> &monsters) {
@@ -256,12 +243,12 @@ void Selection::remove(Tile* tile, const std::vector<Monster*> &monsters) {
 		}
 		monster->deselect();
 	}
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	for (const auto monster : selectedMonsters) {
 		monster->select();
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::remove(Tile* tile, Monster* monster) {
@@ -271,12 +258,12 @@ void Selection::remove(Tile* tile, Monster* monster) {
 
 	bool selected = monster->isSelected();
 	monster->deselect();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	if (selected) {
 		monster->select();
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::remove(Tile* tile, Npc* npc) {
@@ -286,21 +273,75 @@ void Selection::remove(Tile* tile, Npc* npc) {
 
 	bool selected = npc->isSelected();
 	npc->deselect();
-	Tile* new_tile = tile->deepCopy(editor.getMap());
+	std::vector<bool> state = tile->getSelectionState();
 	if (selected) {
 		npc->select();
 	}
 
-	subsession->addChange(newd Change(new_tile));
+	subsession->addChange(Change::Create(tile, std::move(state)));
 }
 
 void Selection::remove(Tile* tile) {
 	ASSERT(subsession);
 
-	Tile* new_tile = tile->deepCopy(editor.getMap());
-	new_tile->deselect();
+	subsession->addChange(selectAll(tile, false));
+}
+
+void Selection::addArea(const Position &start, const Position &end, bool compensated) {
+	ASSERT(subsession);
+
+	if (start.z < end.z) {
+		return;
+	}
+
+	// How far the box is shifted on each floor
+	std::array<int, rme::MapLayers> offsets {};
+	int offset = 0;
+	for (int z = start.z; z >= end.z; --z) {
+		offsets[z] = offset;
+		if (compensated && z <= rme::MapGroundLayer) {
+			++offset;
+		}
+	}
+
+	// Only the leaves holding tiles are visited, instead of every position in the box
+	std::vector<QTreeNode*> leaves;
+	editor.getMap().getLeaves(std::max(start.x, 0), std::max(start.y, 0), end.x + offsets[end.z], end.y + offsets[end.z], leaves);
+
+	// Leaves are split in fixed chunks, each read by one worker into its own
+	// list; the lists are joined in tree order so the result does not depend
+	// on the thread count
+	constexpr size_t LeavesPerChunk = 256;
+	const size_t chunks = (leaves.size() + LeavesPerChunk - 1) / LeavesPerChunk;
+	std::vector<ChangeList> results(chunks);
+	const unsigned int threads = std::max(g_settings.getInteger(Config::WORKER_THREADS), 1);
+	rme::parallelFor(chunks, threads, [&](size_t chunk) {
+		ChangeList &changes = results[chunk];
+		const size_t last = std::min(leaves.size(), (chunk + 1) * LeavesPerChunk);
+		for (size_t index = chunk * LeavesPerChunk; index < last; ++index) {
+			for (int z = start.z; z >= end.z; --z) {
+				Floor* floor = leaves[index]->getFloor(z);
+				if (!floor) {
+					continue;
+				}
+
+				const int shift = offsets[z];
+				for (TileLocation &location : floor->locs) {
+					const Tile* tile = location.get();
+					const Position &position = location.getPosition();
+					if (tile && position.x >= start.x + shift && position.x <= end.x + shift && position.y >= start.y + shift && position.y <= end.y + shift) {
+						changes.push_back(selectAll(tile, true));
+					}
+				}
+			}
+		}
+	});
 
-	subsession->addChange(newd Change(new_tile));
+	for (const ChangeList &changes : results) {
+		for (Change* change : changes) {
+			subsession->addChange(change);
+		}
+	}
 }
 
 void Selection::addInternal(Tile* tile) {
@@ -311,15 +352,19 @@ void Selection::addInternal(Tile* tile) {
 
 void Selection::removeInternal(Tile* tile) {
 	ASSERT(tile);
+	// The store tracks positions; when a swap already placed another selected
+	// tile on this one's position, that position stays selected
+	const Tile* current = tile->getLocation()->get();
+	if (current && current != tile && current->isSelected()) {
+		return;
+	}
 	tiles.erase(tile);
 }
 
 void Selection::clear() {
 	if (session) {
 		for (Tile* tile : tiles) {
-			Tile* new_tile = tile->deepCopy(editor.getMap());
-			new_tile->deselect();
-			subsession->addChange(newd Change(new_tile));
+			subsession->addChange(selectAll(tile, false));
 		}
 	} else {
 		for (Tile* tile : tiles) {
@@ -389,54 +434,3 @@ void Selection::updateSelectionCount() {
 		g_gui.SetStatusText(ss);
 	}
 }
-
-void Selection::join(SelectionThread* thread) {
-	thread->Wait();
-
-	ASSERT(session);
-	session->addAction(thread->result);
-	thread->selection.subsession = nullptr;
-
-	delete thread;
-}
-
-SelectionThread::SelectionThread(Editor &editor, Position start, Position end) :
-	wxThread(wxTHREAD_JOINABLE),
-	editor(editor),
-	start(start),
-	end(end),
-	selection(editor),
-	result(nullptr) {
-	////
-}
-
-void SelectionThread::Execute() {
-	Create();
-	Run();
-}
-
-wxThread::ExitCode SelectionThread::Entry() {
-	selection.start(Selection::SUBTHREAD);
-	bool compesated = g_settings.getInteger(Config::COMPENSATED_SELECT);
-	for (int z = start.z; z >= end.z; --z) {
-		for (int x = start.x; x <= end.x; ++x) {
-			for (int y = start.y; y <= end.y; ++y) {
-				Tile* tile = editor.getMap().getTile(x, y, z);
-				if (!tile) {
-					continue;
-				}
-
-				selection.add(tile);
-			}
-		}
-		if (compesated && z <= rme::MapGroundLayer) {
-			++start.x;
-			++start.y;
-			++end.x;
-			++end.y;
-		}
-	}
-	result = selection.subsession;
-	selection.finish(Selection::SUBTHREAD);
-	return nullptr;
-}
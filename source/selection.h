@@ -21,13 +21,12 @@
 #include "position.h"
 #include "npc.h"
 #include "action.h"
+#include "selection_store.h"
 
 class Action;
 class Editor;
 class BatchAction;
 
-class SelectionThread;
-
 class Selection {
 public:
 	Selection(Editor &editor);
@@ -49,6 +48,9 @@ public:
 	void remove(Tile* tile, Monster* monster);
 	void remove(Tile* tile, Npc* npc);
 	void remove(Tile* tile);
+	// Selects every tile in the box on the floors from start.z down to end.z,
+	// shifting the box one tile down-right per floor above ground when compensated
+	void addArea(const Position &start, const Position &end, bool compensated);
 
 	// The tile will be added to the list of selected tiles, however, the items on the tile won't be selected
 	void addInternal(Tile* tile);
@@ -62,9 +64,13 @@ public:
 		return busy;
 	}
 
-	//
-	Position minPosition() const;
-	Position maxPosition() const;
+	// Bounds of the selected tiles, kept up to date by the store
+	Position minPosition() const {
+		return tiles.minPosition();
+	}
+	Position maxPosition() const {
+		return tiles.maxPosition();
+	}
 
 	// This manages a "selection session"
 	// Internal session doesn't store the result (eg. no undo)
@@ -81,10 +87,6 @@ public:
 	void commit();
 	void finish(SessionFlags flags = NONE);
 
-	// Joins the selection instance in this thread with this instance
-	// This deletes the thread
-	void join(SelectionThread* thread);
-
 	size_t size() const noexcept {
 		return tiles.size();
 	}
@@ -92,13 +94,13 @@ public:
 		return tiles.empty();
 	}
 	void updateSelectionCount();
-	TileSet::iterator begin() noexcept {
+	SelectionStore::Iterator begin() const {
 		return tiles.begin();
 	}
-	TileSet::iterator end() noexcept {
+	SelectionStore::Iterator end() const {
 		return tiles.end();
 	}
-	const TileSet &getTiles() const noexcept {
+	const SelectionStore &getTiles() const noexcept {
 		return tiles;
 	}
 	Tile* getSelectedTile() {
@@ -110,26 +112,8 @@ private:
 	Editor &editor;
 	BatchAction* session;
 	Action* subsession;
-	TileSet tiles;
+	SelectionStore tiles;
 	bool busy;
-
-	friend class SelectionThread;
-};
-
-class SelectionThread : public wxThread {
-public:
-	SelectionThread(Editor &editor, Position start, Position end);
-
-	void Execute(); // Calls "Create" and then "Run"
-
-protected:
-	virtual ExitCode Entry();
-	Editor &editor;
-	Position start, end;
-	Selection selection;
-	Action* result;
-
-	friend class Selection;
 };
 
 #endif
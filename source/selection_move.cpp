@@ -0,0 +1,280 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "selection_move.h"
+
+#include "editor.h"
+#include "settings.h"
+#include "ground_brush.h"
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+
+namespace {
+	double millisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool isWhollySelected(const Tile* tile) {
+		const std::vector<bool> state = tile->getSelectionState();
+		return !state.empty() && std::ranges::all_of(state, [](bool selected) { return selected; });
+	}
+}
+
+SelectionMover::SelectionMover(Editor &editor, const Position &offset) :
+	editor(editor),
+	map(editor.getMap()),
+	selection(editor.getSelection()),
+	offset(offset) {
+	////
+}
+
+BatchAction* SelectionMover::run() {
+	const auto start = std::chrono::steady_clock::now();
+
+	BatchAction* batch = editor.createBatch(ACTION_MOVE);
+	detach(batch);
+	place(batch);
+	redoBorders(batch);
+
+	stats.total_ms = millisecondsSince(start);
+	return batch;
+}
+
+void SelectionMover::detach(BatchAction* batch) {
+	const auto start = std::chrono::steady_clock::now();
+
+	Action* action = editor.createAction(batch);
+	sources.reserve(selection.size());
+	moved.reserve(selection.size());
+
+	// The selection is walked leaf by leaf, so the source tiles are swapped in map order
+	for (Tile* tile : selection) {
+		Tile* remaining;
+		Tile* contents;
+
+		if (isWhollySelected(tile)) {
+			// Everything goes: the copy becomes the moved contents as it is, and
+			// the tile left behind keeps only what the split path leaves there
+			contents = tile->deepCopy(map);
+			remaining = map.allocator(tile->getLocation());
+			remaining->zones.swap(contents->zones);
+			remaining->setMapFlags(contents->getMapFlags());
+			if (!contents->ground) {
+				remaining->house_id = contents->house_id;
+				contents->house_id = 0;
+				contents->unsetMapFlags(contents->getMapFlags());
+			}
+			++stats.whole_tiles;
+		} else {
+			remaining = tile->deepCopy(map);
+			contents = map.allocator(tile->getLocation());
+
+			ItemVector selected_items = remaining->popSelectedItems();
+			for (Item* item : selected_items) {
+				contents->addItem(item);
+			}
+
+			// Move monster spawns
+			if (remaining->spawnMonster && remaining->spawnMonster->isSelected()) {
+				contents->spawnMonster = remaining->spawnMonster;
+				remaining->spawnMonster = nullptr;
+			}
+			// Move monster
+			for (const auto monster : remaining->popSelectedMonsters()) {
+				contents->addMonster(monster);
+			}
+			// Move npc
+			if (remaining->npc && remaining->npc->isSelected()) {
+				contents->npc = remaining->npc;
+				remaining->npc = nullptr;
+			}
+			// Move npc spawns
+			if (remaining->spawnNpc && remaining->spawnNpc->isSelected()) {
+				contents->spawnNpc = remaining->spawnNpc;
+				remaining->spawnNpc = nullptr;
+			}
+
+			if (contents->ground) {
+				contents->house_id = remaining->house_id;
+				remaining->house_id = 0;
+				contents->setMapFlags(remaining->getMapFlags());
+			}
+		}
+
+		if (contents->ground) {
+			borderize = true;
+		}
+
+		sources.push_back(tile->getPosition());
+		moved.push_back(contents);
+		action->addChange(new Change(remaining));
+	}
+	batch->addAndCommitAction(action);
+
+	stats.tiles = moved.size();
+	stats.detach_ms = millisecondsSince(start);
+}
+
+void SelectionMover::place(BatchAction* batch) {
+	const auto start = std::chrono::steady_clock::now();
+
+	// Grouped by destination leaf, so each leaf is looked up once and its tiles are swapped together
+	const auto destination = [this](const Tile* tile) {
+		const Position position = tile->getPosition() - offset;
+		return std::tuple(position.x & ~3, position.y & ~3, position.z, position.x, position.y);
+	};
+	std::ranges::sort(moved, {}, destination);
+
+	const bool merge = g_settings.getInteger(Config::MERGE_MOVE);
+	Action* action = editor.createAction(batch);
+	QTreeNode* leaf = nullptr;
+	int leaf_x = -1;
+	int leaf_y = -1;
+	for (Tile* tile : moved) {
+		const Position position = tile->getPosition() - offset;
+		if (position.x < 0 || position.y < 0 || position.z < rme::MapMinLayer || position.z > rme::MapMaxLayer) {
+			delete tile;
+			continue;
+		}
+
+		if (!leaf || (position.x & ~3) != leaf_x || (position.y & ~3) != leaf_y) {
+			leaf = map.createLeaf(position.x, position.y);
+			leaf_x = position.x & ~3;
+			leaf_y = position.y & ~3;
+		}
+
+		TileLocation* location = leaf->createTile(position.x, position.y, position.z);
+		Tile* old_dest_tile = location->get();
+		Tile* new_dest_tile;
+
+		if (!tile->ground || merge) {
+			// Move items
+			if (old_dest_tile) {
+				new_dest_tile = old_dest_tile->deepCopy(map);
+			} else {
+				new_dest_tile = map.allocator(location);
+			}
+			new_dest_tile->merge(tile);
+			delete tile;
+		} else {
+			// Replace tile instead of just merge
+			tile->setLocation(location);
+			new_dest_tile = tile;
+		}
+		action->addChange(new Change(new_dest_tile));
+	}
+	moved.clear();
+	batch->addAndCommitAction(action);
+
+	stats.place_ms = millisecondsSince(start);
+}
+
+void SelectionMover::redoBorders(BatchAction* batch) {
+	if (!g_settings.getInteger(Config::USE_AUTOMAGIC) || !g_settings.getInteger(Config::BORDERIZE_DRAG)) {
+		return;
+	}
+	// Large moves are not rebordered at all, on either side
+	if (selection.size() >= static_cast<size_t>(g_settings.getInteger(Config::BORDERIZE_DRAG_THRESHOLD))) {
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	// Positions to fix up: the vacated area with the ring around it, and the
+	// ring around the placed area with the placed tiles that touch it. Both
+	// are gathered once the tiles are placed, so every border sees the final
+	// map.
+	struct Candidate {
+		Position position;
+		bool vacated;
+	};
+	std::vector<Candidate> candidates;
+	candidates.reserve(sources.size() * 3);
+
+	for (const Position &source : sources) {
+		for (int y = source.y - 1; y <= source.y + 1; ++y) {
+			for (int x = source.x - 1; x <= source.x + 1; ++x) {
+				if (x >= 0 && y >= 0) {
+					candidates.push_back({ Position(x, y, source.z), true });
+				}
+			}
+		}
+	}
+
+	for (const Tile* tile : selection) {
+		const Position &position = tile->getPosition();
+		bool edge = false;
+		for (int y = position.y - 1; y <= position.y + 1; ++y) {
+			for (int x = position.x - 1; x <= position.x + 1; ++x) {
+				const Tile* neighbour = x >= 0 && y >= 0 ? map.getTile(x, y, position.z) : nullptr;
+				if (neighbour && !neighbour->isSelected()) {
+					candidates.push_back({ neighbour->getPosition(), false });
+					edge = true;
+				}
+			}
+		}
+		if (edge) {
+			candidates.push_back({ position, false });
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+		return a.position < b.position;
+	});
+
+	Action* action = editor.createAction(batch);
+	for (size_t index = 0; index < candidates.size();) {
+		const Position position = candidates[index].position;
+		bool vacated = false;
+		bool placed = false;
+		for (; index < candidates.size() && candidates[index].position == position; ++index) {
+			vacated |= candidates[index].vacated;
+			placed |= !candidates[index].vacated;
+		}
+
+		const Tile* tile = map.getTile(position);
+		if (!tile) {
+			continue;
+		}
+
+		// Around the vacated area everything unselected is fixed up, around the
+		// placed area only grounds that belong to a brush
+		const bool ground_brush = tile->ground && tile->ground->getGroundBrush();
+		if (!(vacated && !tile->isSelected()) && !(placed && ground_brush)) {
+			continue;
+		}
+
+		Tile* new_tile = tile->deepCopy(map);
+		if (borderize) {
+			new_tile->borderize(&map);
+		}
+		new_tile->wallize(&map);
+		new_tile->tableize(&map);
+		new_tile->carpetize(&map);
+		if (tile->ground && tile->ground->isSelected()) {
+			new_tile->selectGround();
+		}
+		action->addChange(new Change(new_tile));
+	}
+	stats.border_tiles = action->size();
+	batch->addAndCommitAction(action);
+
+	stats.border_ms = millisecondsSince(start);
+}
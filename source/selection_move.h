@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SELECTION_MOVE_H_
+#define RME_SELECTION_MOVE_H_
+
+#include "position.h"
+
+#include <vector>
+
+class Editor;
+class Map;
+class Selection;
+class Tile;
+class BatchAction;
+
+struct SelectionMoveStats {
+	size_t tiles = 0;
+	size_t whole_tiles = 0; // moved without splitting the tile
+	size_t border_tiles = 0;
+	double detach_ms = 0.0;
+	double place_ms = 0.0;
+	double border_ms = 0.0;
+	double total_ms = 0.0;
+};
+
+// Moves the selection of an editor as one batch of three actions: the
+// selected contents are taken off their tiles, placed at the destination
+// grouped by leaf, and the borders, walls, tables and carpets around both
+// areas are redone in a single pass once the map holds its final state.
+// Tiles whose whole contents are selected are handed to the destination as
+// one copy instead of being emptied item by item.
+class SelectionMover {
+public:
+	SelectionMover(Editor &editor, const Position &offset);
+
+	// Commits the move; the caller stores the returned batch for undo
+	BatchAction* run();
+
+	const SelectionMoveStats &getStats() const noexcept {
+		return stats;
+	}
+
+private:
+	void detach(BatchAction* batch);
+	void place(BatchAction* batch);
+	void redoBorders(BatchAction* batch);
+
+	Editor &editor;
+	Map &map;
+	Selection &selection;
+	Position offset;
+
+	bool borderize = false; // a ground was moved, so grounds need new borders
+	std::vector<Position> sources;
+	std::vector<Tile*> moved; // selected contents, still at their source location
+	SelectionMoveStats stats;
+};
+
+#endif
@@ -0,0 +1,193 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "selection_store.h"
+
+#include "basemap.h"
+#include "tile.h"
+
+namespace {
+	constexpr int FloorSlots = 16; // positions of a leaf on one floor
+
+	int slotIndex(const Position &position) noexcept {
+		return (position.x & 3) * 4 + (position.y & 3);
+	}
+}
+
+SelectionStore::Iterator::Iterator(BlockMap::const_iterator block, BlockMap::const_iterator last) :
+	block(block), last(last) {
+	if (block != last) {
+		advance();
+	}
+}
+
+void SelectionStore::Iterator::advance() {
+	tile = nullptr;
+	while (block != last) {
+		const Block &current = block->second;
+		while (++slot < rme::MapLayers * FloorSlots) {
+			const int z = slot / FloorSlots;
+			const int index = slot % FloorSlots;
+			if ((current.masks[z] & (1u << index)) == 0) {
+				// Skip the rest of an empty floor at once
+				if (current.masks[z] == 0) {
+					slot = z * FloorSlots + FloorSlots - 1;
+				}
+				continue;
+			}
+
+			tile = current.floors[z][index].get();
+			if (tile) {
+				return;
+			}
+		}
+		++block;
+		slot = -1;
+	}
+}
+
+bool SelectionStore::insert(Tile* tile) {
+	const Position &position = tile->getPosition();
+	const uint32_t key = BaseMap::getLeafKey(position.x, position.y);
+
+	if (last_block == blocks.end() || last_block->first != key) {
+		// Selections mostly grow in tree order, right after the last block used
+		const auto hint = last_block == blocks.end() ? last_block : std::next(last_block);
+		last_block = blocks.try_emplace(hint, key);
+	}
+
+	Block &block = last_block->second;
+	const int index = slotIndex(position);
+	const uint16_t bit = static_cast<uint16_t>(1u << index);
+	if (block.masks[position.z] & bit) {
+		return false;
+	}
+
+	if (!block.floors[position.z]) {
+		block.x = position.x & ~3;
+		block.y = position.y & ~3;
+		block.floors[position.z] = tile->getLocation() - index;
+	}
+	block.masks[position.z] |= bit;
+
+	if (count++ == 0) {
+		min_position = max_position = position;
+		bounds_stale = false;
+	} else if (!bounds_stale) {
+		min_position.x = std::min(min_position.x, position.x);
+		min_position.y = std::min(min_position.y, position.y);
+		min_position.z = std::min(min_position.z, position.z);
+		max_position.x = std::max(max_position.x, position.x);
+		max_position.y = std::max(max_position.y, position.y);
+		max_position.z = std::max(max_position.z, position.z);
+	}
+	return true;
+}
+
+bool SelectionStore::erase(const Tile* tile) {
+	const Position &position = tile->getPosition();
+	const uint32_t key = BaseMap::getLeafKey(position.x, position.y);
+
+	auto it = last_block;
+	if (it == blocks.end() || it->first != key) {
+		it = blocks.find(key);
+		if (it == blocks.end()) {
+			return false;
+		}
+	}
+
+	Block &block = it->second;
+	const uint16_t bit = static_cast<uint16_t>(1u << slotIndex(position));
+	if ((block.masks[position.z] & bit) == 0) {
+		return false;
+	}
+
+	block.masks[position.z] &= ~bit;
+	if (std::ranges::all_of(block.masks, [](uint16_t mask) { return mask == 0; })) {
+		if (last_block == it) {
+			last_block = blocks.end();
+		}
+		blocks.erase(it);
+	}
+
+	--count;
+	if (position.x == min_position.x || position.y == min_position.y || position.z == min_position.z
+		|| position.x == max_position.x || position.y == max_position.y || position.z == max_position.z) {
+		bounds_stale = true;
+	}
+	return true;
+}
+
+void SelectionStore::clear() {
+	blocks.clear();
+	last_block = blocks.end();
+	count = 0;
+	bounds_stale = false;
+}
+
+void SelectionStore::measureBounds() const {
+	bounds_stale = false;
+	bool first = true;
+	for (const auto &[key, block] : blocks) {
+		for (int z = 0; z < rme::MapLayers; ++z) {
+			const uint16_t mask = block.masks[z];
+			if (mask == 0) {
+				continue;
+			}
+
+			for (int index = 0; index < FloorSlots; ++index) {
+				if ((mask & (1u << index)) == 0) {
+					continue;
+				}
+
+				const Position position(block.x + (index >> 2), block.y + (index & 3), z);
+				if (first) {
+					min_position = max_position = position;
+					first = false;
+					continue;
+				}
+				min_position.x = std::min(min_position.x, position.x);
+				min_position.y = std::min(min_position.y, position.y);
+				min_position.z = std::min(min_position.z, position.z);
+				max_position.x = std::max(max_position.x, position.x);
+				max_position.y = std::max(max_position.y, position.y);
+				max_position.z = std::max(max_position.z, position.z);
+			}
+		}
+	}
+}
+
+Position SelectionStore::minPosition() const {
+	if (empty()) {
+		return Position(0x10000, 0x10000, 0x10);
+	}
+	if (bounds_stale) {
+		measureBounds();
+	}
+	return min_position;
+}
+
+Position SelectionStore::maxPosition() const {
+	if (empty()) {
+		return Position();
+	}
+	if (bounds_stale) {
+		measureBounds();
+	}
+	return max_position;
+}
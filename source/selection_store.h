@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SELECTION_STORE_H_
+#define RME_SELECTION_STORE_H_
+
+#include "const.h"
+#include "position.h"
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+class Tile;
+class TileLocation;
+
+// The selected tiles of a map, grouped by the map leaf (4x4 tiles on every
+// floor) they live in. Blocks are kept in the order the map tree stores its
+// leaves and hold one bit per position, so iterating visits the tiles leaf by
+// leaf. The bounding box grows as tiles are added; removing a tile on its
+// edge only marks it stale, and it is measured again from the blocks on the
+// next query.
+class SelectionStore {
+	struct Block {
+		int x = 0; // corner of the leaf
+		int y = 0;
+		std::array<TileLocation*, rme::MapLayers> floors {}; // first location of each floor of the leaf
+		std::array<uint16_t, rme::MapLayers> masks {};
+	};
+	using BlockMap = std::map<uint32_t, Block>;
+
+public:
+	SelectionStore() = default;
+
+	SelectionStore(const SelectionStore &) = delete;
+	SelectionStore &operator=(const SelectionStore &) = delete;
+
+	class Iterator {
+	public:
+		using iterator_concept = std::forward_iterator_tag;
+		using iterator_category = std::input_iterator_tag;
+		using value_type = Tile*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Tile* const*;
+		using reference = Tile*;
+
+		Iterator() = default;
+
+		Tile* operator*() const noexcept {
+			return tile;
+		}
+		Iterator &operator++() {
+			advance();
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator copy = *this;
+			advance();
+			return copy;
+		}
+		bool operator==(const Iterator &other) const noexcept {
+			return block == other.block && slot == other.slot;
+		}
+
+	private:
+		Iterator(BlockMap::const_iterator block, BlockMap::const_iterator last);
+
+		// Moves to the next selected position that holds a tile
+		void advance();
+
+		BlockMap::const_iterator block;
+		BlockMap::const_iterator last;
+		int slot = -1; // floor * 16 + index within the floor
+		Tile* tile = nullptr;
+
+		friend class SelectionStore;
+	};
+
+	// Returns false if the position of the tile was already in the store
+	bool insert(Tile* tile);
+	// Returns false if the position of the tile was not in the store
+	bool erase(const Tile* tile);
+	void clear();
+
+	size_t size() const noexcept {
+		return count;
+	}
+	bool empty() const noexcept {
+		return count == 0;
+	}
+
+	Iterator begin() const {
+		return Iterator(blocks.begin(), blocks.end());
+	}
+	Iterator end() const {
+		return Iterator(blocks.end(), blocks.end());
+	}
+
+	Position minPosition() const;
+	Position maxPosition() const;
+
+private:
+	void measureBounds() const;
+
+	BlockMap blocks;
+	BlockMap::iterator last_block = blocks.end(); // Consecutive tiles tend to share a leaf
+	size_t count = 0;
+
+	mutable Position min_position;
+	mutable Position max_position;
+	mutable bool bounds_stale = false;
+};
+
+#endif
@@ -236,6 +236,10 @@ void Settings::IO(IOMode mode) {
 	Int(MERGE_PASTE, 0);
 	Int(UNDO_SIZE, 400);
 	Int(UNDO_MEM_SIZE, 40);
+	Int(UNDO_DELTA_RECORDS, 1);
+	Int(UNDO_SPILL_TO_DISK, 1);
+	Int(EDIT_JOURNAL, 1);
+	Int(ITEM_INDEX, 1);
 	Int(GROUP_ACTIONS, 1);
 	Int(SELECTION_TYPE, SELECT_CURRENT_FLOOR);
 	Int(COMPENSATED_SELECT, 1);
@@ -283,11 +287,15 @@ void Settings::IO(IOMode mode) {
 	Int(TEXTURE_CLEAN_PULSE, 15);
 	Int(TEXTURE_LONGEVITY, 20);
 	Int(TEXTURE_CLEAN_THRESHOLD, 2500);
+	Int(TEXTURE_MEMORY_BUDGET, 512);
+	Int(PRELOAD_SPRITE_SHEETS, 0);
+	Int(SPRITE_SHEET_DISK_CACHE, 0);
 	Int(SOFTWARE_CLEAN_THRESHOLD, 1800);
 	Int(SOFTWARE_CLEAN_SIZE, 500);
 	Int(ICON_BACKGROUND, 0);
 	Int(HARD_REFRESH_RATE, 200);
 	Int(HIDE_ITEMS_WHEN_ZOOMED, 1);
+	Int(MINIMAP_LOD_ZOOM, 12);
 	String(SCREENSHOT_DIRECTORY, "");
 	String(SCREENSHOT_FORMAT, "png");
 	Int(MINIMAP_UPDATE_DELAY, 333);
@@ -34,6 +34,9 @@ namespace Config {
 		TEXTURE_CLEAN_PULSE,
 		TEXTURE_CLEAN_THRESHOLD,
 		TEXTURE_LONGEVITY,
+		TEXTURE_MEMORY_BUDGET,
+		PRELOAD_SPRITE_SHEETS,
+		SPRITE_SHEET_DISK_CACHE,
 		HARD_REFRESH_RATE,
 		SOFTWARE_CLEAN_THRESHOLD,
 		SOFTWARE_CLEAN_SIZE,
@@ -66,11 +69,16 @@ namespace Config {
 		SHOW_ONLY_TILEFLAGS,
 		SHOW_ONLY_MODIFIED_TILES,
 		HIDE_ITEMS_WHEN_ZOOMED,
+		MINIMAP_LOD_ZOOM,
 		GROUP_ACTIONS,
 		SCROLL_SPEED,
 		ZOOM_SPEED,
 		UNDO_SIZE,
 		UNDO_MEM_SIZE,
+		UNDO_DELTA_RECORDS,
+		UNDO_SPILL_TO_DISK,
+		EDIT_JOURNAL,
+		ITEM_INDEX,
 		MERGE_PASTE,
 		SELECTION_TYPE,
 		COMPENSATED_SELECT,
@@ -22,8 +22,14 @@
 #include "filehandle.h"
 #include "gui.h"
 #include "gl_renderer.h"
+#include "sprite_decode_pool.h"
+#include "sprite_sheet_cache.h"
+#include "parallel_for.h"
 
 #include <lzma.h>
+#include <atomic>
+#include <random>
+#include <thread>
 
 #include "gl_compat.h"
 
@@ -31,12 +37,24 @@ namespace fs = std::filesystem;
 
 SpriteAppearances g_spriteAppearances;
 
+namespace {
+	void evictSheetData(void* owner) {
+		static_cast<SpriteSheet*>(owner)->releaseData();
+	}
+
+	void evictSheetTexture(void* owner) {
+		static_cast<SpriteSheet*>(owner)->releaseGLTexture();
+	}
+}
+
 void SpriteAppearances::init() {
 	// in tibia 12.81 there is currently 3482 sheets
 	sheets.reserve(4000);
+	g_spriteDecodePool.start();
 }
 
 void SpriteAppearances::terminate() {
+	g_spriteDecodePool.stop();
 	unload();
 }
 
@@ -83,6 +101,15 @@ bool SpriteAppearances::loadCatalogContent(const std::string &dir, bool loadData
 		return a->lastId < b->lastId;
 	});
 
+	locations.clear();
+	for (size_t i = 0; i < sheets.size(); ++i) {
+		indexSpriteSheet(i);
+	}
+	spdlog::info("Indexed {} sprites of {} sheets ({} KB lookup table)", spritesCount, sheets.size(), locations.memoryUsage() / 1024);
+
+	g_spriteSheetCache.configure(g_settings.getBoolean(Config::SPRITE_SHEET_DISK_CACHE), fs::path(GUI::GetLocalDirectory().ToStdString()) / "sprite-cache");
+	g_spriteSheetCache.prune(sheets);
+
 	return true;
 }
 
@@ -91,18 +118,42 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 		return false;
 	}
 
-	std::ifstream file(sheet->path, std::ios::binary | std::ios::in);
-	if (!file.is_open()) {
-		spdlog::error("[SpriteAppearances::loadSpriteSheet] - Unable to open given sheets files");
+	std::unique_ptr<uint8_t[]> data = g_spriteSheetCache.load(*sheet);
+	if (!data) {
 		return false;
 	}
 
-	std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), (std::istreambuf_iterator<char>()));
+	sheet->setData(std::move(data));
+	sheet->loaded = true;
+	return true;
+}
+
+std::unique_ptr<uint8_t[]> SpriteAppearances::decodeSpriteSheet(const std::string &path) {
+	std::vector<uint8_t> buffer;
+	if (!readSpriteSheetFile(path, buffer)) {
+		spdlog::error("[SpriteAppearances::decodeSpriteSheet] - Unable to open given sheets files");
+		return nullptr;
+	}
+	return decodeSpriteSheet(buffer);
+}
+
+bool SpriteAppearances::readSpriteSheetFile(const std::string &path, std::vector<uint8_t> &buffer) {
+	std::ifstream file(path, std::ios::binary | std::ios::in | std::ios::ate);
+	if (!file.is_open()) {
+		return false;
+	}
 
-	int pos = 0;
+	const std::streamsize size = file.tellg();
+	if (size <= 0) {
+		return false;
+	}
 
-	file.close();
+	buffer.resize(static_cast<size_t>(size));
+	file.seekg(0, std::ios::beg);
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(buffer.data()), size));
+}
 
+std::unique_ptr<uint8_t[]> SpriteAppearances::decodeSpriteSheet(std::span<const uint8_t> file) {
 	/*
 	   CIP's header, always 32 (0x20) bytes.
 	   Header format:
@@ -111,14 +162,21 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 	   [X, X + 0x05):	  The constant byte sequence [0x70 0x0A 0xFA 0x80 0x24]
 	   [X + 0x05, 0x20]:   LZMA file size (Note: excluding the 32 bytes of this header) encoded as a 7-bit integer
    */
+	constexpr size_t LzmaHeaderSize = 1 + 4 + 8; // properties, dictionary size, compressed size
 
-	while (buffer[pos++] == 0x00)
+	size_t pos = 0;
+	while (pos < file.size() && file[pos++] == 0x00)
 		;
 	pos += 4;
-	while ((buffer[pos++] & 0x80) == 0x80)
+	while (pos < file.size() && (file[pos++] & 0x80) == 0x80)
 		;
 
-	uint8_t lclppb = buffer[pos++];
+	if (pos + LzmaHeaderSize > file.size()) {
+		spdlog::error("[SpriteAppearances::decodeSpriteSheet] - Truncated sheet header");
+		return nullptr;
+	}
+
+	uint8_t lclppb = file[pos++];
 
 	lzma_options_lzma options {};
 	options.lc = lclppb % 9;
@@ -129,7 +187,7 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 
 	uint32_t dictionarySize = 0;
 	for (uint8_t i = 0; i < 4; ++i) {
-		dictionarySize += buffer[pos++] << (i * 8);
+		dictionarySize += file[pos++] << (i * 8);
 	}
 
 	options.dict_size = dictionarySize;
@@ -146,20 +204,21 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 	lzma_ret ret = lzma_raw_decoder(&stream, filters);
 	if (ret != LZMA_OK) {
 		spdlog::error("Failed to initialize lzma raw decoder result: {}", static_cast<int>(ret));
-		return false;
+		return nullptr;
 	}
 
 	std::unique_ptr<uint8_t[]> decompressed = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE); // uncompressed size, bmp file + 122 bytes header
 
-	stream.next_in = &buffer[pos];
+	stream.next_in = file.data() + pos;
 	stream.next_out = decompressed.get();
-	stream.avail_in = buffer.size();
+	stream.avail_in = file.size() - pos;
 	stream.avail_out = LZMA_UNCOMPRESSED_SIZE;
 
 	ret = lzma_code(&stream, LZMA_RUN);
 	if (ret != LZMA_STREAM_END) {
 		spdlog::error("Failed to decode lzma buffer result: {}", static_cast<int>(ret));
-		return false;
+		lzma_end(&stream);
+		return nullptr;
 	}
 
 	lzma_end(&stream); // free memory
@@ -167,6 +226,10 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 	// pixel data start (bmp header end offset)
 	uint32_t pixelOffset;
 	std::memcpy(&pixelOffset, decompressed.get() + 10, sizeof(uint32_t));
+	if (pixelOffset + BYTES_IN_SPRITE_SHEET > LZMA_UNCOMPRESSED_SIZE) {
+		spdlog::error("[SpriteAppearances::decodeSpriteSheet] - Invalid bitmap pixel offset {}", pixelOffset);
+		return nullptr;
+	}
 
 	uint8_t* pixelData = decompressed.get() + pixelOffset;
 
@@ -178,14 +241,176 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr &sheet) {
 		std::swap_ranges(itr1, itr1 + SPRITE_SHEET_WIDTH_BYTES, itr2);
 	}
 
-	sheet->data = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
-	std::memcpy(sheet->data.get(), pixelData, BYTES_IN_SPRITE_SHEET);
+	// Drop the bitmap header in place instead of copying into a second buffer
+	std::memmove(decompressed.get(), pixelData, BYTES_IN_SPRITE_SHEET);
+	return decompressed;
+}
+
+size_t SpriteAppearances::preloadSpriteSheets(size_t maxBytes) {
+	constexpr size_t SheetBytes = LZMA_UNCOMPRESSED_SIZE;
+	const size_t capacity = maxBytes / SheetBytes;
 
-	sheet->loaded = true;
-	return true;
+	std::vector<SpriteSheetPtr> pending;
+	for (const SpriteSheetPtr &sheet : sheets) {
+		if (pending.size() >= capacity) {
+			break;
+		}
+		if (!sheet->data && sheet->glTextureId == 0) {
+			pending.push_back(sheet);
+		}
+	}
+
+	if (pending.empty()) {
+		return 0;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::unique_ptr<uint8_t[]>> decoded(pending.size());
+	rme::parallelFor(pending.size(), [&](size_t index) {
+		decoded[index] = g_spriteSheetCache.load(*pending[index]);
+	});
+
+	size_t loaded = 0;
+	for (size_t i = 0; i < pending.size(); ++i) {
+		if (decoded[i]) {
+			pending[i]->setData(std::move(decoded[i]));
+			pending[i]->loaded = true;
+			++loaded;
+		}
+	}
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	spdlog::info("Preloaded {} of {} sprite sheets in {:.2f}s", loaded, sheets.size(), elapsed);
+	if (capacity < sheets.size()) {
+		spdlog::info("The sprite memory budget holds {} sheets; the rest are decoded on demand", capacity);
+	}
+	return loaded;
+}
+
+SpriteSheetBenchmark SpriteAppearances::benchmarkSpriteSheets() {
+	using Clock = std::chrono::steady_clock;
+	const auto milliseconds = [](Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	};
+
+	SpriteSheetBenchmark result;
+	result.sheets = sheets.size();
+
+	std::vector<uint8_t> buffer;
+	for (size_t i = 0; i < sheets.size(); ++i) {
+		if (!g_gui.SetLoadDone(static_cast<int32_t>(50 * i / sheets.size()))) {
+			result.cancelled = true;
+			return result;
+		}
+
+		const auto readStart = Clock::now();
+		if (!readSpriteSheetFile(sheets[i]->path, buffer)) {
+			++result.failed;
+			continue;
+		}
+		const auto decodeStart = Clock::now();
+		const bool decoded = decodeSpriteSheet(buffer) != nullptr;
+		const auto decodeEnd = Clock::now();
+
+		result.read_ms += milliseconds(decodeStart - readStart);
+		result.decode_ms += milliseconds(decodeEnd - decodeStart);
+		result.file_bytes += buffer.size();
+		if (decoded) {
+			result.decoded_bytes += BYTES_IN_SPRITE_SHEET;
+		} else {
+			++result.failed;
+		}
+	}
+
+	g_gui.SetLoadDone(50, "Decoding sprite sheets on all threads...");
+	result.threads = rme::getWorkerThreadCount();
+	const auto parallelStart = Clock::now();
+	rme::parallelFor(sheets.size(), result.threads, [this](size_t index) {
+		decodeSpriteSheet(sheets[index]->path);
+	});
+	result.parallel_ms = milliseconds(Clock::now() - parallelStart);
+	return result;
+}
+
+SpriteLookupBenchmark SpriteAppearances::benchmarkSpriteLookups(size_t samples) {
+	using Clock = std::chrono::steady_clock;
+	constexpr size_t Rounds = 64;
+
+	SpriteLookupBenchmark result;
+	if (sheets.empty() || samples == 0) {
+		return result;
+	}
+
+	// Both structures hold every catalog id, as the image space does after loading
+	std::map<int, uint32_t> tree;
+	for (size_t i = 0; i < sheets.size(); ++i) {
+		for (int id = sheets[i]->firstId; id <= sheets[i]->lastId; ++id) {
+			tree.emplace_hint(tree.end(), id, static_cast<uint32_t>(i));
+		}
+	}
+	result.tree_bytes = tree.size() * (sizeof(std::map<int, uint32_t>::value_type) + 4 * sizeof(void*));
+	result.table_bytes = locations.memoryUsage();
+
+	// Visible sprites come from all over the catalog
+	std::mt19937 random(static_cast<uint32_t>(samples));
+	std::uniform_int_distribution<size_t> pickSheet(0, sheets.size() - 1);
+	std::vector<int> ids;
+	ids.reserve(samples);
+	for (size_t i = 0; i < samples; ++i) {
+		const SpriteSheetPtr &sheet = sheets[pickSheet(random)];
+		const int firstId = std::max(sheet->firstId, 1);
+		if (sheet->lastId < firstId) {
+			++result.skipped;
+			continue;
+		}
+
+		// Ids without a location would not be drawn at all
+		const int id = std::uniform_int_distribution<int>(firstId, sheet->lastId)(random);
+		if (!getSpriteLocation(id) || !tree.contains(id)) {
+			++result.skipped;
+			continue;
+		}
+		ids.push_back(id);
+	}
+	result.samples = ids.size();
+	result.lookups = ids.size() * Rounds;
+	if (ids.empty()) {
+		return result;
+	}
+
+	uint64_t treeSum = 0;
+	const auto treeStart = Clock::now();
+	for (size_t round = 0; round < Rounds; ++round) {
+		for (const int id : ids) {
+			const auto it = tree.find(id);
+			const auto sheetIt = std::lower_bound(sheets.begin(), sheets.end(), id, [](const SpriteSheetPtr &sheet, int spriteId) {
+				return sheet->lastId < spriteId;
+			});
+			treeSum += it->second + (*sheetIt)->getSpriteSize().width;
+		}
+	}
+	const auto treeEnd = Clock::now();
+
+	uint64_t tableSum = 0;
+	for (size_t round = 0; round < Rounds; ++round) {
+		for (const int id : ids) {
+			const SpriteLocation* location = getSpriteLocation(id);
+			tableSum += (location->sheet - 1) + location->width;
+		}
+	}
+	const auto tableEnd = Clock::now();
+
+	const auto nanoseconds = [&result](Clock::duration duration) {
+		return std::chrono::duration<double, std::nano>(duration).count() / static_cast<double>(result.lookups);
+	};
+	result.tree_ns = nanoseconds(treeEnd - treeStart);
+	result.table_ns = nanoseconds(tableEnd - treeEnd);
+	result.consistent = treeSum == tableSum;
+	return result;
 }
 
 void SpriteAppearances::unload() {
+	g_spriteDecodePool.clear();
 	for (const auto &sheet : sheets) {
 		if (sheet) {
 			sheet->releaseGLTexture();
@@ -193,9 +418,50 @@ void SpriteAppearances::unload() {
 	}
 	spritesCount = 0;
 	sheets.clear();
+	locations.clear();
 	sprites.clear();
 }
 
+void SpriteAppearances::addSpriteSheet(SpriteSheetPtr sheet) {
+	sheets.push_back(std::move(sheet));
+	indexSpriteSheet(sheets.size() - 1);
+}
+
+void SpriteAppearances::indexSpriteSheet(size_t index) {
+	const SpriteSheetPtr &sheet = sheets[index];
+	if (!sheet || sheet->lastId < sheet->firstId) {
+		return;
+	}
+
+	const SpritesSize size = sheet->getSpriteSize();
+	SpriteLocation location;
+	location.sheet = static_cast<uint32_t>(index + 1);
+	location.width = static_cast<uint8_t>(size.width);
+	location.height = static_cast<uint8_t>(size.height);
+	for (int id = std::max(sheet->firstId, 1); id <= sheet->lastId; ++id) {
+		locations[id] = location;
+	}
+}
+
+SpriteSheet::~SpriteSheet() {
+	g_residency.release(dataResidency);
+	g_residency.release(textureResidency);
+}
+
+void SpriteSheet::setData(std::unique_ptr<uint8_t[]> pixels) {
+	data = std::move(pixels);
+	if (data) {
+		g_residency.track(dataResidency, ResidencyKind::SheetData, LZMA_UNCOMPRESSED_SIZE, this, evictSheetData);
+	} else {
+		g_residency.release(dataResidency);
+	}
+}
+
+void SpriteSheet::releaseData() {
+	g_residency.release(dataResidency);
+	data.reset();
+}
+
 GLuint SpriteSheet::getOrUploadGLTexture() {
 	if (glTextureId != 0) {
 		return glTextureId;
@@ -212,6 +478,7 @@ GLuint SpriteSheet::getOrUploadGLTexture() {
 		}
 	}
 
+	g_residency.miss();
 	glGenTextures(1, &glTextureId);
 	glBindTexture(GL_TEXTURE_2D, glTextureId);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -228,11 +495,15 @@ GLuint SpriteSheet::getOrUploadGLTexture() {
 	}
 
 	glBindTexture(GL_TEXTURE_2D, 0);
-	data.reset();
+	releaseData();
+	if (glTextureId != 0) {
+		g_residency.track(textureResidency, ResidencyKind::SheetTexture, static_cast<size_t>(SPRITE_SHEET_WIDTH) * SPRITE_SHEET_HEIGHT * 4, this, evictSheetTexture);
+	}
 	return glTextureId;
 }
 
 void SpriteSheet::releaseGLTexture() {
+	g_residency.release(textureResidency);
 	if (glTextureId != 0) {
 		GLRenderer::invalidateTexture(glTextureId);
 		glDeleteTextures(1, &glTextureId);
@@ -259,7 +530,7 @@ SpriteUV SpriteSheet::getSpriteUVs(int spriteId) const {
 }
 
 SpriteAppearances::AtlasInfo SpriteAppearances::getAtlasInfo(int spriteId) {
-	auto sheet = getSheetBySpriteId(spriteId);
+	const SpriteSheetPtr &sheet = getSheetBySpriteId(spriteId);
 	if (!sheet) {
 		return { 0, { 0, 0, 1, 1 } };
 	}
@@ -268,20 +539,15 @@ SpriteAppearances::AtlasInfo SpriteAppearances::getAtlasInfo(int spriteId) {
 	return { texId, uvs };
 }
 
-SpriteSheetPtr SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true */) {
-	if (id == 0) {
-		return nullptr;
-	}
+const SpriteSheetPtr &SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true */) {
+	static const SpriteSheetPtr none;
 
-	auto sheetIt = std::lower_bound(sheets.begin(), sheets.end(), id, [](const SpriteSheetPtr &sheet, int spriteId) {
-		return sheet->lastId < spriteId;
-	});
-
-	if (sheetIt == sheets.end() || id < (*sheetIt)->firstId) {
-		return nullptr;
+	const SpriteLocation* location = getSpriteLocation(id);
+	if (!location) {
+		return none;
 	}
 
-	const SpriteSheetPtr &sheet = *sheetIt;
+	const SpriteSheetPtr &sheet = sheets[location->sheet - 1];
 	if (load && !sheet->loaded) {
 		loadSpriteSheet(sheet);
 	}
@@ -289,6 +555,13 @@ SpriteSheetPtr SpriteAppearances::getSheetBySpriteId(int id, bool load /* = true
 	return sheet;
 }
 
+void SpriteAppearances::prefetchSprite(int spriteId) {
+	const SpriteSheetPtr &sheet = getSheetBySpriteId(spriteId, false);
+	if (sheet && !sheet->data && sheet->glTextureId == 0) {
+		g_spriteDecodePool.request(sheet, true);
+	}
+}
+
 wxImage SpriteAppearances::getWxImageBySpriteId(int id, bool toSavePng /* = false*/) {
 	const auto &sprite = getSprite(id);
 	if (!sprite) {
@@ -408,6 +681,7 @@ SpritePtr SpriteAppearances::getSprite(int spriteId) {
 			return nullptr;
 		}
 	}
+	g_residency.touch(sheet->dataResidency);
 
 	// Update bufferSize based on actual sheet height
 	size_t bufferSize = SPRITE_SHEET_HEIGHT * SPRITE_SHEET_WIDTH_BYTES;
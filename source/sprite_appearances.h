@@ -21,7 +21,9 @@
 #include "definitions.h"
 #include "main.h"
 #include "graphics.h"
+#include "paged_table.h"
 #include <chrono>
+#include <span>
 
 class GameSprite;
 
@@ -95,6 +97,7 @@ class SpriteSheet {
 public:
 	SpriteSheet(int firstId, int lastId, SpriteLayout spriteLayout, const std::string &path) :
 		firstId(firstId), lastId(lastId), spriteLayout(spriteLayout), path(path) { }
+	~SpriteSheet();
 
 	SpritesSize getSpriteSize() const {
 		SpritesSize size(rme::SpritePixels, rme::SpritePixels);
@@ -146,6 +149,9 @@ public:
 
 	GLuint getOrUploadGLTexture();
 	void releaseGLTexture();
+	// Hands decoded pixels to the sheet and accounts them in g_residency
+	void setData(std::unique_ptr<uint8_t[]> pixels);
+	void releaseData();
 	SpriteUV getSpriteUVs(int spriteId) const;
 
 	int firstId = 0;
@@ -154,13 +160,53 @@ public:
 	std::unique_ptr<uint8_t[]> data;
 	std::string path;
 	bool loaded = false;
+	bool decodeQueued = false; // waiting in the decode pool
 	GLuint glTextureId = 0;
-	std::chrono::steady_clock::time_point lastaccess;
+	ResidencyNode dataResidency;
+	ResidencyNode textureResidency;
 };
 
 using SpritePtr = std::shared_ptr<Sprites>;
 using SpriteSheetPtr = std::shared_ptr<SpriteSheet>;
 
+// Where a sprite lives in the catalog, indexed by sprite id
+struct SpriteLocation {
+	uint32_t sheet = 0; // index into the sheet list plus one, 0 if the id is not in the catalog
+	uint8_t width = 0;
+	uint8_t height = 0;
+
+	bool isValid() const noexcept {
+		return sheet != 0;
+	}
+};
+
+struct SpriteSheetBenchmark {
+	size_t sheets = 0;
+	size_t failed = 0;
+	uint64_t file_bytes = 0;
+	uint64_t decoded_bytes = 0;
+	// One thread, reading and decoding timed separately
+	double read_ms = 0.0;
+	double decode_ms = 0.0;
+	// Reading and decoding every sheet on all threads
+	unsigned int threads = 0;
+	double parallel_ms = 0.0;
+	bool cancelled = false;
+};
+
+// Per-blit lookup cost of an image and its sheet for a set of sampled ids:
+// ordered map plus binary search over the sheets, against the flat tables
+struct SpriteLookupBenchmark {
+	size_t samples = 0;
+	size_t skipped = 0; // sampled ids without a valid location
+	size_t lookups = 0;
+	double tree_ns = 0.0;
+	double table_ns = 0.0;
+	size_t tree_bytes = 0;
+	size_t table_bytes = 0;
+	bool consistent = false; // both structures resolved every id the same way
+};
+
 //@bindsingleton g_spriteAppearances
 class SpriteAppearances {
 public:
@@ -200,6 +246,15 @@ public:
 
 	bool loadCatalogContent(const std::string &dir, bool loadData = true);
 	bool loadSpriteSheet(const SpriteSheetPtr &sheet);
+	// Reads and decodes a sheet file into BGRA pixels; safe to call from any thread
+	static std::unique_ptr<uint8_t[]> decodeSpriteSheet(const std::string &path);
+	static std::unique_ptr<uint8_t[]> decodeSpriteSheet(std::span<const uint8_t> file);
+	static bool readSpriteSheetFile(const std::string &path, std::vector<uint8_t> &buffer);
+	// Decodes sheets on all cores until maxBytes of sheet data is resident
+	size_t preloadSpriteSheets(size_t maxBytes);
+	SpriteSheetBenchmark benchmarkSpriteSheets();
+	// Queues the sheet holding the sprite for background decoding
+	void prefetchSprite(int spriteId);
 	void saveSheetToFileBySprite(int id, const std::string &file);
 	void saveSheetToFile(const SpriteSheetPtr &sheet, const std::string &file);
 	struct AtlasInfo {
@@ -207,20 +262,27 @@ public:
 		SpriteUV uvs;
 	};
 	AtlasInfo getAtlasInfo(int spriteId);
-	SpriteSheetPtr getSheetBySpriteId(int id, bool load = true);
+	// Constant time; the returned pointer is empty for ids outside the catalog
+	const SpriteSheetPtr &getSheetBySpriteId(int id, bool load = true);
+	const SpriteLocation* getSpriteLocation(int id) const {
+		const SpriteLocation* location = id > 0 ? locations.find(id) : nullptr;
+		return location && location->isValid() ? location : nullptr;
+	}
 	std::vector<SpriteSheetPtr> &getSheets() {
 		return sheets;
 	}
 
-	void addSpriteSheet(SpriteSheetPtr sheet) {
-		sheets.push_back(sheet);
-	}
+	void addSpriteSheet(SpriteSheetPtr sheet);
+	SpriteLookupBenchmark benchmarkSpriteLookups(size_t samples);
 
 	void saveSpriteToFile(int id, const std::string &file);
 
 private:
 	int spritesCount = 0;
+	void indexSpriteSheet(size_t index);
+
 	std::vector<SpriteSheetPtr> sheets;
+	PagedTable<SpriteLocation> locations;
 	std::map<int, SpritePtr> sprites;
 	std::string appearanceFile;
 };
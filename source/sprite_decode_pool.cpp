@@ -0,0 +1,202 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "sprite_decode_pool.h"
+
+#include "sprite_appearances.h"
+#include "sprite_sheet_cache.h"
+#include "gui.h"
+#include "gl_renderer.h"
+
+#include <algorithm>
+
+SpriteDecodePool g_spriteDecodePool;
+
+SpriteDecodePool::~SpriteDecodePool() {
+	stop();
+}
+
+void SpriteDecodePool::start(unsigned int threads /* = 0 */) {
+	if (!workers.empty()) {
+		return;
+	}
+
+	if (threads == 0) {
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threads = std::clamp(hardwareThreads / 2, 1u, 4u);
+	}
+
+	workers.reserve(threads);
+	for (unsigned int i = 0; i < threads; ++i) {
+		workers.emplace_back([this](std::stop_token stop) {
+			run(stop);
+		});
+	}
+}
+
+void SpriteDecodePool::stop() {
+	for (std::jthread &worker : workers) {
+		worker.request_stop();
+	}
+	wake.notify_all();
+	workers.clear();
+
+	std::scoped_lock lock(mutex);
+	for (const Job &job : queue) {
+		job.sheet->decodeQueued = false;
+	}
+	for (const Result &result : finished) {
+		result.sheet->decodeQueued = false;
+	}
+	queue.clear();
+	finished.clear();
+	in_flight = 0;
+}
+
+void SpriteDecodePool::clear() {
+	std::scoped_lock lock(mutex);
+	// Dropped sheets must be requested again; sheets still in a worker come back through collect()
+	for (const Job &job : queue) {
+		job.sheet->decodeQueued = false;
+	}
+	for (const Result &result : finished) {
+		result.sheet->decodeQueued = false;
+	}
+	queue.clear();
+	finished.clear();
+}
+
+void SpriteDecodePool::request(const SpriteSheetPtr &sheet, bool prefetch /* = false */) {
+	if (!sheet || sheet->data || sheet->glTextureId != 0) {
+		return;
+	}
+
+	// Without workers (or before startup) fall back to decoding in place; one-shot
+	// renders do the same, even for sheets a worker is already decoding
+	if (workers.empty() || (synchronous > 0 && !prefetch)) {
+		g_spriteAppearances.loadSpriteSheet(sheet);
+		return;
+	}
+	if (sheet->decodeQueued) {
+		return;
+	}
+
+	{
+		std::scoped_lock lock(mutex);
+		if (prefetch) {
+			if (queue.size() >= MaxQueuedPrefetches) {
+				return;
+			}
+			queue.push_back({ sheet, Clock::now() });
+		} else {
+			queue.push_front({ sheet, Clock::now() });
+		}
+	}
+	sheet->decodeQueued = true;
+	wake.notify_one();
+}
+
+size_t SpriteDecodePool::collect() {
+	refresh_pending = false;
+
+	std::vector<Result> results;
+	{
+		std::scoped_lock lock(mutex);
+		results.swap(finished);
+	}
+
+	const auto now = Clock::now();
+	size_t arrived = 0;
+	for (Result &result : results) {
+		SpriteSheetPtr &sheet = result.sheet;
+		sheet->decodeQueued = false;
+
+		if (!result.data) {
+			++stats.failed;
+			continue;
+		}
+
+		const double latency = std::chrono::duration<double, std::milli>(now - result.requested).count();
+		++stats.decoded;
+		stats.last_latency_ms = latency;
+		stats.max_latency_ms = std::max(stats.max_latency_ms, latency);
+		total_latency_ms += latency;
+		total_decode_ms += result.decode_ms;
+
+		// A synchronous load may have beaten the worker to it
+		if (sheet->data || sheet->glTextureId != 0) {
+			continue;
+		}
+		sheet->setData(std::move(result.data));
+		sheet->loaded = true;
+		++arrived;
+	}
+
+	// Cached recordings drew the sheets that were still pending as blanks
+	if (arrived > 0) {
+		GLRenderer::invalidateRecordings();
+	}
+
+	if (stats.decoded > 0) {
+		stats.average_latency_ms = total_latency_ms / stats.decoded;
+		stats.average_decode_ms = total_decode_ms / stats.decoded;
+	}
+	return arrived;
+}
+
+SpriteDecodeStats SpriteDecodePool::getStats() const {
+	std::scoped_lock lock(mutex);
+	SpriteDecodeStats current = stats;
+	current.queue_depth = queue.size();
+	current.in_flight = in_flight;
+	return current;
+}
+
+void SpriteDecodePool::run(std::stop_token stop) {
+	while (!stop.stop_requested()) {
+		Job job;
+		{
+			std::unique_lock lock(mutex);
+			if (!wake.wait(lock, stop, [this] { return !queue.empty(); })) {
+				return;
+			}
+			job = std::move(queue.front());
+			queue.pop_front();
+			++in_flight;
+		}
+
+		const auto start = Clock::now();
+		std::unique_ptr<uint8_t[]> data = g_spriteSheetCache.load(*job.sheet);
+		const double decode_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		{
+			std::scoped_lock lock(mutex);
+			--in_flight;
+			finished.push_back({ std::move(job.sheet), std::move(data), job.requested, decode_ms });
+		}
+
+		// One hand-over per batch; the main thread resets the flag when it collects
+		if (!refresh_pending.exchange(true)) {
+			wxTheApp->CallAfter([]() {
+				if (g_spriteDecodePool.collect() > 0) {
+					g_gui.RefreshView();
+				}
+			});
+		}
+	}
+}
@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_DECODE_POOL_H_
+#define RME_SPRITE_DECODE_POOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+class SpriteSheet;
+using SpriteSheetPtr = std::shared_ptr<SpriteSheet>;
+
+struct SpriteDecodeStats {
+	size_t queue_depth = 0;
+	size_t in_flight = 0;
+	uint64_t decoded = 0;
+	uint64_t failed = 0;
+	double last_latency_ms = 0.0; // from request until the sheet was handed to the renderer
+	double average_latency_ms = 0.0;
+	double max_latency_ms = 0.0;
+	double average_decode_ms = 0.0; // time spent in the worker only
+};
+
+// Decodes sprite sheets on worker threads so the render thread never waits
+// on LZMA. Sheets are requested and handed over on the main thread only;
+// workers touch nothing but the sheet path and their own output buffer.
+class SpriteDecodePool {
+public:
+	// While alive, requested sheets are decoded in place on the main thread,
+	// for one-shot renders such as screenshots that can not wait for workers
+	class SynchronousScope {
+	public:
+		explicit SynchronousScope(SpriteDecodePool &pool) noexcept :
+			pool(pool) {
+			++pool.synchronous;
+		}
+		~SynchronousScope() {
+			--pool.synchronous;
+		}
+
+		SynchronousScope(const SynchronousScope &) = delete;
+		SynchronousScope &operator=(const SynchronousScope &) = delete;
+
+	private:
+		SpriteDecodePool &pool;
+	};
+
+	~SpriteDecodePool();
+
+	void start(unsigned int threads = 0);
+	void stop();
+	void clear();
+
+	// Queues the sheet unless it is already queued, decoded or uploaded.
+	// Prefetches go behind the sheets the current frame is waiting for.
+	// Without workers or inside a SynchronousScope the sheet is decoded in place.
+	void request(const SpriteSheetPtr &sheet, bool prefetch = false);
+	// Moves finished sheets into place; returns how many arrived.
+	size_t collect();
+
+	SpriteDecodeStats getStats() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr size_t MaxQueuedPrefetches = 512;
+
+	struct Job {
+		SpriteSheetPtr sheet;
+		Clock::time_point requested;
+	};
+
+	struct Result {
+		SpriteSheetPtr sheet;
+		std::unique_ptr<uint8_t[]> data;
+		Clock::time_point requested;
+		double decode_ms;
+	};
+
+	void run(std::stop_token stop);
+
+	mutable std::mutex mutex;
+	std::condition_variable_any wake;
+	std::deque<Job> queue;
+	std::vector<Result> finished;
+	std::vector<std::jthread> workers;
+	size_t in_flight = 0;
+	std::atomic_bool refresh_pending = false;
+	int synchronous = 0; // open SynchronousScopes, main thread only
+
+	SpriteDecodeStats stats;
+	double total_latency_ms = 0.0;
+	double total_decode_ms = 0.0;
+};
+
+extern SpriteDecodePool g_spriteDecodePool;
+
+#endif
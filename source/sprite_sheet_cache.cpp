@@ -0,0 +1,235 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "sprite_sheet_cache.h"
+#include "sprite_appearances.h"
+
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+
+SpriteSheetCache g_spriteSheetCache;
+
+namespace {
+	constexpr std::array<char, 4> EntryMagic { 'R', 'M', 'S', 'C' };
+	constexpr uint32_t EntryVersion = 1;
+	constexpr std::streamoff EntryDataOffset = 4096; // page aligned, so the pixels can be mapped directly
+	constexpr size_t EntryPixelBytes = BYTES_IN_SPRITE_SHEET;
+	constexpr std::string_view EntryExtension = ".sheet";
+
+	struct EntryHeader {
+		std::array<char, 4> magic {};
+		uint32_t version = 0;
+		int32_t firstId = 0;
+		int32_t lastId = 0;
+		uint32_t layout = 0;
+		uint32_t pixelBytes = 0;
+		uint64_t sourceSize = 0;
+		int64_t sourceTime = 0;
+		uint64_t sourceHash = 0;
+	};
+
+	bool matchesSheet(const EntryHeader &header, const SpriteSheet &sheet) {
+		return header.magic == EntryMagic
+			&& header.version == EntryVersion
+			&& header.firstId == sheet.firstId
+			&& header.lastId == sheet.lastId
+			&& header.layout == static_cast<uint32_t>(sheet.spriteLayout)
+			&& header.pixelBytes == EntryPixelBytes;
+	}
+}
+
+void SpriteSheetCache::configure(bool enabled, const std::filesystem::path &directory) {
+	std::scoped_lock lock(mutex);
+	this->directory = directory;
+	this->enabled = false;
+	if (!enabled) {
+		return;
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(directory, ec);
+	if (ec) {
+		spdlog::warn("[SpriteSheetCache] - Unable to create {}: {}", directory.string(), ec.message());
+		return;
+	}
+	this->enabled = true;
+}
+
+std::unique_ptr<uint8_t[]> SpriteSheetCache::load(const SpriteSheet &sheet) {
+	if (!enabled) {
+		return SpriteAppearances::decodeSpriteSheet(sheet.path);
+	}
+
+	const std::filesystem::path entry = getEntryPath(sheet);
+
+	std::error_code ec;
+	SourceStamp stamp;
+	stamp.size = std::filesystem::file_size(sheet.path, ec);
+	if (!ec) {
+		stamp.time = std::filesystem::last_write_time(sheet.path, ec).time_since_epoch().count();
+	}
+	if (!ec) {
+		if (auto pixels = read(entry, sheet, stamp, nullptr)) {
+			++hits;
+			return pixels;
+		}
+	}
+
+	std::vector<uint8_t> source;
+	if (!SpriteAppearances::readSpriteSheetFile(sheet.path, source)) {
+		spdlog::error("[SpriteSheetCache::load] - Unable to open {}", sheet.path);
+		return nullptr;
+	}
+
+	// Same content under a new timestamp, e.g. after the client was reinstalled
+	const uint64_t hash = hashSource(source);
+	if (auto pixels = read(entry, sheet, stamp, &hash)) {
+		++hits;
+		write(entry, sheet, stamp, hash, pixels.get());
+		return pixels;
+	}
+
+	++misses;
+	std::unique_ptr<uint8_t[]> pixels = SpriteAppearances::decodeSpriteSheet(source);
+	if (pixels) {
+		write(entry, sheet, stamp, hash, pixels.get());
+	}
+	return pixels;
+}
+
+void SpriteSheetCache::prune(const std::vector<SpriteSheetPtr> &sheets) {
+	if (!enabled) {
+		return;
+	}
+
+	std::unordered_set<std::string> expected;
+	expected.reserve(sheets.size());
+	for (const SpriteSheetPtr &sheet : sheets) {
+		expected.insert(getEntryPath(*sheet).filename().string());
+	}
+
+	std::filesystem::path root;
+	{
+		std::scoped_lock lock(mutex);
+		root = directory;
+	}
+
+	size_t removed = 0;
+	std::error_code ec;
+	for (const auto &file : std::filesystem::directory_iterator(root, ec)) {
+		const std::string name = file.path().filename().string();
+		if (!expected.contains(name)) {
+			std::error_code removeError;
+			removed += std::filesystem::remove(file.path(), removeError) ? 1 : 0;
+		}
+	}
+
+	if (removed > 0) {
+		spdlog::info("[SpriteSheetCache] - Removed {} stale cache entries", removed);
+	}
+}
+
+SpriteSheetCacheStats SpriteSheetCache::getStats() const {
+	return { hits.load(), misses.load(), writes.load() };
+}
+
+std::filesystem::path SpriteSheetCache::getEntryPath(const SpriteSheet &sheet) const {
+	std::scoped_lock lock(mutex);
+	return directory / (std::filesystem::path(sheet.path).filename().string() + std::string(EntryExtension));
+}
+
+std::unique_ptr<uint8_t[]> SpriteSheetCache::read(const std::filesystem::path &entry, const SpriteSheet &sheet, const SourceStamp &stamp, const uint64_t* hash) const {
+	std::ifstream file(entry, std::ios::binary | std::ios::in);
+	if (!file.is_open()) {
+		return nullptr;
+	}
+
+	EntryHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !matchesSheet(header, sheet)) {
+		return nullptr;
+	}
+
+	if (hash ? header.sourceHash != *hash : header.sourceSize != stamp.size || header.sourceTime != stamp.time) {
+		return nullptr;
+	}
+
+	// Sized like a freshly decoded sheet so the buffers are interchangeable
+	std::unique_ptr<uint8_t[]> pixels = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
+	file.seekg(EntryDataOffset);
+	if (!file.read(reinterpret_cast<char*>(pixels.get()), EntryPixelBytes)) {
+		return nullptr;
+	}
+	return pixels;
+}
+
+void SpriteSheetCache::write(const std::filesystem::path &entry, const SpriteSheet &sheet, const SourceStamp &stamp, uint64_t hash, const uint8_t* pixels) {
+	EntryHeader header;
+	header.magic = EntryMagic;
+	header.version = EntryVersion;
+	header.firstId = sheet.firstId;
+	header.lastId = sheet.lastId;
+	header.layout = static_cast<uint32_t>(sheet.spriteLayout);
+	header.pixelBytes = EntryPixelBytes;
+	header.sourceSize = stamp.size;
+	header.sourceTime = stamp.time;
+	header.sourceHash = hash;
+
+	// Written aside and renamed, so readers never see a partial entry
+	std::filesystem::path temporary = entry;
+	temporary += std::format(".{}.tmp", std::hash<std::thread::id> {}(std::this_thread::get_id()));
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::out | std::ios::trunc);
+		if (!file.is_open()) {
+			return;
+		}
+
+		std::array<char, EntryDataOffset> block {};
+		std::memcpy(block.data(), &header, sizeof(header));
+		file.write(block.data(), block.size());
+		file.write(reinterpret_cast<const char*>(pixels), EntryPixelBytes);
+		if (!file.good()) {
+			file.close();
+			std::error_code ec;
+			std::filesystem::remove(temporary, ec);
+			return;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(temporary, entry, ec);
+	if (ec) {
+		std::filesystem::remove(temporary, ec);
+		return;
+	}
+	++writes;
+}
+
+uint64_t SpriteSheetCache::hashSource(std::span<const uint8_t> source) noexcept {
+	// FNV-1a; only needs to tell asset revisions apart
+	uint64_t hash = 14695981039346656037ull;
+	for (const uint8_t byte : source) {
+		hash ^= byte;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_SHEET_CACHE_H_
+#define RME_SPRITE_SHEET_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+class SpriteSheet;
+using SpriteSheetPtr = std::shared_ptr<SpriteSheet>;
+
+struct SpriteSheetCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t writes = 0;
+};
+
+// Keeps decoded sprite sheets on disk so later sessions skip the LZMA work.
+// Each entry is named after its catalog file and stores the raw BGRA pixels
+// at a page-aligned offset behind a header carrying the catalog key and the
+// size, modification time and hash of the source file. An entry is trusted
+// when size and time still match; otherwise the source is hashed, and the
+// entry is rewritten if the content changed. Safe to use from any thread.
+class SpriteSheetCache {
+public:
+	void configure(bool enabled, const std::filesystem::path &directory);
+	bool isEnabled() const noexcept {
+		return enabled;
+	}
+
+	// Decoded pixels of the sheet, from the cache when possible
+	std::unique_ptr<uint8_t[]> load(const SpriteSheet &sheet);
+
+	// Deletes entries that no longer belong to any sheet of the catalog
+	void prune(const std::vector<SpriteSheetPtr> &sheets);
+
+	SpriteSheetCacheStats getStats() const;
+
+private:
+	struct SourceStamp {
+		uint64_t size = 0;
+		int64_t time = 0;
+	};
+
+	std::filesystem::path getEntryPath(const SpriteSheet &sheet) const;
+	std::unique_ptr<uint8_t[]> read(const std::filesystem::path &entry, const SpriteSheet &sheet, const SourceStamp &stamp, const uint64_t* hash) const;
+	void write(const std::filesystem::path &entry, const SpriteSheet &sheet, const SourceStamp &stamp, uint64_t hash, const uint8_t* pixels);
+
+	static uint64_t hashSource(std::span<const uint8_t> source) noexcept;
+
+	std::atomic<bool> enabled = false;
+	mutable std::mutex mutex;
+	std::filesystem::path directory;
+
+	std::atomic<uint64_t> hits = 0;
+	std::atomic<uint64_t> misses = 0;
+	std::atomic<uint64_t> writes = 0;
+};
+
+extern SpriteSheetCache g_spriteSheetCache;
+
+#endif
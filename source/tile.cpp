@@ -864,6 +864,70 @@ void Tile::deselectGround() {
 	}
 }
 
+std::vector<bool> Tile::getSelectionState() const {
+	std::vector<bool> state;
+	state.reserve((ground ? 1 : 0) + items.size() + monsters.size() + 3);
+	if (ground) {
+		state.push_back(ground->isSelected());
+	}
+	for (const Item* item : items) {
+		state.push_back(item->isSelected());
+	}
+	for (const auto monster : monsters) {
+		state.push_back(monster->isSelected());
+	}
+	if (npc) {
+		state.push_back(npc->isSelected());
+	}
+	if (spawnMonster) {
+		state.push_back(spawnMonster->isSelected());
+	}
+	if (spawnNpc) {
+		state.push_back(spawnNpc->isSelected());
+	}
+	return state;
+}
+
+void Tile::setSelectionState(const std::vector<bool> &state) {
+	size_t index = 0;
+	bool any = false;
+	const auto apply = [&](auto* thing) {
+		const bool selected = index < state.size() && state[index];
+		++index;
+		if (selected) {
+			thing->select();
+			any = true;
+		} else {
+			thing->deselect();
+		}
+	};
+
+	if (ground) {
+		apply(ground);
+	}
+	for (Item* item : items) {
+		apply(item);
+	}
+	for (const auto monster : monsters) {
+		apply(monster);
+	}
+	if (npc) {
+		apply(npc);
+	}
+	if (spawnMonster) {
+		apply(spawnMonster);
+	}
+	if (spawnNpc) {
+		apply(spawnNpc);
+	}
+
+	if (any) {
+		statflags |= TILESTATE_SELECTED;
+	} else {
+		statflags &= ~TILESTATE_SELECTED;
+	}
+}
+
 void Tile::setHouse(House* house) {
 	house_id = (house ? house->id : 0);
 }
@@ -184,6 +184,11 @@ public: // Functions
 	void selectGround();
 	void deselectGround();
 
+	// One selected bit per thing on the tile: ground, items, monsters, npc, monster spawn, npc spawn
+	std::vector<bool> getSelectionState() const;
+	// Applies a state read by getSelectionState; things past its end are deselected
+	void setSelectionState(const std::vector<bool> &state);
+
 	bool isSelected() const {
 		return testFlags(statflags, TILESTATE_SELECTED);
 	}
@@ -0,0 +1,307 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "tile_record.h"
+
+#include "basemap.h"
+#include "tile.h"
+#include "complexitem.h"
+#include "monster.h"
+#include "npc.h"
+#include "spawn_monster.h"
+#include "spawn_npc.h"
+
+namespace {
+	enum TileRecordItemKind : uint8_t {
+		TILE_RECORD_ITEM_PLAIN,
+		TILE_RECORD_ITEM_CONTAINER,
+		TILE_RECORD_ITEM_TELEPORT,
+		TILE_RECORD_ITEM_DOOR,
+		TILE_RECORD_ITEM_DEPOT,
+	};
+}
+
+void TileRecordWriter::putString(const std::string &value) {
+	put<uint32_t>(static_cast<uint32_t>(value.size()));
+	buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+void TileRecordWriter::putPosition(const Position &position) {
+	put<int32_t>(position.x);
+	put<int32_t>(position.y);
+	put<int32_t>(position.z);
+}
+
+void TileRecordWriter::putItem(const Item* item) {
+	if (!item) {
+		put<uint16_t>(0);
+		return;
+	}
+
+	put<uint16_t>(item->getID());
+	put<uint16_t>(item->getSubtype());
+	put<uint8_t>(item->isSelected());
+
+	if (const auto container = dynamic_cast<const Container*>(item)) {
+		put<uint8_t>(TILE_RECORD_ITEM_CONTAINER);
+		put<uint32_t>(static_cast<uint32_t>(container->getItemCount()));
+		for (size_t i = 0; i < container->getItemCount(); ++i) {
+			putItem(container->getItem(i));
+		}
+	} else if (const auto teleport = dynamic_cast<const Teleport*>(item)) {
+		put<uint8_t>(TILE_RECORD_ITEM_TELEPORT);
+		putPosition(teleport->getDestination());
+	} else if (const auto door = dynamic_cast<const Door*>(item)) {
+		put<uint8_t>(TILE_RECORD_ITEM_DOOR);
+		put<uint8_t>(door->getDoorID());
+	} else if (const auto depot = dynamic_cast<const Depot*>(item)) {
+		put<uint8_t>(TILE_RECORD_ITEM_DEPOT);
+		put<uint8_t>(depot->getDepotID());
+	} else {
+		put<uint8_t>(TILE_RECORD_ITEM_PLAIN);
+	}
+
+	const ItemAttributeMap attributes = item->getAttributes();
+	put<uint32_t>(static_cast<uint32_t>(attributes.size()));
+	for (const auto &[key, attribute] : attributes) {
+		putString(key);
+		put<uint8_t>(static_cast<uint8_t>(attribute.type));
+		if (const std::string* value = attribute.getString()) {
+			putString(*value);
+		} else if (const int32_t* value = attribute.getInteger()) {
+			put<int32_t>(*value);
+		} else if (const double* value = attribute.getFloat()) {
+			put<double>(*value);
+		} else if (const bool* value = attribute.getBoolean()) {
+			put<uint8_t>(*value);
+		}
+	}
+}
+
+void TileRecordWriter::putTile(const Tile* tile) {
+	putPosition(tile->getPosition());
+	put<uint32_t>(tile->house_id);
+	put<uint16_t>(tile->getMapFlags());
+	put<uint16_t>(tile->getStatFlags());
+
+	putItem(tile->ground);
+	put<uint32_t>(static_cast<uint32_t>(tile->items.size()));
+	for (const Item* item : tile->items) {
+		putItem(item);
+	}
+
+	put<uint32_t>(static_cast<uint32_t>(tile->monsters.size()));
+	for (const Monster* monster : tile->monsters) {
+		putString(monster->getTypeName());
+		put<uint8_t>(static_cast<uint8_t>(monster->getDirection()));
+		put<uint8_t>(static_cast<uint8_t>(monster->getWeight()));
+		put<uint16_t>(monster->getSpawnMonsterTime());
+		put<uint8_t>(monster->isSelected());
+	}
+
+	put<uint8_t>(tile->npc != nullptr);
+	if (tile->npc) {
+		putString(tile->npc->getTypeName());
+		put<uint8_t>(static_cast<uint8_t>(tile->npc->getDirection()));
+		put<int32_t>(tile->npc->getSpawnNpcTime());
+		put<uint8_t>(tile->npc->isSelected());
+	}
+
+	put<uint8_t>(tile->spawnMonster != nullptr);
+	if (tile->spawnMonster) {
+		put<int32_t>(tile->spawnMonster->getSize());
+		put<uint8_t>(tile->spawnMonster->isSelected());
+	}
+
+	put<uint8_t>(tile->spawnNpc != nullptr);
+	if (tile->spawnNpc) {
+		put<int32_t>(tile->spawnNpc->getSize());
+		put<uint8_t>(tile->spawnNpc->isSelected());
+	}
+
+	put<uint32_t>(static_cast<uint32_t>(tile->zones.size()));
+	for (const unsigned int zone : tile->zones) {
+		put<uint32_t>(zone);
+	}
+}
+
+std::string TileRecordReader::getString() {
+	const uint32_t size = get<uint32_t>();
+	if (failed || buffer.size() - position < size) {
+		failed = true;
+		return {};
+	}
+	std::string value(reinterpret_cast<const char*>(buffer.data() + position), size);
+	position += size;
+	return value;
+}
+
+Position TileRecordReader::getPosition() {
+	const int32_t x = get<int32_t>();
+	const int32_t y = get<int32_t>();
+	const int32_t z = get<int32_t>();
+	return Position(x, y, z);
+}
+
+Item* TileRecordReader::getItem() {
+	const uint16_t id = get<uint16_t>();
+	if (id == 0 || failed) {
+		return nullptr;
+	}
+
+	const uint16_t subtype = get<uint16_t>();
+	const bool selected = get<uint8_t>() != 0;
+	Item* item = Item::Create(id, subtype);
+
+	switch (get<uint8_t>()) {
+		case TILE_RECORD_ITEM_CONTAINER: {
+			const uint32_t count = get<uint32_t>();
+			Container* container = item ? item->getContainer() : nullptr;
+			for (uint32_t i = 0; i < count && !failed; ++i) {
+				Item* content = getItem();
+				if (container && content) {
+					container->getVector().push_back(content);
+				} else {
+					delete content;
+				}
+			}
+			break;
+		}
+		case TILE_RECORD_ITEM_TELEPORT: {
+			const Position destination = getPosition();
+			if (Teleport* teleport = item ? item->getTeleport() : nullptr) {
+				teleport->setDestination(destination);
+			}
+			break;
+		}
+		case TILE_RECORD_ITEM_DOOR: {
+			const uint8_t doorId = get<uint8_t>();
+			if (Door* door = item ? item->getDoor() : nullptr) {
+				door->setDoorID(doorId);
+			}
+			break;
+		}
+		case TILE_RECORD_ITEM_DEPOT: {
+			const uint8_t depotId = get<uint8_t>();
+			if (Depot* depot = item ? item->getDepot() : nullptr) {
+				depot->setDepotID(depotId);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+
+	// The setters above add attributes of their own, the recorded map replaces them
+	if (item) {
+		item->clearAllAttributes();
+		if (selected) {
+			item->select();
+		} else {
+			item->deselect();
+		}
+	}
+
+	const uint32_t count = get<uint32_t>();
+	for (uint32_t i = 0; i < count && !failed; ++i) {
+		const std::string key = getString();
+		ItemAttribute attribute;
+		switch (get<uint8_t>()) {
+			case ItemAttribute::STRING:
+				attribute.set(getString());
+				break;
+			case ItemAttribute::INTEGER:
+				attribute.set(get<int32_t>());
+				break;
+			case ItemAttribute::FLOAT:
+			case ItemAttribute::DOUBLE:
+				attribute.set(get<double>());
+				break;
+			case ItemAttribute::BOOLEAN:
+				attribute.set(get<uint8_t>() != 0);
+				break;
+			default:
+				break;
+		}
+		if (item) {
+			item->setAttribute(key, attribute);
+		}
+	}
+	return item;
+}
+
+Tile* TileRecordReader::getTile() {
+	const Position position = getPosition();
+	if (failed) {
+		return nullptr;
+	}
+
+	Tile* tile = map.allocator.allocateTile(map.createTileL(position));
+	tile->house_id = get<uint32_t>();
+	tile->setMapFlags(get<uint16_t>());
+	tile->setStatFlags(get<uint16_t>());
+
+	tile->ground = getItem();
+	const uint32_t items = get<uint32_t>();
+	for (uint32_t i = 0; i < items && !failed; ++i) {
+		if (Item* item = getItem()) {
+			tile->items.push_back(item);
+		}
+	}
+
+	const uint32_t monsters = get<uint32_t>();
+	for (uint32_t i = 0; i < monsters && !failed; ++i) {
+		Monster* monster = new Monster(getString());
+		monster->setDirection(static_cast<Direction>(get<uint8_t>()));
+		monster->setWeight(get<uint8_t>());
+		monster->setSpawnMonsterTime(get<uint16_t>());
+		if (get<uint8_t>()) {
+			monster->select();
+		}
+		tile->monsters.push_back(monster);
+	}
+
+	if (get<uint8_t>()) {
+		tile->npc = new Npc(getString());
+		tile->npc->setDirection(static_cast<Direction>(get<uint8_t>()));
+		tile->npc->setSpawnNpcTime(get<int32_t>());
+		if (get<uint8_t>()) {
+			tile->npc->select();
+		}
+	}
+
+	if (get<uint8_t>()) {
+		tile->spawnMonster = new SpawnMonster(get<int32_t>());
+		if (get<uint8_t>()) {
+			tile->spawnMonster->select();
+		}
+	}
+
+	if (get<uint8_t>()) {
+		tile->spawnNpc = new SpawnNpc(get<int32_t>());
+		if (get<uint8_t>()) {
+			tile->spawnNpc->select();
+		}
+	}
+
+	const uint32_t zones = get<uint32_t>();
+	for (uint32_t i = 0; i < zones && !failed; ++i) {
+		tile->zones.insert(get<uint32_t>());
+	}
+	return tile;
+}
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_TILE_RECORD_H_
+#define RME_TILE_RECORD_H_
+
+#include "position.h"
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+class BaseMap;
+class Item;
+class Tile;
+
+// Compact binary form of tiles, shared by the undo spill file and the edit
+// journal. A record holds everything Tile::deepCopy carries over, plus the
+// selection and modification flags, in native byte order: the records never
+// leave the machine that wrote them.
+class TileRecordWriter {
+public:
+	template <typename T>
+	void put(T value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const size_t offset = buffer.size();
+		buffer.resize(offset + sizeof(T));
+		std::memcpy(buffer.data() + offset, &value, sizeof(T));
+	}
+
+	void putString(const std::string &value);
+	void putPosition(const Position &position);
+	void putItem(const Item* item);
+	void putTile(const Tile* tile);
+
+	std::vector<uint8_t> &data() noexcept {
+		return buffer;
+	}
+
+private:
+	std::vector<uint8_t> buffer;
+};
+
+// Reads what TileRecordWriter wrote; a read past the end marks the stream as
+// failed and returns zeroes from then on, so callers check ok() once at the end
+class TileRecordReader {
+public:
+	TileRecordReader(BaseMap &map, const std::vector<uint8_t> &buffer) :
+		map(map), buffer(buffer) { }
+
+	bool ok() const noexcept {
+		return !failed;
+	}
+	bool finished() const noexcept {
+		return position == buffer.size();
+	}
+
+	template <typename T>
+	T get() {
+		T value {};
+		if (failed || buffer.size() - position < sizeof(T)) {
+			failed = true;
+			return value;
+		}
+		std::memcpy(&value, buffer.data() + position, sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+
+	std::string getString();
+	Position getPosition();
+	// May return nullptr for a valid record, like Item::deepCopy does for items without a sprite
+	Item* getItem();
+	// The tile is allocated on its location of the map, but not placed on it
+	Tile* getTile();
+
+private:
+	BaseMap &map;
+	const std::vector<uint8_t> &buffer;
+	size_t position = 0;
+	bool failed = false;
+};
+
+#endif
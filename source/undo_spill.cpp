@@ -0,0 +1,340 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "undo_spill.h"
+
+#include "action.h"
+#include "editor.h"
+#include "map.h"
+#include "tile_record.h"
+
+#include <chrono>
+#include <format>
+#include <zlib.h>
+
+namespace {
+	// Deflate level for spilled batches; spills happen while the user edits, so speed wins
+	constexpr int SpillCompressLevel = Z_BEST_SPEED;
+
+	double secondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+UndoSpillFile::~UndoSpillFile() {
+	close();
+}
+
+bool UndoSpillFile::open() {
+	if (file.is_open()) {
+		return true;
+	}
+
+	std::error_code ec;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path(ec);
+	if (ec) {
+		spdlog::error("[UndoSpillFile] - No temporary directory: {}", ec.message());
+		return false;
+	}
+
+	path = directory / std::format("rme-undo-{}-{:x}.tmp", wxGetProcessId(), reinterpret_cast<uintptr_t>(this));
+	file.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		spdlog::error("[UndoSpillFile] - Unable to create {}", path.string());
+		return false;
+	}
+
+	end = 0;
+	return true;
+}
+
+void UndoSpillFile::close() {
+	if (!file.is_open()) {
+		return;
+	}
+
+	file.close();
+	std::error_code ec;
+	std::filesystem::remove(path, ec);
+	end = 0;
+	free_ranges.clear();
+	stats.records = 0;
+	stats.live_bytes = 0;
+	stats.file_size = 0;
+}
+
+uint64_t UndoSpillFile::allocate(uint32_t size) {
+	// First fit in the released ranges, the file only grows when none is large enough
+	for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+		if (it->second < size) {
+			continue;
+		}
+		const uint64_t offset = it->first;
+		const uint64_t remaining = it->second - size;
+		free_ranges.erase(it);
+		if (remaining > 0) {
+			free_ranges.emplace(offset + size, remaining);
+		}
+		return offset;
+	}
+	return end;
+}
+
+bool UndoSpillFile::spill(BatchAction &batch) {
+	if (batch.spill_record || !open()) {
+		return false;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	TileRecordWriter writer;
+	UndoSpillRecord record;
+	writer.put<uint32_t>(static_cast<uint32_t>(batch.batch.size()));
+	for (const Action* action : batch.batch) {
+		writer.put<uint8_t>(action->isCommited());
+		writer.put<uint32_t>(static_cast<uint32_t>(action->changes.size()));
+		record.changes += static_cast<uint32_t>(action->changes.size());
+
+		for (const Change* change : action->changes) {
+			writer.put<uint8_t>(static_cast<uint8_t>(change->getType()));
+			switch (change->getType()) {
+				case CHANGE_TILE:
+					writer.putTile(reinterpret_cast<const Tile*>(change->getData()));
+					break;
+				case CHANGE_TILE_DELTA: {
+					const TileDelta* delta = reinterpret_cast<const TileDelta*>(change->getData());
+					writer.putTile(delta->tile);
+					writer.put<uint32_t>(delta->shared_hash);
+					writer.put<uint32_t>(delta->full_size);
+					writer.put<uint16_t>(delta->shared_front);
+					writer.put<uint16_t>(delta->shared_back);
+					writer.put<uint8_t>(delta->shared_ground);
+					break;
+				}
+				case CHANGE_MOVE_HOUSE_EXIT: {
+					const HouseData* data = reinterpret_cast<const HouseData*>(change->getData());
+					writer.put<uint32_t>(data->id);
+					writer.putPosition(data->position);
+					break;
+				}
+				case CHANGE_MOVE_WAYPOINT: {
+					const WaypointData* data = reinterpret_cast<const WaypointData*>(change->getData());
+					writer.putString(data->id);
+					writer.putPosition(data->position);
+					break;
+				}
+				case CHANGE_SELECTION: {
+					const SelectionData* data = reinterpret_cast<const SelectionData*>(change->getData());
+					writer.putPosition(data->position);
+					writer.put<uint32_t>(static_cast<uint32_t>(data->state.size()));
+					for (const bool selected : data->state) {
+						writer.put<uint8_t>(selected);
+					}
+					break;
+				}
+				default:
+					break;
+			}
+		}
+	}
+
+	const std::vector<uint8_t> &raw = writer.data();
+	uLongf stored_size = compressBound(static_cast<uLong>(raw.size()));
+	std::vector<uint8_t> stored(stored_size);
+	if (compress2(stored.data(), &stored_size, raw.data(), static_cast<uLong>(raw.size()), SpillCompressLevel) != Z_OK) {
+		spdlog::error("[UndoSpillFile::spill] - Unable to compress {} bytes of undo history", raw.size());
+		return false;
+	}
+
+	record.offset = allocate(static_cast<uint32_t>(stored_size));
+	record.stored_size = static_cast<uint32_t>(stored_size);
+	record.raw_size = static_cast<uint32_t>(raw.size());
+	record.checksum = static_cast<uint32_t>(crc32(0, stored.data(), static_cast<uInt>(stored_size)));
+
+	file.clear();
+	file.seekp(static_cast<std::streamoff>(record.offset));
+	file.write(reinterpret_cast<const char*>(stored.data()), static_cast<std::streamsize>(stored_size));
+	if (!file.good()) {
+		spdlog::error("[UndoSpillFile::spill] - Unable to write to {}", path.string());
+		file.clear();
+		if (record.offset < end) {
+			reclaim(record.offset, record.stored_size);
+		}
+		return false;
+	}
+	end = std::max<uint64_t>(end, record.offset + record.stored_size);
+
+	for (Action* action : batch.batch) {
+		delete action;
+	}
+	batch.batch.clear();
+	batch.batch.shrink_to_fit();
+	batch.spill_record = record;
+
+	++stats.spilled;
+	++stats.records;
+	stats.live_bytes += record.stored_size;
+	stats.spilled_bytes += record.raw_size;
+	stats.stored_bytes += record.stored_size;
+	stats.spill_seconds += secondsSince(start);
+	stats.file_size = end;
+	return true;
+}
+
+bool UndoSpillFile::restore(BatchAction &batch, const ActionQueue &queue) {
+	if (!batch.spill_record || !file.is_open()) {
+		return false;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const UndoSpillRecord record = *batch.spill_record;
+
+	std::vector<uint8_t> stored(record.stored_size);
+	file.clear();
+	file.seekg(static_cast<std::streamoff>(record.offset));
+	file.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size()));
+	if (!file.good() || crc32(0, stored.data(), static_cast<uInt>(stored.size())) != record.checksum) {
+		spdlog::error("[UndoSpillFile::restore] - Undo history in {} is unreadable", path.string());
+		file.clear();
+		return false;
+	}
+
+	std::vector<uint8_t> raw(record.raw_size);
+	uLongf raw_size = record.raw_size;
+	if (uncompress(raw.data(), &raw_size, stored.data(), static_cast<uLong>(stored.size())) != Z_OK || raw_size != record.raw_size) {
+		spdlog::error("[UndoSpillFile::restore] - Undo history in {} is corrupted", path.string());
+		return false;
+	}
+
+	TileRecordReader reader(batch.editor.getMap(), raw);
+	ActionVector actions;
+	const uint32_t action_count = reader.get<uint32_t>();
+	for (uint32_t i = 0; i < action_count && reader.ok(); ++i) {
+		Action* action = queue.createAction(batch.getType());
+		actions.push_back(action);
+		action->commited = reader.get<uint8_t>() != 0;
+
+		const uint32_t change_count = reader.get<uint32_t>();
+		action->changes.reserve(change_count);
+		for (uint32_t j = 0; j < change_count && reader.ok(); ++j) {
+			Change* change = new Change();
+			change->type = static_cast<ChangeType>(reader.get<uint8_t>());
+			switch (change->type) {
+				case CHANGE_TILE:
+					change->data = reader.getTile();
+					break;
+				case CHANGE_TILE_DELTA: {
+					TileDelta* delta = new TileDelta();
+					delta->tile = reader.getTile();
+					delta->shared_hash = reader.get<uint32_t>();
+					delta->full_size = reader.get<uint32_t>();
+					delta->shared_front = reader.get<uint16_t>();
+					delta->shared_back = reader.get<uint16_t>();
+					delta->shared_ground = reader.get<uint8_t>() != 0;
+					change->data = delta;
+					break;
+				}
+				case CHANGE_MOVE_HOUSE_EXIT: {
+					const uint32_t id = reader.get<uint32_t>();
+					change->data = new HouseData { id, reader.getPosition() };
+					break;
+				}
+				case CHANGE_MOVE_WAYPOINT: {
+					std::string id = reader.getString();
+					change->data = new WaypointData { std::move(id), reader.getPosition() };
+					break;
+				}
+				case CHANGE_SELECTION: {
+					SelectionData* data = new SelectionData { reader.getPosition(), {} };
+					const uint32_t count = reader.get<uint32_t>();
+					for (uint32_t k = 0; k < count && reader.ok(); ++k) {
+						data->state.push_back(reader.get<uint8_t>() != 0);
+					}
+					change->data = data;
+					break;
+				}
+				default:
+					break;
+			}
+			if (!change->data) {
+				change->type = CHANGE_NONE;
+			}
+			action->changes.push_back(change);
+		}
+		action->measureChanges();
+	}
+
+	if (!reader.ok() || !reader.finished()) {
+		spdlog::error("[UndoSpillFile::restore] - Undo history in {} does not match this version", path.string());
+		for (Action* action : actions) {
+			delete action;
+		}
+		return false;
+	}
+
+	batch.batch = std::move(actions);
+	batch.spill_record.reset();
+	release(record);
+
+	++stats.restored;
+	stats.restored_bytes += record.raw_size;
+	stats.restore_seconds += secondsSince(start);
+	return true;
+}
+
+void UndoSpillFile::release(const UndoSpillRecord &record) {
+	if (stats.records > 0) {
+		--stats.records;
+	}
+	if (stats.records == 0) {
+		close();
+		return;
+	}
+
+	stats.live_bytes -= std::min<uint64_t>(stats.live_bytes, record.stored_size);
+	reclaim(record.offset, record.stored_size);
+}
+
+void UndoSpillFile::reclaim(uint64_t offset, uint64_t size) {
+	// Merge the range with its free neighbours so later spills of any size can reuse it
+	auto next = free_ranges.lower_bound(offset);
+	if (next != free_ranges.end() && offset + size == next->first) {
+		size += next->second;
+		next = free_ranges.erase(next);
+	}
+	if (next != free_ranges.begin()) {
+		const auto previous = std::prev(next);
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			free_ranges.erase(previous);
+		}
+	}
+
+	// A free range at the tail just moves the end of the file back
+	if (offset + size == end) {
+		end = offset;
+	} else {
+		free_ranges.emplace(offset, size);
+	}
+	stats.file_size = end;
+}
+
+void UndoSpillFile::clear() {
+	close();
+}
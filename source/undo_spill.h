@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_UNDO_SPILL_H_
+#define RME_UNDO_SPILL_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+class BatchAction;
+class ActionQueue;
+
+// Where the actions of a spilled batch live in the spill file
+struct UndoSpillRecord {
+	uint64_t offset = 0;
+	uint32_t stored_size = 0; // compressed
+	uint32_t raw_size = 0;
+	uint32_t checksum = 0; // crc32 of the stored bytes
+	uint32_t changes = 0;
+};
+
+struct UndoSpillStats {
+	size_t spilled = 0;
+	size_t restored = 0;
+	uint64_t spilled_bytes = 0; // serialized, before compression
+	uint64_t stored_bytes = 0; // written to the file
+	uint64_t restored_bytes = 0; // serialized, after decompression
+	double spill_seconds = 0.0;
+	double restore_seconds = 0.0;
+	size_t records = 0; // batches currently on disk
+	uint64_t live_bytes = 0; // held by those batches
+	uint64_t file_size = 0;
+};
+
+// Temporary file holding undo batches that fell out of the undo memory
+// budget. A spilled batch keeps its type and label in memory; its actions
+// are serialized to a compact binary form, deflated and appended to the
+// file, and read back when the history reaches them again. Space of
+// released records is kept in a free list and reused by later spills.
+class UndoSpillFile {
+public:
+	UndoSpillFile() = default;
+	~UndoSpillFile();
+
+	UndoSpillFile(const UndoSpillFile &) = delete;
+	UndoSpillFile &operator=(const UndoSpillFile &) = delete;
+
+	// Moves the actions of the batch to disk; the batch keeps only its record
+	bool spill(BatchAction &batch);
+	// Brings the actions of a spilled batch back, creating them through the queue
+	bool restore(BatchAction &batch, const ActionQueue &queue);
+	// Forgets the record of a spilled batch that is being deleted
+	void release(const UndoSpillRecord &record);
+	void clear();
+
+	const UndoSpillStats &getStats() const noexcept {
+		return stats;
+	}
+
+private:
+	bool open();
+	void close();
+	uint64_t allocate(uint32_t size);
+	void reclaim(uint64_t offset, uint64_t size);
+
+	// Unused ranges below end, offset -> size, never adjacent to each other
+	std::map<uint64_t, uint64_t> free_ranges;
+
+	std::filesystem::path path;
+	std::fstream file;
+	uint64_t end = 0;
+	UndoSpillStats stats;
+};
+
+#endif
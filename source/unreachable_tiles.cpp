@@ -0,0 +1,203 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+#include "unreachable_tiles.h"
+
+#include "basemap.h"
+#include "parallel_for.h"
+#include "settings.h"
+#include "tile.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+	// Blocks decided by one worker in one go
+	constexpr size_t ReachChunkSize = 64;
+	// Tiles rasterized between progress reports
+	constexpr uint64_t RasterizeReportInterval = 0x4000;
+}
+
+void UnreachableTiles::getFloorRange(int z, int &start, int &end) noexcept {
+	if (z < 8) {
+		start = 0;
+		end = 9;
+	} else {
+		// underground
+		start = std::max(z - 2, rme::MapGroundLayer);
+		end = std::min(z + 2, rme::MapMaxLayer);
+	}
+}
+
+bool UnreachableTiles::isUnreachable(BaseMap &map, const Position &position) {
+	const int sx = std::max(position.x - RangeX, 0);
+	const int ex = std::min(position.x + RangeX, 65535);
+	const int sy = std::max(position.y - RangeY, 0);
+	const int ey = std::min(position.y + RangeY, 65535);
+	int sz, ez;
+	getFloorRange(position.z, sz, ez);
+
+	for (int z = sz; z <= ez; ++z) {
+		for (int y = sy; y <= ey; ++y) {
+			for (int x = sx; x <= ex; ++x) {
+				const Tile* tile = map.getTile(x, y, z);
+				if (tile && !tile->isBlocking()) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void UnreachableTiles::rasterize(BaseMap &map) {
+	blocks.clear();
+	const uint64_t total = std::max<uint64_t>(map.getTileCount(), 1);
+	uint64_t done = 0;
+	for (MapIterator it = map.begin(), end = map.end(); it != end; ++it) {
+		if (++done % RasterizeReportInterval == 0) {
+			if (stop) {
+				return;
+			}
+			progress = static_cast<uint32_t>(std::min(done, total) * (ProgressScale / 2) / total);
+		}
+
+		const Tile* tile = (*it)->get();
+		if (!tile) {
+			continue;
+		}
+
+		const Position &position = tile->getPosition();
+		Block &block = blocks[getKey(position.x >> BlockBits, position.y >> BlockBits, position.z)];
+		const uint64_t bit = uint64_t(1) << (position.x & (BlockSize - 1));
+		block.tiles[position.y & (BlockSize - 1)] |= bit;
+		if (!tile->isBlocking()) {
+			block.walkable[position.y & (BlockSize - 1)] |= bit;
+		}
+	}
+}
+
+void UnreachableTiles::getReach(int bx, int by, int z, Rows &reach) const {
+	int sz, ez;
+	getFloorRange(z, sz, ez);
+
+	// Walkable tiles of the floors in view, for the block and the eight around it
+	std::array<std::array<Rows, 3>, 3> around {};
+	for (int dy = -1; dy <= 1; ++dy) {
+		for (int dx = -1; dx <= 1; ++dx) {
+			const int nx = bx + dx;
+			const int ny = by + dy;
+			if (nx < 0 || ny < 0 || nx >= BlocksPerAxis || ny >= BlocksPerAxis) {
+				continue;
+			}
+
+			Rows &rows = around[dy + 1][dx + 1];
+			for (int floor = sz; floor <= ez; ++floor) {
+				const auto it = blocks.find(getKey(nx, ny, floor));
+				if (it == blocks.end()) {
+					continue;
+				}
+				for (int row = 0; row < BlockSize; ++row) {
+					rows[row] |= it->second.walkable[row];
+				}
+			}
+		}
+	}
+
+	// First pass: widen each row by RangeX, taking in the blocks to the left and right
+	std::array<uint64_t, BlockSize + 2 * RangeY> widened {};
+	for (int i = 0; i < BlockSize + 2 * RangeY; ++i) {
+		const int row = i - RangeY;
+		const int side = row < 0 ? 0 : (row < BlockSize ? 1 : 2);
+		const int local = (row + BlockSize) % BlockSize;
+		const uint64_t left = around[side][0][local];
+		const uint64_t center = around[side][1][local];
+		const uint64_t right = around[side][2][local];
+
+		uint64_t bits = center;
+		for (int d = 1; d <= RangeX; ++d) {
+			bits |= (center << d) | (left >> (BlockSize - d));
+			bits |= (center >> d) | (right << (BlockSize - d));
+		}
+		widened[i] = bits;
+	}
+
+	// Second pass: widen the result by RangeY across the rows
+	for (int row = 0; row < BlockSize; ++row) {
+		uint64_t bits = 0;
+		for (int i = row; i <= row + 2 * RangeY; ++i) {
+			bits |= widened[i];
+		}
+		reach[row] = bits;
+	}
+}
+
+std::vector<Position> UnreachableTiles::find(BaseMap &map) {
+	progress = 0;
+	rasterize(map);
+	if (stop) {
+		return {};
+	}
+	progress = ProgressScale / 2;
+
+	std::vector<uint32_t> keys;
+	keys.reserve(blocks.size());
+	for (const auto &[key, block] : blocks) {
+		keys.push_back(key);
+	}
+
+	const size_t chunks = (keys.size() + ReachChunkSize - 1) / ReachChunkSize;
+	std::vector<std::vector<Position>> found(chunks);
+	std::atomic<size_t> finished = 0;
+	const unsigned int threads = static_cast<unsigned int>(std::max(g_settings.getInteger(Config::WORKER_THREADS), 1));
+	rme::parallelFor(chunks, threads, [&](size_t chunk) {
+		if (stop) {
+			return;
+		}
+
+		Rows reach;
+		const size_t end = std::min(keys.size(), (chunk + 1) * ReachChunkSize);
+		for (size_t i = chunk * ReachChunkSize; i < end; ++i) {
+			const uint32_t key = keys[i];
+			const int bx = key & (BlocksPerAxis - 1);
+			const int by = (key >> 10) & (BlocksPerAxis - 1);
+			const int z = key >> 20;
+			getReach(bx, by, z, reach);
+
+			const Block &block = blocks.at(key);
+			for (int row = 0; row < BlockSize; ++row) {
+				for (uint64_t bits = block.tiles[row] & ~reach[row]; bits != 0; bits &= bits - 1) {
+					const int column = std::countr_zero(bits);
+					found[chunk].emplace_back((bx << BlockBits) + column, (by << BlockBits) + row, z);
+				}
+			}
+		}
+		progress = static_cast<uint32_t>(ProgressScale / 2 + (++finished) * (ProgressScale / 2) / chunks);
+	});
+
+	if (stop) {
+		return {};
+	}
+
+	std::vector<Position> positions;
+	for (const std::vector<Position> &part : found) {
+		positions.insert(positions.end(), part.begin(), part.end());
+	}
+	std::sort(positions.begin(), positions.end());
+	return positions;
+}
@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_UNREACHABLE_TILES_H_
+#define RME_UNREACHABLE_TILES_H_
+
+#include "position.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class BaseMap;
+
+// Finds the tiles that no player could get close enough to see: those with
+// no walkable tile within RangeX by RangeY of them on the floors in view.
+// Surface tiles look at floors 0-9, underground tiles at two floors above
+// and below, down to the ground floor.
+//
+// The map is rasterized in blocks of 64x64 tiles, one bit per tile, marking
+// which tiles exist and which are walkable. For each block the walkable
+// masks of the floors in view are merged, widened by RangeX along the rows
+// and then by RangeY across them; the tiles left outside the widened mask
+// are the unreachable ones. This gives the same answer as checking the
+// neighbourhood of each tile, without a tile lookup per neighbour.
+class UnreachableTiles {
+public:
+	static constexpr int RangeX = 10;
+	static constexpr int RangeY = 8;
+
+	// Floors whose walkable tiles make a tile on floor z reachable
+	static void getFloorRange(int z, int &start, int &end) noexcept;
+	// Checks a single tile by looking up its whole neighbourhood
+	static bool isUnreachable(BaseMap &map, const Position &position);
+
+	// Returns the positions of the unreachable tiles, sorted; none once stopped
+	std::vector<Position> find(BaseMap &map);
+
+	// For another thread to follow a running find and stop it. The progress
+	// runs up to ProgressScale, the first half over the rasterizing and the
+	// second over the blocks checked.
+	static constexpr uint32_t ProgressScale = 1000;
+	std::atomic<uint32_t> progress = 0;
+	std::atomic<bool> stop = false;
+
+private:
+	static constexpr int BlockBits = 6;
+	static constexpr int BlockSize = 1 << BlockBits;
+	static constexpr int BlocksPerAxis = 0x10000 >> BlockBits;
+
+	using Rows = std::array<uint64_t, BlockSize>; // bit x of row y stands for the tile at x, y
+
+	struct Block {
+		Rows tiles {};
+		Rows walkable {};
+	};
+
+	static uint32_t getKey(int bx, int by, int z) noexcept {
+		return (static_cast<uint32_t>(z) << 20) | (static_cast<uint32_t>(by) << 10) | static_cast<uint32_t>(bx);
+	}
+
+	void rasterize(BaseMap &map);
+	// Marks the tiles of the block that have a walkable tile in range
+	void getReach(int bx, int by, int z, Rows &reach) const;
+
+	std::unordered_map<uint32_t, Block> blocks;
+};
+
+#endif